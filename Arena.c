@@ -0,0 +1,133 @@
+/**
+ * @file Arena.c
+ * Allocateur par région. Les blocs ne sont jamais rendus au système par
+ * @ref arenaReset : une fois la première zone chargée, les chargements
+ * suivants ne font plus d'allocation tant qu'ils tiennent dans les blocs
+ * existants.
+ */
+#include "Arena.h"
+#include "Metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/// Alignement des allocations
+#define ARENA_ALIGN 16
+
+/// Taille de l'en-tête d'un bloc, arrondie à l'alignement
+#define BLOCK_HEADER ( ( sizeof( ArenaBlock ) + ARENA_ALIGN - 1 ) & ~( size_t )( ARENA_ALIGN - 1 ) )
+/// Début des données d'un bloc
+#define BLOCK_DATA( block ) ( ( char* )( block ) + BLOCK_HEADER )
+
+/**
+ * `newBlock` alloue un bloc pouvant contenir au moins `size` octets.
+ */
+static ArenaBlock* newBlock( Arena* arena, size_t size )
+{
+	if( size < ARENA_BLOCK_SIZE )
+		size = ARENA_BLOCK_SIZE;
+
+	ArenaBlock* block = malloc( BLOCK_HEADER + size );
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+
+	arena->nb_blocks++;
+	metricAdd( METRIC_HEAP_ALLOCS, 1 );
+	metricAdd( METRIC_ARENA_BLOCKS, 1 );
+	return block;
+}
+
+/**
+ * `arenaAlloc` réserve `size` octets alignés dans l'arène. Les blocs
+ * suivant le bloc courant, conservés par un @ref arenaReset, sont réutilisés
+ * avant d'en allouer un nouveau.
+ * @param arena L'arène
+ * @param size La taille demandée
+ * @return La zone allouée, remplie de zéros
+ */
+void* arenaAlloc( Arena* arena, size_t size )
+{
+	size = ( size + ARENA_ALIGN - 1 ) & ~( size_t )( ARENA_ALIGN - 1 );
+
+	if( !arena->current )
+		arena->first = arena->current = newBlock( arena, size );
+
+	while( arena->current->used + size > arena->current->size )
+	{
+		ArenaBlock* next = arena->current->next;
+		if( !next || next->size < size )
+		{
+			/* bloc inséré après le bloc courant, la suite reste disponible */
+			ArenaBlock* block = newBlock( arena, size );
+			block->next = next;
+			arena->current->next = block;
+			next = block;
+		}
+
+		next->used = 0;
+		arena->current = next;
+	}
+
+	void* p = BLOCK_DATA( arena->current ) + arena->current->used;
+	arena->current->used += size;
+
+	memset( p, 0, size );
+	return p;
+}
+
+/**
+ * `arenaGrow` garantit qu'un tableau de `count` éléments alloué dans l'arène
+ * peut en recevoir un de plus. S'il est plein, un tableau deux fois plus
+ * grand est alloué et les éléments y sont copiés ; l'ancien reste dans
+ * l'arène jusqu'au prochain @ref arenaReset.
+ * @param arena L'arène
+ * @param array Le tableau, éventuellement NULL
+ * @param count Le nombre d'éléments du tableau
+ * @param[in,out] capacity La capacité du tableau
+ * @param size La taille d'un élément
+ * @return Le tableau, déplacé si nécessaire
+ */
+void* arenaGrow( Arena* arena, void* array, int count, int* capacity, size_t size )
+{
+	if( count < *capacity )
+		return array;
+
+	int cap = *capacity ? *capacity * 2 : 8;
+	void* p = arenaAlloc( arena, size * cap );
+	if( count )
+		memcpy( p, array, size * count );
+
+	*capacity = cap;
+	return p;
+}
+
+/**
+ * `arenaReset` libère en temps constant toutes les allocations de l'arène.
+ * Les blocs sont conservés pour les allocations suivantes.
+ * @param arena L'arène
+ */
+void arenaReset( Arena* arena )
+{
+	arena->current = arena->first;
+	if( arena->current )
+		arena->current->used = 0;
+}
+
+/**
+ * `arenaFree` rend tous les blocs de l'arène au système.
+ * @param arena L'arène
+ */
+void arenaFree( Arena* arena )
+{
+	ArenaBlock* block = arena->first;
+	while( block )
+	{
+		ArenaBlock* next = block->next;
+		free( block );
+		block = next;
+	}
+	metricAdd( METRIC_ARENA_BLOCKS, -arena->nb_blocks );
+
+	memset( arena, 0, sizeof( *arena ) );
+}
@@ -0,0 +1,45 @@
+/**
+ * @file Arena.h
+ * @brief Allocateur par région : les allocations sont prises à la suite
+ * dans de grands blocs et libérées toutes ensemble.
+ */
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/// Taille par défaut d'un bloc de l'arène
+#define ARENA_BLOCK_SIZE ( 64 * 1024 )
+
+/**
+ * @struct ArenaBlock
+ * @brief Bloc mémoire d'une arène
+ */
+typedef struct ArenaBlock
+{
+	struct ArenaBlock* next; ///< Bloc suivant
+	size_t size; ///< Taille de la zone de données
+	size_t used; ///< Nombre d'octets utilisés
+} ArenaBlock;
+
+/**
+ * @struct Arena
+ * @brief Arène : chaîne de blocs réutilisés après chaque @ref arenaReset
+ */
+typedef struct
+{
+	ArenaBlock* first; ///< Premier bloc
+	ArenaBlock* current; ///< Bloc dans lequel sont faites les allocations
+	int nb_blocks; ///< Nombre de blocs alloués auprès du système
+} Arena;
+
+/// @brief Alloue une zone mémoire initialisée à zéro dans l'arène
+void* arenaAlloc( Arena* arena, size_t size );
+/// @brief Agrandit un tableau alloué dans l'arène s'il est plein
+void* arenaGrow( Arena* arena, void* array, int count, int* capacity, size_t size );
+/// @brief Libère d'un coup toutes les allocations de l'arène
+void arenaReset( Arena* arena );
+/// @brief Rend les blocs de l'arène au système
+void arenaFree( Arena* arena );
+
+#endif
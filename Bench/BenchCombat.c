@@ -0,0 +1,187 @@
+/**
+ * @file BenchCombat.c
+ * Mesure du noyau de combat (@ref combatEvaluate) sur tous les duels entre
+ * chaque arme et chaque armure de `Data/equipement.txt` et chaque NPC de
+ * `Data/<type>.txt`, pour tous les points de vie du joueur. Vérifie que le
+ * noyau donne exactement les résultats de @ref combatDuel, et que ceux-ci
+ * sont ceux d'une vraie partie où le joueur attaque à chaque tour.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Combat.h"
+#include "Gameplay.h"
+
+/// Plus grand type de NPC recherché
+#define MAX_NPC_TYPE 1100
+/// Nombre d'évaluations du lot complet
+#define NB_ROUNDS 200
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Rejoue le duel dans une vraie partie en attaquant à chaque tour.
+ * @return 1 si le résultat est celui attendu, 0 s'il diffère, -1 si le NPC
+ * s'est rendu (le duel n'est alors plus comparable)
+ */
+static int playDuel( Gameplay_s* game, int atk, int def, int life, const npc_stats* npc, int hostile, const CombatResult* expected )
+{
+	npc_stats fighter = *npc;
+	int turns = 0, outcome, ok;
+
+	fighter.status = hostile ? 1 : 0;
+	game->player_atk = atk;
+	game->player_def = def;
+	game->player_current_life = life;
+	game->state = STATE_INTERACTION;
+	game->npcs = &fighter;
+	game->nb_npc = 1;
+	game->index_current_npc = 0;
+
+	while( turns < COMBAT_MAX_TURNS && game->state == STATE_INTERACTION
+		&& fighter.life > 0 && game->player_current_life > 0 )
+	{
+		processAction( game, ACTION_ATTACK );
+		turns++;
+		if( fighter.status == 0 )
+			break;
+	}
+
+	game->npcs = NULL;
+	game->nb_npc = 0;
+
+	if( fighter.status == 0 )
+		return -1;
+
+	if( fighter.life <= 0 )
+		outcome = game->player_current_life <= 0 ? COMBAT_TRADE : COMBAT_WIN;
+	else
+		outcome = game->player_current_life <= 0 ? COMBAT_LOSS : COMBAT_STALEMATE;
+
+	ok = turns == expected->turns && outcome == expected->outcome
+		&& game->player_current_life == expected->life_left;
+	return ok;
+}
+
+int main()
+{
+	int weapons[ 16 ], armors[ 16 ], nb_weapons = 1, nb_armors = 1;
+	npc_stats npcs[ 64 ];
+	char name[ NPC_NAME_SIZE ];
+	int nb_npcs = 0, i, j, k, life, hostile, round;
+
+	preloadGameData();
+	Gameplay_s* game = createGameplay();
+	seedGameplay( game, 42, 0 );
+	initGameplay( game );
+
+	/* statistiques de base : celles du début de partie sans l'équipement porté */
+	int base_atk = game->player_atk - getItemFromID( game->stuff[ 0 ] )->value_stat;
+	int base_def = game->player_def - getItemFromID( game->stuff[ 1 ] )->value_stat;
+	int max_life = game->player_max_life;
+
+	/* la première arme et la première armure sont « aucune » */
+	weapons[ 0 ] = armors[ 0 ] = 0;
+	for( i = 0; i < NbItems; i++ )
+	{
+		if( Items[ i ].stat == STAT_ATK && nb_weapons < 16 )
+			weapons[ nb_weapons++ ] = Items[ i ].value_stat;
+		if( Items[ i ].stat == STAT_DEF && nb_armors < 16 )
+			armors[ nb_armors++ ] = Items[ i ].value_stat;
+	}
+
+	for( i = 0; i < MAX_NPC_TYPE && nb_npcs < 64; i++ )
+		if( encounterInit( i, &npcs[ nb_npcs ], name ) == 0 )
+			nb_npcs++;
+
+	CombatBatch batch;
+	int count = nb_weapons * nb_armors * nb_npcs * max_life * 2;
+	if( combatBatchInit( &batch, count ) != 0 )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+
+	for( i = 0; i < nb_weapons; i++ )
+		for( j = 0; j < nb_armors; j++ )
+			for( k = 0; k < nb_npcs; k++ )
+				for( life = 1; life <= max_life; life++ )
+					for( hostile = 0; hostile < 2; hostile++ )
+						combatBatchAdd( &batch, base_atk + weapons[ i ], base_def + armors[ j ], life,
+							npcs[ k ].ata, npcs[ k ].def, npcs[ k ].life, hostile );
+
+	printf( "%d weapons x %d armors x %d npcs x %d lives x 2 = %d duels\n",
+		nb_weapons, nb_armors, nb_npcs, max_life, batch.count );
+
+	/* noyau par lots */
+	double t = now();
+	for( round = 0; round < NB_ROUNDS; round++ )
+		combatEvaluate( &batch );
+	double t_batch = now() - t;
+
+	/* duels simulés un par un */
+	CombatResult* scalar = malloc( sizeof( CombatResult ) * batch.count );
+	t = now();
+	for( i = 0; i < batch.count; i++ )
+		combatDuel( batch.player_atk[ i ], batch.player_def[ i ], batch.player_life[ i ],
+			batch.npc_ata[ i ], batch.npc_def[ i ], batch.npc_life[ i ], batch.hostile[ i ], &scalar[ i ] );
+	double t_scalar = now() - t;
+
+	long mismatches = 0, wins = 0, surrenders = 0;
+	double surrender_sum = 0;
+	for( i = 0; i < batch.count; i++ )
+	{
+		CombatResult r;
+		combatBatchResult( &batch, i, &r );
+		if( memcmp( &r, &scalar[ i ], sizeof( r ) ) != 0 )
+		{
+			if( mismatches < 10 )
+				fprintf( stderr, "mismatch on duel %d\n", i );
+			mismatches++;
+		}
+		wins += r.outcome == COMBAT_WIN;
+		surrenders += r.rolls > 0;
+		surrender_sum += r.surrender;
+	}
+
+	/* comparaison avec le jeu, sur un duel sur 7 hors duels sans fin */
+	long played = 0, diverged = 0, surrendered = 0;
+	for( i = 0; i < batch.count; i += 7 )
+	{
+		if( scalar[ i ].outcome == COMBAT_STALEMATE )
+			continue;
+
+		int n = ( i / ( 2 * max_life ) ) % nb_npcs;
+		int ok = playDuel( game, batch.player_atk[ i ], batch.player_def[ i ], batch.player_life[ i ],
+			&npcs[ n ], batch.hostile[ i ], &scalar[ i ] );
+		if( ok < 0 )
+			surrendered++;
+		else
+		{
+			played++;
+			diverged += !ok;
+		}
+	}
+
+	printf( "batch  %8.2f Mduels/s\n", ( double )batch.count * NB_ROUNDS / t_batch * 1e-6 );
+	printf( "scalar %8.2f Mduels/s\n", batch.count / t_scalar * 1e-6 );
+	printf( "wins %ld, duels with a surrender chance %ld, mean surrender chance %.4f\n",
+		wins, surrenders, surrender_sum / batch.count );
+	printf( "batch/scalar mismatches : %ld\n", mismatches );
+	printf( "game replays : %ld played, %ld diverged, %ld surrendered\n", played, diverged, surrendered );
+
+	free( scalar );
+	combatBatchFree( &batch );
+	destroyGameplay( game );
+	closeGameData();
+	return mismatches || diverged;
+}
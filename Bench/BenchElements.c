@@ -0,0 +1,158 @@
+/**
+ * @file BenchElements.c
+ * Mesure du parcours des éléments d'une zone selon leur disposition en
+ * mémoire : tableau de structures @ref Element (environ 70 octets par
+ * élément) contre tableaux parallèles de @ref ElementTable, pour le test de
+ * clic linéaire et pour la sélection des éléments visibles (@ref
+ * cullElements), avec 1 000, 10 000 et 100 000 éléments. Chaque mesure est
+ * refaite @ref NB_RUNS fois et la meilleure est gardée.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Gameplay.h"
+
+/// Nombre de clics simulés par mesure
+#define NB_QUERIES 2000
+/// Nombre de sélections des éléments visibles par mesure
+#define NB_CULLS 200
+/// Nombre de mesures de chaque disposition, la meilleure est gardée
+#define NB_RUNS 5
+
+/// Partie simulée
+static Gameplay_s Game;
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// Test de clic sur la disposition en tableau de structures
+static int pickAos( const Element* elems, int n, int x, int y )
+{
+	int i;
+	for( i = n - 1; i >= 0; i-- )
+	{
+		const Rect* r = &elems[ i ].rect;
+		if( x >= r->x && x <= r->x + r->w && y >= r->y && y <= r->y + r->h )
+			return i;
+	}
+	return -1;
+}
+
+/// Test de clic sur la disposition en tableaux parallèles
+static int pickSoa( const Rect* rects, int n, int x, int y )
+{
+	int i;
+	for( i = n - 1; i >= 0; i-- )
+	{
+		const Rect* r = &rects[ i ];
+		if( x >= r->x && x <= r->x + r->w && y >= r->y && y <= r->y + r->h )
+			return i;
+	}
+	return -1;
+}
+
+/// Sélection des éléments visibles sur la disposition en tableau de structures
+static int cullAos( const Element* elems, int n, Rect view, int* visible )
+{
+	int i, m = 0;
+	for( i = 0; i < n; i++ )
+	{
+		const Rect* r = &elems[ i ].rect;
+		visible[ m ] = i;
+		m += ( r->x < view.x + view.w ) & ( r->x + r->w > view.x )
+			& ( r->y < view.y + view.h ) & ( r->y + r->h > view.y );
+	}
+	return m;
+}
+
+/// Mesure les deux dispositions pour `n` éléments
+static void measure( int n )
+{
+	int i;
+	Element* aos = malloc( sizeof( Element ) * n );
+	ElementTable* t = &Game.elements;
+
+	t->count = t->capacity = n;
+	t->rects = malloc( sizeof( Rect ) * n );
+	t->types = malloc( sizeof( int ) * n );
+	t->visible = malloc( sizeof( int ) * n );
+	int* visible = malloc( sizeof( int ) * n );
+
+	/* zone plus grande que l'écran : une partie des éléments est hors de la vue */
+	for( i = 0; i < n; i++ )
+	{
+		Rect r;
+		r.w = 16 + rand() % 48;
+		r.h = 16 + rand() % 48;
+		r.x = rand() % 3200 - 1200;
+		r.y = rand() % 2400 - 900;
+
+		aos[ i ].type = t->types[ i ] = 1;
+		aos[ i ].rect = t->rects[ i ] = r;
+	}
+
+	Rect view = { 0, 0, 800, 600 };
+	long sum_aos = 0, sum_soa = 0;
+	double t_pick_aos = 1e9, t_pick_soa = 1e9, t_cull_aos = 1e9, t_cull_soa = 1e9;
+	int run;
+
+	for( run = 0; run < NB_RUNS; run++ )
+	{
+		srand( n );
+		double t0 = now();
+		for( i = 0; i < NB_QUERIES; i++ )
+			sum_aos += pickAos( aos, n, rand() % 800, rand() % 600 );
+		t_pick_aos = fmin( t_pick_aos, now() - t0 );
+
+		srand( n );
+		t0 = now();
+		for( i = 0; i < NB_QUERIES; i++ )
+			sum_soa += pickSoa( t->rects, n, rand() % 800, rand() % 600 );
+		t_pick_soa = fmin( t_pick_soa, now() - t0 );
+
+		t0 = now();
+		for( i = 0; i < NB_CULLS; i++ )
+			sum_aos += cullAos( aos, n, view, visible );
+		t_cull_aos = fmin( t_cull_aos, now() - t0 );
+
+		t0 = now();
+		for( i = 0; i < NB_CULLS; i++ )
+			sum_soa += cullElements( &Game, view );
+		t_cull_soa = fmin( t_cull_soa, now() - t0 );
+	}
+
+	printf( "%7d elements  pick  AoS %8.2f us  SoA %8.2f us  x%.2f\n",
+		n, t_pick_aos * 1e6 / NB_QUERIES, t_pick_soa * 1e6 / NB_QUERIES, t_pick_aos / t_pick_soa );
+	printf( "%7d elements  cull  AoS %8.2f us  SoA %8.2f us  x%.2f%s\n",
+		n, t_cull_aos * 1e6 / NB_CULLS, t_cull_soa * 1e6 / NB_CULLS, t_cull_aos / t_cull_soa,
+		sum_aos == sum_soa ? "" : "  MISMATCH" );
+
+	free( aos );
+	free( visible );
+	free( t->rects );
+	free( t->types );
+	free( t->visible );
+}
+
+int main( int argc, char* argv[] )
+{
+	( void )argc;
+	( void )argv;
+
+	printf( "sizeof(Element) = %zu, sizeof(Rect) = %zu\n", sizeof( Element ), sizeof( Rect ) );
+
+	srand( 42 );
+	measure( 1000 );
+	measure( 10000 );
+	measure( 100000 );
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file BenchEnv.c
+ * Mesure du nombre de pas par seconde des environnements d'apprentissage
+ * (@ref envStep) pour des lots de 1, 16, 64 et 256 parties pilotées par des
+ * actions possibles tirées au hasard (@ref envLegalActions).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Env.h"
+
+/// Nombre de pas par environnement et par mesure
+#define NB_STEPS 20000
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// Mesure un lot de `count` environnements
+static void run( int count )
+{
+	EnvBatch* batch = envCreate( count, 42 );
+	EnvObservation* obs = malloc( sizeof( EnvObservation ) * count );
+	int32_t* actions = malloc( sizeof( int32_t ) * count );
+	uint8_t* mask = malloc( ( size_t )count * ENV_NB_ACTIONS );
+	Rng rng;
+	long episodes = 0, invalid = 0;
+	double t_step = 0, t_mask = 0;
+	int step, i, a;
+
+	rngSeed( &rng, 1, count );
+	envReset( batch, obs );
+
+	for( step = 0; step < NB_STEPS; step++ )
+	{
+		double t = now();
+		envLegalActions( batch, mask );
+		t_mask += now() - t;
+
+		for( i = 0; i < count; i++ )
+		{
+			const uint8_t* m = mask + ( size_t )i * ENV_NB_ACTIONS;
+			int legal[ ENV_NB_ACTIONS ], n = 0;
+			for( a = 0; a < ENV_NB_ACTIONS; a++ )
+				if( m[ a ] )
+					legal[ n++ ] = a;
+			actions[ i ] = n ? legal[ rngBelow( &rng, n ) ] : ENV_START;
+		}
+
+		t = now();
+		envStep( batch, actions, obs );
+		t_step += now() - t;
+
+		for( i = 0; i < count; i++ )
+		{
+			episodes += obs[ i ].done;
+			invalid += obs[ i ].invalid;
+		}
+	}
+
+	long steps = ( long )NB_STEPS * count;
+	printf( "%4d envs : %9.0f steps/s (%.3f us/step), mask %.3f us/env, %ld episodes, %ld invalid\n",
+		count, steps / t_step, t_step / steps * 1e6, t_mask / steps * 1e6, episodes, invalid );
+
+	free( mask );
+	free( actions );
+	free( obs );
+	envDestroy( batch );
+}
+
+int main()
+{
+	run( 1 );
+	run( 16 );
+	run( 64 );
+	run( 256 );
+	closeGameData();
+	return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file BenchLog.c
+ * Mesure du coût d'un message du journal (@ref logWrite) écrit depuis
+ * plusieurs threads, comparé à un `fprintf` sur un fichier partagé, qui
+ * sérialise les threads sur le verrou du fichier. Un flot continu de messages
+ * remplit les tampons, qui perdent alors presque tous les messages : les
+ * rafales, entre lesquelles les tampons sont vidés, mesurent le coût d'un
+ * message réellement écrit.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Log.h"
+
+/// Nombre de messages écrits par thread
+#define NB_MESSAGES 200000
+/// Nombre maximal de threads
+#define MAX_THREADS 8
+/// Nombre de messages d'une rafale, moins que la taille d'un tampon
+#define BURST_SIZE 100
+/// Nombre de rafales par thread
+#define NB_BURSTS 50
+
+/// Manières d'écrire un message
+enum { WRITE_STDIO, WRITE_LOG, WRITE_REPEATED, WRITE_BURST };
+
+static FILE* Sink; ///< Fichier partagé par `fprintf`
+static int Mode; ///< Manière d'écrire des threads
+static double BurstTime[ MAX_THREADS ]; ///< Temps passé dans les rafales par thread
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// Écrit `NB_MESSAGES` messages
+static void* writer( void* arg )
+{
+	long id = ( long )arg;
+	int i, b;
+
+	if( Mode == WRITE_BURST )
+	{
+		BurstTime[ id ] = 0;
+		for( b = 0; b < NB_BURSTS; b++ )
+		{
+			double t = now();
+			for( i = 0; i < BURST_SIZE; i++ )
+			{
+				LogSite site = { __FILE__, __LINE__, 0, 0, 0 };
+				logWrite( &site, LOG_INFO, "thread %ld burst %d message %d", id, b, i );
+			}
+			BurstTime[ id ] += now() - t;
+			logFlush();
+		}
+		return NULL;
+	}
+
+	for( i = 0; i < NB_MESSAGES; i++ )
+	{
+		if( Mode == WRITE_STDIO )
+			fprintf( Sink, "[I] BenchLog.c:%d: thread %ld message %d\n", __LINE__, id, i );
+		else if( Mode == WRITE_LOG )
+		{
+			/* un appel différent à chaque message : pas de limitation */
+			LogSite site = { __FILE__, __LINE__, 0, 0, 0 };
+			logWrite( &site, LOG_INFO, "thread %ld message %d", id, i );
+		}
+		else
+			logInfo( "thread %ld message %d", id, i );
+	}
+	return NULL;
+}
+
+/// Lance `threads` threads et renvoie le temps moyen d'un message en ns
+static double run( int threads )
+{
+	pthread_t tids[ MAX_THREADS ];
+	long i;
+
+	double t = now();
+	for( i = 0; i < threads; i++ )
+		pthread_create( &tids[ i ], NULL, writer, ( void* )i );
+	for( i = 0; i < threads; i++ )
+		pthread_join( tids[ i ], NULL );
+	return ( now() - t ) / ( ( double )threads * NB_MESSAGES ) * 1e9;
+}
+
+/// Lance `threads` threads en rafales et renvoie le temps moyen d'un message en ns
+static double runBursts( int threads )
+{
+	double total = 0;
+	int i;
+
+	Mode = WRITE_BURST;
+	run( threads );
+	for( i = 0; i < threads; i++ )
+		total += BurstTime[ i ];
+	return total / ( ( double )threads * NB_BURSTS * BURST_SIZE ) * 1e9;
+}
+
+/// Compte les messages écrits et perdus dans `file`
+static void count( FILE* file, long* written, long* dropped )
+{
+	char line[ 512 ];
+	unsigned n;
+
+	*written = *dropped = 0;
+	rewind( file );
+	while( fgets( line, sizeof( line ), file ) )
+	{
+		if( sscanf( line, "[W] log: %u messages dropped", &n ) == 1 )
+			*dropped += n;
+		else
+			( *written )++;
+	}
+}
+
+int main()
+{
+	static const int counts[] = { 1, 2, 4, 8 };
+	long written, dropped, burst_written, burst_dropped;
+	unsigned c;
+
+	printf( "%-8s %12s %12s %10s %12s %10s %12s\n", "threads", "fprintf ns", "burst ns", "dropped",
+		"flood ns", "dropped", "repeated ns" );
+
+	for( c = 0; c < sizeof( counts ) / sizeof( *counts ); c++ )
+	{
+		int threads = counts[ c ];
+
+		Sink = tmpfile();
+		Mode = WRITE_STDIO;
+		double t_stdio = run( threads );
+		fclose( Sink );
+
+		FILE* out = tmpfile();
+		logInit( out, LOG_INFO );
+		Mode = WRITE_LOG;
+		double t_log = run( threads );
+		Mode = WRITE_REPEATED;
+		double t_repeated = run( threads );
+		logShutdown();
+		count( out, &written, &dropped );
+		fclose( out );
+
+		out = tmpfile();
+		logInit( out, LOG_INFO );
+		double t_burst = runBursts( threads );
+		logShutdown();
+		count( out, &burst_written, &burst_dropped );
+		fclose( out );
+
+		printf( "%-8d %12.1f %12.1f %9.1f%% %12.1f %9.1f%% %12.1f\n", threads, t_stdio,
+			t_burst, 100.0 * burst_dropped / ( burst_written + burst_dropped ),
+			t_log, 100.0 * dropped / ( written + dropped ), t_repeated );
+	}
+	return 0;
+}
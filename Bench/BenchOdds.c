@@ -0,0 +1,173 @@
+/**
+ * @file BenchOdds.c
+ * Mesure de @ref combatOdds sur chaque NPC de `Data/<type>.txt` et chaque
+ * conduite du joueur, avec ses statistiques de début de partie. Compare la
+ * loi calculée à des duels joués au hasard dans une vraie partie.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Combat.h"
+#include "Gameplay.h"
+
+/// Plus grand type de NPC recherché
+#define MAX_NPC_TYPE 1100
+/// Nombre de duels joués par NPC et par conduite
+#define NB_SAMPLES 4000
+/// Nombre d'évaluations mesurées par NPC et par conduite
+#define NB_QUERIES 2000
+/// Valeur offerte par la conduite @ref COMBAT_TACTIC_BRIBE (le gâteau)
+#define OFFER ITEM_CUPCAKE
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Joue un duel dans la partie en suivant `tactic`, comme @ref combatOdds.
+ * @param[out] turns La durée du duel
+ * @return L'issue du duel
+ */
+static int playDuel( Gameplay_s* game, const npc_stats* npc, int tactic, int* turns )
+{
+	npc_stats fighter = *npc;
+	int atk = game->player_atk, def = game->player_def, life = game->player_current_life;
+	int threatened = 0, offered = 0, outcome = COMBAT_STALEMATE, turn;
+
+	game->state = STATE_INTERACTION;
+	game->npcs = &fighter;
+	game->nb_npc = 1;
+	game->index_current_npc = 0;
+
+	for( turn = 1; turn <= COMBAT_MAX_TURNS; turn++ )
+	{
+		int hostile = fighter.status == 1;
+
+		if( hostile && tactic == COMBAT_TACTIC_THREAT && !threatened && fighter.life - game->player_atk <= 0 )
+		{
+			processAction( game, ACTION_TALK_THREAT );
+			threatened = 1;
+			if( fighter.status == 0 )
+			{
+				outcome = COMBAT_SURRENDERED;
+				break;
+			}
+		}
+		else if( hostile && tactic == COMBAT_TACTIC_BRIBE && !offered )
+		{
+			fighter.status = npcResponse( game, &fighter, ITEM, OFFER, game->name );
+			offered = 1;
+			if( fighter.status == 0 )
+			{
+				outcome = COMBAT_BRIBED;
+				break;
+			}
+		}
+		else
+		{
+			processAction( game, ACTION_ATTACK );
+			if( hostile && fighter.status == 0 )
+			{
+				outcome = fighter.life <= 0 ? COMBAT_WIN : COMBAT_SURRENDERED;
+				break;
+			}
+			if( fighter.life <= 0 )
+			{
+				outcome = game->player_current_life <= 0 ? COMBAT_TRADE : COMBAT_WIN;
+				break;
+			}
+		}
+
+		if( game->player_current_life <= 0 )
+		{
+			outcome = COMBAT_LOSS;
+			break;
+		}
+	}
+
+	*turns = turn <= COMBAT_MAX_TURNS ? turn : COMBAT_MAX_TURNS;
+
+	game->npcs = NULL;
+	game->nb_npc = 0;
+	game->player_atk = atk;
+	game->player_def = def;
+	game->player_current_life = life;
+	return outcome;
+}
+
+int main()
+{
+	static const char* tactics[] = { "attack", "threat", "bribe" };
+	npc_stats npcs[ 64 ];
+	char name[ NPC_NAME_SIZE ];
+	int nb_npcs = 0, i, t, q, s, o;
+	double t_odds = 0, max_error = 0, max_z = 0;
+	long queries = 0, impossible = 0;
+
+	preloadGameData();
+	Gameplay_s* game = createGameplay();
+	seedGameplay( game, 42, 0 );
+	initGameplay( game );
+
+	for( i = 0; i < MAX_NPC_TYPE && nb_npcs < 64; i++ )
+		if( encounterInit( i, &npcs[ nb_npcs ], name ) == 0 )
+			nb_npcs++;
+
+	printf( "player atk %d def %d life %d, %d npcs, %d samples per case\n",
+		game->player_atk, game->player_def, game->player_current_life, nb_npcs, NB_SAMPLES );
+	printf( "%-6s %-6s %6s %6s %6s %6s %6s %6s %6s %7s\n", "npc", "tactic", "win", "trade", "loss", "surr", "bribe", "turns", "~turns", "error" );
+
+	for( i = 0; i < nb_npcs; i++ )
+		for( t = 0; t < 3; t++ )
+		{
+			CombatOdds odds;
+			long counts[ COMBAT_NB_OUTCOMES ] = { 0 };
+			double turns = 0, error = 0;
+
+			double start = now();
+			for( q = 0; q < NB_QUERIES; q++ )
+				combatOdds( game->player_atk, game->player_def, game->player_current_life, &npcs[ i ], t, OFFER, &odds );
+			t_odds += now() - start;
+			queries += NB_QUERIES;
+
+			for( s = 0; s < NB_SAMPLES; s++ )
+			{
+				int length;
+				counts[ playDuel( game, &npcs[ i ], t, &length ) ]++;
+				turns += ( double )length / NB_SAMPLES;
+			}
+
+			/* écart en nombre d'écarts types de l'estimation par échantillonnage */
+			for( o = 0; o < COMBAT_NB_OUTCOMES; o++ )
+			{
+				double p = odds.outcome[ o ], d = fabs( ( double )counts[ o ] / NB_SAMPLES - p );
+				if( d > error )
+					error = d;
+				if( p <= 0 || p >= 1 )
+					impossible += counts[ o ] != ( p > 0 ? NB_SAMPLES : 0 );
+				else if( d / sqrt( p * ( 1 - p ) / NB_SAMPLES ) > max_z )
+					max_z = d / sqrt( p * ( 1 - p ) / NB_SAMPLES );
+			}
+			if( error > max_error )
+				max_error = error;
+
+			printf( "%-6u %-6s %6.3f %6.3f %6.3f %6.3f %6.3f %6.2f %6.2f %7.4f\n", npcs[ i ].type, tactics[ t ],
+				odds.outcome[ COMBAT_WIN ], odds.outcome[ COMBAT_TRADE ], odds.outcome[ COMBAT_LOSS ],
+				odds.outcome[ COMBAT_SURRENDERED ], odds.outcome[ COMBAT_BRIBED ], odds.mean_turns, turns, error );
+		}
+
+	printf( "combatOdds %8.3f us/query\n", t_odds / queries * 1e6 );
+	printf( "max |sampled - exact| %.4f (%.2f sigma), impossible outcomes sampled %ld\n", max_error, max_z, impossible );
+
+	destroyGameplay( game );
+	closeGameData();
+	return impossible != 0;
+}
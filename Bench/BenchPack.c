@@ -0,0 +1,281 @@
+/**
+ * @file BenchPack.c
+ * Mesure du chargement des images au démarrage : décodage des png du
+ * dossier Img par libpng (le décodeur qu'appelle `IMG_Load`, SDL_image
+ * n'étant pas lié au banc), comparé à la lecture du
+ * paquet d'images (@ref packOpen puis @ref packRead de chaque image) et à
+ * la lecture du cache des images décodées (lecture du png, empreinte, puis
+ * @ref imageCacheFind et copie des pixels). Le paquet et le cache sont
+ * construits par le banc à partir des pixels décodés par libpng : la
+ * comparaison des pixels vérifie seulement que le paquet et le cache rendent
+ * ceux-là sans perte, pas qu'ils sont identiques à ceux d'`IMG_Load`, que le
+ * banc n'appelle pas. Les fichiers sont dans le cache du système dans tous
+ * les cas : seul le coût du décodage est mesuré.
+ */
+
+#include <dirent.h>
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "ImageCache.h"
+#include "Pack.h"
+
+/// Paquet construit par le banc
+#define BENCH_PACK "Bench/assets.pack"
+/// Cache des images décodées construit par le banc
+#define BENCH_CACHE "Bench/image-cache"
+/// Nombre maximal d'images
+#define MAX_IMAGES 1024
+/// Nombre de mesures de chaque chemin, la meilleure est gardée
+#define NB_RUNS 5
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PACK_PNG_FORMAT PNG_FORMAT_BGRA
+#else
+#define PACK_PNG_FORMAT PNG_FORMAT_ARGB
+#endif
+
+static char* Names[ MAX_IMAGES ]; ///< Noms des images, sans extension
+static int NbImages; ///< Nombre d'images
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compareNames( const void* a, const void* b )
+{
+	return strcmp( *( char* const* )a, *( char* const* )b );
+}
+
+/// Décode `Img/<name>.png` ; renvoie les pixels ARGB, à libérer
+static void* decodePng( const char* name, int* w, int* h )
+{
+	char path[ 128 ];
+	png_image image;
+
+	snprintf( path, sizeof( path ), "Img/%s.png", name );
+	memset( &image, 0, sizeof( image ) );
+	image.version = PNG_IMAGE_VERSION;
+	if( !png_image_begin_read_from_file( &image, path ) )
+		return NULL;
+
+	image.format = PACK_PNG_FORMAT;
+	void* pixels = malloc( PNG_IMAGE_SIZE( image ) );
+	if( !pixels || !png_image_finish_read( &image, NULL, pixels, 0, NULL ) )
+	{
+		png_image_free( &image );
+		free( pixels );
+		return NULL;
+	}
+
+	*w = image.width;
+	*h = image.height;
+	return pixels;
+}
+
+/// Lit `Img/<name>.png` en entier ; renvoie son contenu, à libérer
+static void* readPng( const char* name, size_t* size )
+{
+	char path[ 128 ];
+	struct stat st;
+
+	snprintf( path, sizeof( path ), "Img/%s.png", name );
+	FILE* file = fopen( path, "rb" );
+	if( !file )
+		return NULL;
+	void* data = fstat( fileno( file ), &st ) == 0 ? malloc( st.st_size ) : NULL;
+	if( data && fread( data, 1, st.st_size, file ) != ( size_t )st.st_size )
+	{
+		free( data );
+		data = NULL;
+	}
+	fclose( file );
+	*size = st.st_size;
+	return data;
+}
+
+/**
+ * `readCached` relit les pixels de `Img/<name>.png` dans le cache des images
+ * décodées, comme `decodeImage` ; renvoie les pixels, à libérer
+ */
+static void* readCached( const ImageCache* cache, const char* name, int* w, int* h )
+{
+	CachedPixels cached;
+	size_t size;
+	void* data = readPng( name, &size );
+	void* pixels = NULL;
+
+	if( data && imageCacheFind( cache, imageCacheKey( data, size ), size, &cached ) == 0 )
+	{
+		*w = cached.w;
+		*h = cached.h;
+		pixels = malloc( ( size_t )cached.w * cached.h * 4 );
+		if( pixels )
+			memcpy( pixels, cached.pixels, ( size_t )cached.w * cached.h * 4 );
+		imageCacheRelease( &cached );
+	}
+	free( data );
+	return pixels;
+}
+
+/// Liste les png du dossier Img et renvoie leur taille totale
+static long listImages()
+{
+	DIR* dir = opendir( "Img" );
+	struct dirent* entry;
+	long total = 0;
+
+	if( !dir )
+		return -1;
+	while( ( entry = readdir( dir ) ) && NbImages < MAX_IMAGES )
+	{
+		size_t length = strlen( entry->d_name );
+		if( length > 4 && length - 4 < PACK_NAME_SIZE && strcmp( entry->d_name + length - 4, ".png" ) == 0 )
+		{
+			char path[ 512 ];
+			struct stat st;
+			snprintf( path, sizeof( path ), "Img/%s", entry->d_name );
+			if( stat( path, &st ) == 0 )
+				total += st.st_size;
+			Names[ NbImages++ ] = strndup( entry->d_name, length - 4 );
+		}
+	}
+	closedir( dir );
+	qsort( Names, NbImages, sizeof( *Names ), compareNames );
+	return total;
+}
+
+int main()
+{
+	PackWriter writer;
+	ImageCache cache;
+	Pack pack;
+	int i, run, mismatches = 0;
+
+	long png_bytes = listImages();
+	if( png_bytes < 0 || NbImages == 0 )
+	{
+		fprintf( stderr, "Img : no images\n" );
+		return 1;
+	}
+
+	/* construction du paquet */
+	double t = now();
+	if( packWriterOpen( &writer, BENCH_PACK ) != 0 )
+		return 1;
+	for( i = 0; i < NbImages; i++ )
+	{
+		int w, h;
+		void* pixels = decodePng( Names[ i ], &w, &h );
+		if( pixels )
+			packWriterAdd( &writer, Names[ i ], w, h, pixels );
+		free( pixels );
+	}
+	double raw_bytes = writer.raw_size;
+	if( packWriterClose( &writer ) != 0 )
+		return 1;
+	double t_cook = now() - t;
+
+	/* cache : le premier chargement de chaque png y range ses pixels */
+	if( imageCacheOpen( &cache, BENCH_CACHE, 1ull << 40 ) != 0 )
+		return 1;
+	for( i = 0; i < NbImages; i++ )
+	{
+		int w, h;
+		size_t size;
+		void* data = readPng( Names[ i ], &size );
+		void* pixels = decodePng( Names[ i ], &w, &h );
+		if( data && pixels )
+			imageCacheStore( &cache, imageCacheKey( data, size ), size, w, h, pixels );
+		free( data );
+		free( pixels );
+	}
+
+	/* png : le décodage par libpng, comme IMG_Load, de chaque image */
+	double t_png = 1e9;
+	for( run = 0; run < NB_RUNS; run++ )
+	{
+		t = now();
+		for( i = 0; i < NbImages; i++ )
+		{
+			int w, h;
+			free( decodePng( Names[ i ], &w, &h ) );
+		}
+		t = now() - t;
+		if( t < t_png )
+			t_png = t;
+	}
+
+	/* paquet : une projection, puis une décompression par image */
+	double t_pack = 1e9;
+	for( run = 0; run < NB_RUNS; run++ )
+	{
+		t = now();
+		if( packOpen( &pack, BENCH_PACK ) != 0 )
+			return 1;
+		for( i = 0; i < NbImages; i++ )
+		{
+			const PackEntry* entry = packFind( &pack, Names[ i ] );
+			void* pixels = malloc( ( size_t )entry->w * entry->h * 4 );
+			packRead( &pack, entry, pixels );
+			free( pixels );
+		}
+		t = now() - t;
+		if( t < t_pack )
+			t_pack = t;
+		if( run < NB_RUNS - 1 )
+			packClose( &pack );
+	}
+
+	/* cache : lecture et empreinte du png, puis projection des pixels */
+	double t_cache = 1e9;
+	for( run = 0; run < NB_RUNS; run++ )
+	{
+		t = now();
+		for( i = 0; i < NbImages; i++ )
+		{
+			int w, h;
+			free( readCached( &cache, Names[ i ], &w, &h ) );
+		}
+		t = now() - t;
+		if( t < t_cache )
+			t_cache = t;
+	}
+
+	/* le paquet et le cache rendent les pixels de libpng dont ils ont été construits */
+	for( i = 0; i < NbImages; i++ )
+	{
+		int w, h;
+		void* png = decodePng( Names[ i ], &w, &h );
+		const PackEntry* entry = packFind( &pack, Names[ i ] );
+		void* pixels = malloc( ( size_t )w * h * 4 );
+		int cached_w = 0, cached_h = 0;
+		void* cached = readCached( &cache, Names[ i ], &cached_w, &cached_h );
+		if( !png || !entry || ( int )entry->w != w || ( int )entry->h != h || packRead( &pack, entry, pixels ) != 0
+			|| memcmp( png, pixels, ( size_t )w * h * 4 ) != 0 )
+			mismatches++;
+		if( !png || !cached || cached_w != w || cached_h != h || memcmp( png, cached, ( size_t )w * h * 4 ) != 0 )
+			mismatches++;
+		free( png );
+		free( pixels );
+		free( cached );
+	}
+	double pack_bytes = pack.map_size;
+	packClose( &pack );
+
+	printf( "%d images, %.1f MB of png, %.1f MB of pixels, pack %.1f MB (built in %.2f s)\n", NbImages,
+		png_bytes / 1e6, raw_bytes / 1e6, pack_bytes / 1e6, t_cook );
+	printf( "png decode  %8.1f ms  %7.0f MB/s of pixels\n", t_png * 1e3, raw_bytes / t_png / 1e6 );
+	printf( "pack read   %8.1f ms  %7.0f MB/s of pixels  (x%.1f)\n", t_pack * 1e3, raw_bytes / t_pack / 1e6, t_png / t_pack );
+	printf( "cache read  %8.1f ms  %7.0f MB/s of pixels  (x%.1f)\n", t_cache * 1e3, raw_bytes / t_cache / 1e6, t_png / t_cache );
+	printf( "pack/cache vs libpng pixel mismatches : %d\n", mismatches );
+	return mismatches != 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file BenchReplay.c
+ * Mesure de bout en bout du cœur du jeu par relecture d'un journal
+ * d'entrées (@ref Replay) aussi vite que possible, sans la SDL. Sans
+ * argument, un journal de 200 parties jouées au hasard est d'abord
+ * enregistré ; sinon le journal donné est relu.\n
+ * Chaque relecture doit finir dans le même état que l'enregistrement : un
+ * écart signale une perte de déterminisme.\n
+ * Usage : `Bench/BenchReplay [journal]`
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Gameplay.h"
+#include "Replay.h"
+
+/// Nombre de parties enregistrées sans journal donné
+#define NB_SESSIONS 200
+/// Nombre maximal d'entrées par partie enregistrée
+#define MAX_TURNS 1000
+/// Nombre de relectures mesurées
+#define NB_RUNS 20
+
+/// Journal enregistré sans journal donné
+#define RECORD_PATH "Bench/replay.log"
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// Empreinte de l'état observable d'une partie
+static unsigned long fingerprint( const Gameplay_s* game )
+{
+	unsigned long h = game->state;
+	h = h * 31 + game->area;
+	h = h * 31 + game->player_current_life;
+	h = h * 31 + game->inventory.gold;
+	h = h * 31 + game->nb_npc;
+	h = h * 31 + game->end_cause;
+	int i;
+	for( i = 0; i < MAX_ITEM; i++ )
+		h = h * 31 + game->inventory.items[ i ];
+	return h;
+}
+
+/// Enregistre `NB_SESSIONS` parties jouées au hasard dans `path`
+static unsigned long record( Gameplay_s* game, const char* path )
+{
+	Recorder rec;
+	Input inputs[ 1024 ];
+	Rng policy;
+	unsigned long h = 0;
+	int s, turn;
+
+	if( recorderOpen( &rec, path, 0 ) != 0 )
+	{
+		printf( "%s : cannot record\n", path );
+		exit( 1 );
+	}
+
+	rngSeed( &policy, 1, 0 );
+
+	for( s = 0; s < NB_SESSIONS; s++ )
+	{
+		seedGameplay( game, 42, s );
+		initGameplay( game );
+		recorderSeed( &rec, game, 0 );
+
+		for( turn = 0; turn < MAX_TURNS; turn++ )
+		{
+			int n = listInputs( game, inputs, 1024 );
+			if( n == 0 )
+				break;
+
+			Input input = inputs[ rngBelow( &policy, n ) ];
+			recorderInput( &rec, game, input, turn );
+			applyInput( game, input );
+		}
+
+		h = h * 131 + fingerprint( game );
+	}
+
+	printf( "recorded %d sessions, %ld events in %s\n", NB_SESSIONS, rec.count, path );
+	recorderClose( &rec );
+	return h;
+}
+
+int main( int argc, char* argv[] )
+{
+	const char* path = argc > 1 ? argv[ 1 ] : RECORD_PATH;
+	unsigned long expected = 0;
+	Replay replay;
+	int run;
+
+	preloadGameData();
+	Gameplay_s* game = createGameplay();
+
+	if( argc <= 1 )
+		expected = record( game, path );
+
+	if( replayLoad( &replay, path ) != 0 )
+	{
+		printf( "%s : invalid replay\n", path );
+		destroyGameplay( game );
+		closeGameData();
+		return 1;
+	}
+
+	long events = 0, sessions = 0;
+	int diverged = 0;
+	unsigned long h = 0;
+	double t = now();
+
+	for( run = 0; run < NB_RUNS; run++ )
+	{
+		int first = 1, status;
+		h = 0;
+		replayRewind( &replay );
+
+		while( replayPending( &replay ) )
+		{
+			int starts = replay.next.kind == REPLAY_SEED;
+			if( starts && !first )
+				h = h * 131 + fingerprint( game );
+			first = 0;
+
+			status = replayStep( &replay, game );
+			if( status < 0 )
+			{
+				diverged++;
+				break;
+			}
+			events++;
+			sessions += starts;
+		}
+		h = h * 131 + fingerprint( game );
+	}
+
+	t = now() - t;
+
+	printf( "replayed %ld events (%ld sessions) in %.3f s : %.0f events/s, %.0f sessions/s\n",
+		events, sessions, t, events / t, sessions / t );
+	if( argc <= 1 )
+		printf( "final state %s\n", h == expected && !diverged ? "identical" : "DIVERGED" );
+	else if( diverged )
+		printf( "DIVERGED %d times\n", diverged );
+
+	replayFree( &replay );
+	destroyGameplay( game );
+	closeGameData();
+	return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file BenchSnapshot.c
+ * Mesure de la prise et de la restauration d'un instantané (@ref
+ * snapshotGameplay, @ref restoreGameplay) à chaque tour de parties jouées
+ * au hasard, comme le ferait un joueur simulé qui explore plusieurs suites
+ * d'entrées depuis le même état. Vérifie aussi qu'une partie restaurée
+ * rejoue exactement la même suite que l'originale.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Gameplay.h"
+#include "Snapshot.h"
+
+/// Nombre de parties jouées
+#define NB_SESSIONS 200
+/// Nombre maximal de tours par partie
+#define MAX_TURNS 1000
+/// Taille du tampon des instantanés
+#define BUFFER_SIZE ( 64 * 1024 )
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// Joue `turns` entrées choisies avec `policy`, renvoie une empreinte de la partie
+static unsigned long play( Gameplay_s* game, Rng* policy, int turns )
+{
+	Input inputs[ 1024 ];
+	unsigned long h = 0;
+	int t;
+
+	for( t = 0; t < turns; t++ )
+	{
+		int n = listInputs( game, inputs, 1024 );
+		if( n == 0 )
+			break;
+		applyInput( game, inputs[ rngBelow( policy, n ) ] );
+		h = h * 31 + game->state * 7 + game->player_current_life + game->inventory.gold + game->nb_npc;
+	}
+	return h;
+}
+
+int main()
+{
+	static unsigned char buffer[ BUFFER_SIZE ];
+	double t_snap = 0, t_restore = 0;
+	long snaps = 0, mismatches = 0;
+	size_t total_size = 0, max_size = 0;
+	int s, turn;
+
+	preloadGameData();
+	Gameplay_s* game = createGameplay();
+
+	for( s = 0; s < NB_SESSIONS; s++ )
+	{
+		Rng policy;
+		Input inputs[ 1024 ];
+
+		seedGameplay( game, 42, s );
+		initGameplay( game );
+		rngSeed( &policy, 7, s );
+
+		for( turn = 0; turn < MAX_TURNS; turn++ )
+		{
+			double t = now();
+			size_t size = snapshotGameplay( game, buffer, BUFFER_SIZE );
+			t_snap += now() - t;
+			snaps++;
+			total_size += size;
+			if( size > max_size )
+				max_size = size;
+
+			/* tous les 16 tours : la suite jouée après restauration doit être identique */
+			if( turn % 16 == 0 )
+			{
+				Rng a = policy, b = policy;
+				unsigned long ha = play( game, &a, 8 );
+
+				t = now();
+				restoreGameplay( game, buffer, size );
+				t_restore += now() - t;
+
+				if( play( game, &b, 8 ) != ha )
+					mismatches++;
+				restoreGameplay( game, buffer, size );
+			}
+			else
+			{
+				t = now();
+				restoreGameplay( game, buffer, size );
+				t_restore += now() - t;
+			}
+
+			int n = listInputs( game, inputs, 1024 );
+			if( n == 0 )
+				break;
+			applyInput( game, inputs[ rngBelow( &policy, n ) ] );
+		}
+	}
+
+	printf( "%ld snapshots, mean size %.0f bytes, max %zu bytes\n", snaps, ( double )total_size / snaps, max_size );
+	printf( "snapshot %8.3f us\n", t_snap / snaps * 1e6 );
+	printf( "restore  %8.3f us\n", t_restore / snaps * 1e6 );
+	printf( "replay mismatches after restore : %ld\n", mismatches );
+
+	destroyGameplay( game );
+	closeGameData();
+	return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file BenchSpatial.c
+ * Mesure du coût d'un clic sur une zone de 10 000 éléments : parcours
+ * linéaire des éléments de la zone contre la grille de @ref elementAt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Gameplay.h"
+
+/// Nombre d'éléments de la zone simulée
+#define NB_ELEMENTS 10000
+/// Nombre de clics simulés
+#define NB_QUERIES 100000
+
+/// Partie simulée
+static Gameplay_s Game;
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Recherche de référence : parcourt tous les éléments du plus haut au plus
+ * bas dans l'ordre d'affichage.
+ */
+static int linearAt( int x, int y )
+{
+	int i;
+	for( i = Game.elements.count - 1; i >= 0; i-- )
+	{
+		if( intersects( Game.elements.rects[ i ], x, y ) && !elementHidden( &Game, i ) )
+			return i;
+	}
+	return -1;
+}
+
+int main( int argc, char* argv[] )
+{
+	( void )argc;
+	( void )argv;
+
+	int i;
+	srand( 42 );
+
+	/* zone synthétique : sprites de 32 à 128 pixels répartis sur l'écran */
+	ElementTable* t = &Game.elements;
+	t->count = t->capacity = NB_ELEMENTS;
+	t->rects = malloc( sizeof( Rect ) * NB_ELEMENTS );
+	t->types = malloc( sizeof( int ) * NB_ELEMENTS );
+	t->values = malloc( sizeof( int ) * NB_ELEMENTS );
+	t->keys = malloc( sizeof( int ) * NB_ELEMENTS );
+	for( i = 0; i < NB_ELEMENTS; i++ )
+	{
+		t->types[ i ] = i % 4 == 0 ? 0 : 1;
+		t->values[ i ] = 100 + i % 7;
+		t->keys[ i ] = i;
+		t->rects[ i ].w = 32 + rand() % 96;
+		t->rects[ i ].h = 32 + rand() % 96;
+		t->rects[ i ].x = rand() % ( 800 - t->rects[ i ].w );
+		t->rects[ i ].y = rand() % ( 600 - t->rects[ i ].h );
+	}
+
+	/* quelques NPC morts, qui doivent être ignorés */
+	Game.nb_npc = 16;
+	Game.npcs = calloc( Game.nb_npc, sizeof( npc_stats ) );
+	for( i = 0; i < Game.nb_npc; i++ )
+	{
+		Game.npcs[ i ].type = 100 + i % 7;
+		Game.npcs[ i ].unique_id = i * 4 * 37;
+		Game.npcs[ i ].life = 0;
+	}
+
+	int* xs = malloc( sizeof( int ) * NB_QUERIES );
+	int* ys = malloc( sizeof( int ) * NB_QUERIES );
+	for( i = 0; i < NB_QUERIES; i++ )
+	{
+		xs[ i ] = rand() % 800;
+		ys[ i ] = rand() % 600;
+	}
+
+	double t0 = now();
+	gridBuild( &Game.grid, t->rects, t->count );
+	double t_build = now() - t0;
+
+	long sum_linear = 0, sum_grid = 0;
+
+	t0 = now();
+	for( i = 0; i < NB_QUERIES; i++ )
+		sum_linear += linearAt( xs[ i ], ys[ i ] );
+	double t_linear = now() - t0;
+
+	t0 = now();
+	for( i = 0; i < NB_QUERIES; i++ )
+		sum_grid += elementAt( &Game, xs[ i ], ys[ i ] );
+	double t_grid = now() - t0;
+
+	int mismatches = 0;
+	for( i = 0; i < NB_QUERIES; i++ )
+	{
+		if( linearAt( xs[ i ], ys[ i ] ) != elementAt( &Game, xs[ i ], ys[ i ] ) )
+			mismatches++;
+	}
+
+	printf( "elements            : %d\n", NB_ELEMENTS );
+	printf( "grid                : %dx%d cells, %d entries, built in %.3f ms\n",
+		Game.grid.cols, Game.grid.rows, Game.grid.nb_indices, t_build * 1e3 );
+	printf( "linear scan         : %.1f ns/click\n", t_linear * 1e9 / NB_QUERIES );
+	printf( "grid (elementAt)    : %.1f ns/click\n", t_grid * 1e9 / NB_QUERIES );
+	printf( "speedup             : %.1fx\n", t_linear / t_grid );
+	printf( "mismatches          : %d (checksums %ld / %ld)\n", mismatches, sum_linear, sum_grid );
+
+	gridFree( &Game.grid );
+	free( t->rects );
+	free( t->types );
+	free( t->values );
+	free( t->keys );
+	free( Game.npcs );
+	free( xs );
+	free( ys );
+
+	return mismatches != 0;
+}
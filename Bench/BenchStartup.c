@@ -0,0 +1,308 @@
+/**
+ * @file BenchStartup.c
+ * Mesure du démarrage en graphe de tâches (voir @ref TaskGraph.h) selon le
+ * nombre de fils. Le graphe reprend celui du client graphique, sans la SDL
+ * : lecture de la police, lecture du catalogue des objets, création de la
+ * partie qui ajoute le décodage du fond et des sprites de sa première zone,
+ * et décodage des autres images du dossier Img sauf les fonds des zones et
+ * les images des objets, chargés à leur première utilisation, à la place
+ * des images de l'interface. Les png sont décodés par libpng, comme par
+ * `IMG_Load`.
+ *
+ * Le même travail est d'abord fait à la suite sur un seul fil, sans graphe.
+ * L'empreinte des pixels décodés et l'état de la partie créée doivent être
+ * les mêmes quel que soit le nombre de fils.
+ */
+
+#include <dirent.h>
+#include <png.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Gameplay.h"
+#include "ImageCache.h"
+#include "Inventory.h"
+#include "Snapshot.h"
+#include "TaskGraph.h"
+
+/// Nombre maximal d'images
+#define MAX_IMAGES 256
+/// Longueur maximale du nom d'une image
+#define NAME_SIZE 64
+/// Nombre de mesures de chaque nombre de fils, la meilleure est gardée
+#define NB_RUNS 3
+/// Graine de la partie créée
+#define SEED 42
+
+static char Names[ MAX_IMAGES ][ NAME_SIZE ]; ///< Noms des png du dossier Img, triés
+static int NbImages; ///< Nombre de png
+
+/**
+ * @struct Startup
+ * @brief Un démarrage : graphe, images décodées et partie créée
+ */
+typedef struct
+{
+	TaskGraph* graph; ///< Graphe des tâches, `NULL` pour tout faire à la suite
+	pthread_mutex_t lock; ///< Protège `claimed`
+	int claimed[ MAX_IMAGES ]; ///< Non nul pour les images déjà décodées ou à décoder
+	uint64_t hashes[ MAX_IMAGES ]; ///< Empreinte des pixels de chaque image décodée
+	Gameplay_s* game; ///< Partie créée
+	TaskId items_task; ///< Lecture du catalogue
+	size_t font_size; ///< Taille de la police lue
+} Startup;
+
+/**
+ * @struct DecodeJob
+ * @brief Décodage d'une image d'un démarrage
+ */
+typedef struct
+{
+	Startup* startup; ///< Démarrage
+	int index; ///< Indice de l'image dans `Names`
+} DecodeJob;
+
+static DecodeJob Jobs[ MAX_IMAGES ]; ///< Décodage de chaque image
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compareNames( const void* a, const void* b )
+{
+	return strcmp( a, b );
+}
+
+/// Liste les png du dossier Img
+static int listImages()
+{
+	DIR* dir = opendir( "Img" );
+	struct dirent* entry;
+
+	if( !dir )
+		return -1;
+	while( ( entry = readdir( dir ) ) && NbImages < MAX_IMAGES )
+	{
+		size_t length = strlen( entry->d_name );
+		if( length > 4 && length - 4 < NAME_SIZE && strcmp( entry->d_name + length - 4, ".png" ) == 0 )
+			snprintf( Names[ NbImages++ ], NAME_SIZE, "%.*s", ( int )( length - 4 ), entry->d_name );
+	}
+	closedir( dir );
+	qsort( Names, NbImages, NAME_SIZE, compareNames );
+	return 0;
+}
+
+/// Tâche : décode `Img/<name>.png` et relève l'empreinte de ses pixels
+static void decodeTask( void* arg )
+{
+	DecodeJob* job = arg;
+	char path[ 128 ];
+	png_image image;
+
+	snprintf( path, sizeof( path ), "Img/%s.png", Names[ job->index ] );
+	memset( &image, 0, sizeof( image ) );
+	image.version = PNG_IMAGE_VERSION;
+	if( !png_image_begin_read_from_file( &image, path ) )
+		return;
+
+	image.format = PNG_FORMAT_BGRA;
+	void* pixels = malloc( PNG_IMAGE_SIZE( image ) );
+	if( pixels && png_image_finish_read( &image, NULL, pixels, 0, NULL ) )
+		job->startup->hashes[ job->index ] = imageCacheKey( pixels, PNG_IMAGE_SIZE( image ) );
+	else
+		png_image_free( &image );
+	free( pixels );
+}
+
+/// Ajoute le décodage d'une image du dossier Img, sauf si elle l'est déjà
+static void addDecode( Startup* startup, const char* name )
+{
+	char key[ NAME_SIZE ];
+
+	snprintf( key, sizeof( key ), "%s", name );
+	char* found = bsearch( key, Names, NbImages, NAME_SIZE, compareNames );
+	if( !found )
+		return;
+
+	int index = ( int )( ( found - Names[ 0 ] ) / NAME_SIZE );
+	pthread_mutex_lock( &startup->lock );
+	int claimed = startup->claimed[ index ];
+	startup->claimed[ index ] = 1;
+	pthread_mutex_unlock( &startup->lock );
+	if( claimed )
+		return;
+
+	Jobs[ index ].startup = startup;
+	Jobs[ index ].index = index;
+	if( startup->graph )
+		taskAdd( startup->graph, decodeTask, &Jobs[ index ], 0, NULL );
+	else
+		decodeTask( &Jobs[ index ] );
+}
+
+/// Tâche : lit la police en entier, comme `TTF_OpenFont`
+static void fontTask( void* arg )
+{
+	Startup* startup = arg;
+	char buffer[ 65536 ];
+	size_t n;
+
+	FILE* file = fopen( "Data/CL.ttf", "rb" );
+	if( !file )
+		return;
+	while( ( n = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 )
+		startup->font_size += n;
+	fclose( file );
+}
+
+/// Tâche : lit le catalogue des objets, dont les images ne sont pas décodées
+static void itemsTask( void* arg )
+{
+	( void )arg;
+	initItems();
+}
+
+/// Tâche : crée la partie et ajoute le décodage du fond et des sprites de sa première zone
+static void gameTask( void* arg )
+{
+	Startup* startup = arg;
+	char name[ 16 ];
+	int i;
+
+	startup->game = createGameplay();
+	seedGameplay( startup->game, SEED, 0 );
+
+	sprintf( name, "Zone%d", startup->game->area );
+	addDecode( startup, name );
+	for( i = 0; i < startup->game->elements.nb_sprites; i++ )
+		addDecode( startup, startup->game->elements.sprite_names[ i ] );
+}
+
+/// Indique si une image est celle d'un objet du catalogue
+static int isItemImage( const char* name )
+{
+	int i;
+	for( i = 0; i < NbItems; i++ )
+	{
+		if( strcmp( Items[ i ].name, name ) == 0 )
+			return 1;
+	}
+	return 0;
+}
+
+/// Tâche : ajoute le décodage des images qui ne sont ni des fonds de zone ni des objets
+static void interfaceTask( void* arg )
+{
+	Startup* startup = arg;
+	int i;
+	for( i = 0; i < NbImages; i++ )
+	{
+		if( strncmp( Names[ i ], "Zone", 4 ) != 0 && strncmp( Names[ i ], "IZone", 5 ) != 0
+			&& !isItemImage( Names[ i ] ) )
+			addDecode( startup, Names[ i ] );
+	}
+}
+
+/**
+ * `startup` fait un démarrage avec `nb_threads` fils, à la suite sur le fil
+ * courant si `nb_threads` est nul, et renvoie sa durée en secondes. Les
+ * empreintes des images et de la partie sont combinées dans `hash`.
+ */
+static double startup( int nb_threads, uint64_t* hash )
+{
+	static Startup s;
+	TaskGraph graph;
+	int i;
+
+	memset( &s, 0, sizeof( s ) );
+	pthread_mutex_init( &s.lock, NULL );
+
+	double t = now();
+	if( nb_threads )
+	{
+		taskGraphInit( &graph, nb_threads );
+		s.graph = &graph;
+		taskAdd( &graph, fontTask, &s, 0, NULL );
+		s.items_task = taskAdd( &graph, itemsTask, &s, 0, NULL );
+		taskAdd( &graph, gameTask, &s, 1, &s.items_task );
+		/* les images des objets ne sont connues qu'après le catalogue */
+		taskAdd( &graph, interfaceTask, &s, 1, &s.items_task );
+		taskGraphDestroy( &graph );
+	}
+	else
+	{
+		fontTask( &s );
+		itemsTask( &s );
+		gameTask( &s );
+		interfaceTask( &s );
+	}
+	t = now() - t;
+
+	size_t size = snapshotSize( s.game );
+	uint8_t* state = malloc( size );
+	size = snapshotGameplay( s.game, state, size );
+	*hash = imageCacheKey( state, size ) ^ s.font_size;
+	for( i = 0; i < NbImages; i++ )
+		*hash = ( *hash ^ s.hashes[ i ] ) * 0x100000001b3ull;
+	free( state );
+
+	destroyGameplay( s.game );
+	closeItems();
+	pthread_mutex_destroy( &s.lock );
+	return t;
+}
+
+int main()
+{
+	int nb_cores = ( int )sysconf( _SC_NPROCESSORS_ONLN ), threads, run, mismatches = 0;
+	uint64_t reference, hash;
+
+	if( listImages() != 0 || NbImages == 0 )
+	{
+		fprintf( stderr, "Img : no images\n" );
+		return 1;
+	}
+
+	double t_serial = 1e9;
+	for( run = 0; run < NB_RUNS; run++ )
+	{
+		double t = startup( 0, &reference );
+		if( t < t_serial )
+			t_serial = t;
+	}
+
+	printf( "%d cores, %d images in Img\n", nb_cores, NbImages );
+	printf( "serial      %8.1f ms\n", t_serial * 1e3 );
+
+	int max_threads = nb_cores > 2 ? nb_cores : 2;
+	if( max_threads > TASK_GRAPH_MAX_THREADS )
+		max_threads = TASK_GRAPH_MAX_THREADS;
+	/* 1, 2, 4... fils, puis un par cœur */
+	for( threads = 1;; threads *= 2 )
+	{
+		if( threads > max_threads )
+			threads = max_threads;
+		double t_graph = 1e9;
+		for( run = 0; run < NB_RUNS; run++ )
+		{
+			double t = startup( threads, &hash );
+			if( t < t_graph )
+				t_graph = t;
+			mismatches += hash != reference;
+		}
+		printf( "%2d threads  %8.1f ms  (x%.2f)\n", threads, t_graph * 1e3, t_serial / t_graph );
+		if( threads == max_threads )
+			break;
+	}
+
+	printf( "state mismatches : %d\n", mismatches );
+	return mismatches != 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file BenchZone.c
+ * Mesure du chargement des zones : lecture du format texte contre
+ * projection du format compilé, sur les zones du jeu et sur une zone
+ * synthétique de 10 000 éléments.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Zone.h"
+
+/// Nombre d'éléments de la zone synthétique
+#define NB_SYNTH 10000
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Charge `iterations` fois une zone et parcourt ses éléments comme le fait
+ * @ref loadArea, puis renvoie la durée moyenne d'un chargement en
+ * microsecondes.
+ */
+static double measure( const char* path, int binary, int iterations, long* checksum )
+{
+	int i, j;
+	double t0 = now();
+
+	for( i = 0; i < iterations; i++ )
+	{
+		Zone zone;
+		int r = binary ? zoneLoadBinary( &zone, path ) : zoneLoadText( &zone, path );
+		if( r != 0 )
+		{
+			fprintf( stderr, "%s : load failed\n", path );
+			exit( 1 );
+		}
+
+		for( j = 0; j < zone.nb_elements; j++ )
+			*checksum += zone.elements[ j ].x + zone.elements[ j ].value + zoneSprite( &zone, zone.elements[ j ].sprite )[ 0 ];
+
+		zoneClose( &zone );
+	}
+
+	return ( now() - t0 ) * 1e6 / iterations;
+}
+
+/// Compare les deux formats pour un fichier texte donné
+static void compare( const char* label, const char* txt, int iterations )
+{
+	char bin[ 128 ];
+	snprintf( bin, sizeof( bin ), "%s.bench.bin", txt );
+
+	Zone zone;
+	if( zoneLoadText( &zone, txt ) != 0 || zoneWriteBinary( &zone, bin ) != 0 )
+	{
+		fprintf( stderr, "%s : cannot compile\n", txt );
+		exit( 1 );
+	}
+	int n = zone.nb_elements;
+	zoneClose( &zone );
+
+	long sum_txt = 0, sum_bin = 0;
+	double t_txt = measure( txt, 0, iterations, &sum_txt );
+	double t_bin = measure( bin, 1, iterations, &sum_bin );
+
+	printf( "%-10s %6d elements  text %9.2f us  binary %7.2f us  x%.1f%s\n",
+		label, n, t_txt, t_bin, t_txt / t_bin, sum_txt == sum_bin ? "" : "  MISMATCH" );
+
+	remove( bin );
+}
+
+int main( int argc, char* argv[] )
+{
+	( void )argc;
+	( void )argv;
+
+	int area;
+	char path[ 64 ], label[ 16 ];
+
+	for( area = 1; area <= 15; area++ )
+	{
+		sprintf( path, "Data/Zone%d.txt", area );
+		sprintf( label, "Zone%d", area );
+		compare( label, path, 2000 );
+	}
+
+	/* zone synthétique */
+	const char* synth = "/tmp/4A_bench_zone.txt";
+	FILE* file = fopen( synth, "w" );
+	if( !file )
+		return 1;
+
+	const char* sprites[] = { "garde1_up", "garde2_down", "fleche_haut", "tavernier_down", "fairy" };
+	int i;
+	srand( 42 );
+	for( i = 0; i < NB_SYNTH; i++ )
+		fprintf( file, "%d %s %d %d %d %d\n", i % 3 == 0, sprites[ i % 5 ], rand() % 800, rand() % 400, 50 + i % 400, rand() );
+	fclose( file );
+
+	compare( "synthetic", synth, 50 );
+	remove( synth );
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file Boot.c
+ * Démarrage par étapes, sous forme d'un graphe de tâches (voir
+ * @ref TaskGraph.h) exécuté par un fil par cœur :
+ * - l'ouverture de la police, et celle du paquet et du cache des images,
+ * dont dépend le décodage de chaque image ;
+ * - le décodage de l'écran de début et de chaque image de l'interface ;
+ * - la lecture du catalogue des objets ;
+ * - la création de la partie, après le catalogue : elle charge la première
+ * zone, puis ajoute le décodage de son fond et de ses sprites.
+ *
+ * Les images des objets et le fond des interactions ne sont pas décodés :
+ * ils ne le sont qu'à leur première utilisation (voir @ref lazyTexture).
+ *
+ * Le fil principal n'attend que la police et l'écran de début
+ * (@ref bootStartScreen) avant d'afficher la première image. Seuls la
+ * lecture des fichiers et le décodage se font hors du fil principal : les
+ * textures sont créées sur le fil du rendu à partir des images décodées
+ * (voir @ref offerImage).
+ */
+#include "Boot.h"
+#include "Inventory.h"
+#include "Log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Tâche : ouvre la police
+static void openFontTask( void* arg )
+{
+	( void )arg;
+	openFont();
+}
+
+/// Tâche : ouvre le paquet et le cache des images
+static void openAssetsTask( void* arg )
+{
+	( void )arg;
+	openAssets();
+}
+
+/// Tâche : décode une image
+static void decodeTask( void* arg )
+{
+	DecodedImage* image = arg;
+	image->surface = decodeImage( image->name );
+}
+
+/**
+ * `addDecode` ajoute le décodage d'une image, sauf si elle l'est déjà ou
+ * s'il n'y a plus de place : elle sera alors décodée par @ref loadImage.
+ * Elle peut être appelée par une tâche.
+ * @param boot Le démarrage
+ * @param name Le nom de l'image
+ * @return La tâche qui décode l'image, -1 si aucune tâche n'a été ajoutée
+ */
+static TaskId addDecode( Boot* boot, const char* name )
+{
+	int i;
+
+	if( strlen( name ) >= IMAGE_NAME_SIZE )
+		return -1;
+
+	pthread_mutex_lock( &boot->lock );
+	for( i = 0; i < boot->nb_images; i++ )
+	{
+		if( strcmp( boot->images[ i ].name, name ) == 0 )
+		{
+			pthread_mutex_unlock( &boot->lock );
+			return -1;
+		}
+	}
+	if( boot->nb_images == BOOT_MAX_IMAGES )
+	{
+		pthread_mutex_unlock( &boot->lock );
+		return -1;
+	}
+	DecodedImage* image = &boot->images[ boot->nb_images++ ];
+	strcpy( image->name, name );
+	image->surface = NULL;
+	pthread_mutex_unlock( &boot->lock );
+
+	return taskAdd( &boot->graph, decodeTask, image, 1, &boot->assets_task );
+}
+
+/// Tâche : lit le catalogue des objets
+static void loadItemsTask( void* arg )
+{
+	( void )arg;
+	initItems();
+}
+
+/// Tâche : crée la partie et ajoute le décodage du fond et des sprites de sa première zone
+static void createGameTask( void* arg )
+{
+	Boot* boot = arg;
+	char name[ 16 ];
+	int i;
+
+	/* le joueur a quitté : ni partie ni nouvelles images */
+	if( atomic_load( &boot->cancelled ) )
+		return;
+
+	boot->game = createGameplay();
+	seedGameplay( boot->game, boot->seed, 0 );
+
+	sprintf( name, "Zone%d", boot->game->area );
+	addDecode( boot, name );
+
+	const ElementTable* t = &boot->game->elements;
+	for( i = 0; i < t->nb_sprites; i++ )
+		addDecode( boot, t->sprite_names[ i ] );
+}
+
+/**
+ * `bootStart` lance le chargement en arrière-plan de ce dont le jeu a
+ * besoin, l'écran de début compris. @ref bootStartScreen doit être appelée
+ * ensuite pour afficher la première image, puis @ref bootPoll jusqu'à ce
+ * qu'elle renvoie la partie.
+ * @param boot Le démarrage, initialisé par cette fonction
+ * @param seed La graine de la partie créée (voir @ref seedGameplay)
+ */
+void bootStart( Boot* boot, uint64_t seed )
+{
+	int i;
+
+	memset( boot, 0, sizeof( *boot ) );
+	boot->seed = seed;
+	pthread_mutex_init( &boot->lock, NULL );
+
+	taskGraphInit( &boot->graph, 0 );
+	if( !boot->graph.nb_threads )
+		logWarn( "cannot start a loading thread, loading on the main thread" );
+
+	/* l'écran de début est décodé le premier, avant que les tâches des
+	   objets et de la partie n'ajoutent d'autres images */
+	boot->assets_task = taskAdd( &boot->graph, openAssetsTask, NULL, 0, NULL );
+	boot->font_task = taskAdd( &boot->graph, openFontTask, NULL, 0, NULL );
+	boot->start_task = addDecode( boot, TextureNames[ START_BG ] );
+	for( i = START_BG + 1; i < NB_TEXTURES; i++ )
+		addDecode( boot, TextureNames[ i ] );
+
+	boot->items_task = taskAdd( &boot->graph, loadItemsTask, NULL, 0, NULL );
+	boot->game_task = taskAdd( &boot->graph, createGameTask, boot, 1, &boot->items_task );
+}
+
+/**
+ * `bootStartScreen` attend la police et l'écran de début, puis crée sur le
+ * fil courant, qui doit être celui du rendu, de quoi afficher la première
+ * image (voir @ref initStartScreen).
+ * @param boot Le démarrage lancé par @ref bootStart
+ */
+void bootStartScreen( Boot* boot )
+{
+	taskWait( &boot->graph, boot->font_task );
+	taskWait( &boot->graph, boot->assets_task );
+	taskWait( &boot->graph, boot->start_task );
+
+	DecodedImage* start = &boot->images[ 0 ];
+	if( boot->start_task >= 0 && start->surface )
+	{
+		offerImage( start->name, start->surface );
+		start->surface = NULL;
+	}
+
+	initStartScreen();
+}
+
+/**
+ * `bootPoll` renvoie `NULL` tant que des tâches de chargement travaillent.
+ * Quand elles ont fini, elle crée sur le fil courant, qui doit être celui du
+ * rendu, les textures de l'interface et de la première zone à partir des
+ * images décodées, puis renvoie la partie.
+ * @param boot Le démarrage lancé par @ref bootStart
+ * @return La partie prête à être jouée, ou `NULL` si le chargement continue
+ */
+Gameplay_s* bootPoll( Boot* boot )
+{
+	int i;
+
+	/* sans fil de chargement, le fil principal fait tout d'un coup */
+	if( boot->graph.nb_threads && !taskGraphDone( &boot->graph ) )
+		return NULL;
+	taskGraphDestroy( &boot->graph );
+
+	for( i = 0; i < boot->nb_images; i++ )
+	{
+		DecodedImage* image = &boot->images[ i ];
+		if( image->surface )
+			offerImage( image->name, image->surface );
+		image->surface = NULL;
+	}
+	boot->nb_images = 0;
+	pthread_mutex_destroy( &boot->lock );
+
+	initGraphics();
+	syncZoneTextures( boot->game );
+	clearOfferedImages();
+
+	return boot->game;
+}
+
+/**
+ * `bootCancel` abandonne le chargement, quand le joueur quitte avant que
+ * @ref bootPoll ait renvoyé la partie : la partie n'est plus créée si sa
+ * tâche n'a pas commencé, les tâches en cours finissent, puis les images
+ * décodées et la partie déjà créée sont libérées. Les ressources graphiques
+ * déjà chargées restent à libérer par @ref destroyGraphics.
+ * @param boot Le démarrage lancé par @ref bootStart, que @ref bootPoll n'a
+ * pas terminé
+ */
+void bootCancel( Boot* boot )
+{
+	int i;
+
+	atomic_store( &boot->cancelled, 1 );
+	taskGraphDestroy( &boot->graph );
+
+	for( i = 0; i < boot->nb_images; i++ )
+	{
+		SDL_FreeSurface( boot->images[ i ].surface );
+		boot->images[ i ].surface = NULL;
+	}
+	boot->nb_images = 0;
+	pthread_mutex_destroy( &boot->lock );
+
+	if( boot->game )
+		destroyGameplay( boot->game );
+	boot->game = NULL;
+}
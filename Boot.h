@@ -0,0 +1,47 @@
+/**
+ * @file Boot.h
+ * @brief Démarrage par étapes du client graphique : l'écran de début est
+ * affiché d'abord, le reste est chargé en arrière-plan pendant qu'il l'est.
+ */
+#ifndef __BOOT_H__
+#define __BOOT_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "Graphics.h"
+#include "TaskGraph.h"
+
+/// Nombre maximal d'images décodées pendant le démarrage
+#define BOOT_MAX_IMAGES 192
+
+/**
+ * @struct Boot
+ * @brief Graphe des tâches de chargement et images qu'elles ont décodées
+ */
+typedef struct
+{
+	uint64_t seed; ///< Graine de la partie créée
+	Gameplay_s* game; ///< Partie créée par la tâche `game_task`
+	TaskGraph graph; ///< Tâches de chargement
+	TaskId assets_task; ///< Ouverture du paquet et du cache des images, avant tout décodage
+	TaskId font_task; ///< Ouverture de la police
+	TaskId start_task; ///< Décodage de l'écran de début
+	TaskId items_task; ///< Lecture du catalogue des objets
+	TaskId game_task; ///< Création de la partie, qui charge sa première zone
+	pthread_mutex_t lock; ///< Protège `images` et `nb_images`
+	DecodedImage images[BOOT_MAX_IMAGES]; ///< Images décodées, la première est l'écran de début
+	int nb_images; ///< Nombre d'images
+	atomic_int cancelled; ///< Non nul quand le joueur a quitté pendant le chargement
+} Boot;
+
+/// @brief Lance le chargement en arrière-plan
+void bootStart( Boot* boot, uint64_t seed );
+/// @brief Attend la police et l'écran de début, puis les charge
+void bootStartScreen( Boot* boot );
+/// @brief Termine le chargement s'il est prêt et renvoie la partie, sinon `NULL`
+Gameplay_s* bootPoll( Boot* boot );
+/// @brief Abandonne le chargement et libère ce qu'il a déjà produit
+void bootCancel( Boot* boot );
+
+#endif
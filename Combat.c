@@ -0,0 +1,426 @@
+/**
+ * @file Combat.c
+ * Duels entre le joueur et un NPC. Un tour de combat (`ACTION_ATTACK` dans
+ * `processAction`) se déroule ainsi :
+ * - si le NPC est hostile, il peut se rendre (une chance sur deux) quand il
+ *   lui reste au plus @ref COMBAT_SURRENDER_LIFE points de vie, sinon il
+ *   riposte ; s'il ne l'est pas encore, il le devient sans riposter ;
+ * - le joueur frappe ensuite le NPC ;
+ * - la mort du NPC est traitée avant celle du joueur.
+ *
+ * @ref combatDuel rejoue ces règles tour par tour. @ref combatEvaluate en
+ * donne la forme close, sans boucle sur les tours ni branchement : chaque
+ * colonne est parcourue une fois par une boucle que le compilateur peut
+ * vectoriser. @ref combatOdds tient compte en plus des tirages de
+ * reddition et de corruption et en donne la loi exacte.
+ */
+#include "Combat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/// Nombre de tours attribué à ce qui n'arrive jamais
+#define COMBAT_NEVER ( COMBAT_MAX_TURNS + 1 )
+
+/// Largeur des blocs de @ref evaluateColumns, multiple de la largeur des vecteurs
+#define COMBAT_LANES 8
+
+/**
+ * `surrenderChance` renvoie 1 - 2^-`rolls`. La puissance de deux est écrite
+ * directement dans l'exposant d'un flottant : un décalage constant, là où
+ * `1 >> rolls` demanderait un décalage variable que SSE2 ne sait pas
+ * vectoriser.
+ */
+static inline float surrenderChance( int32_t rolls )
+{
+	union { int32_t bits; float value; } p;
+	int32_t r = rolls < 126 ? rolls : 126;
+
+	p.bits = ( 127 - r ) << 23;
+	return 1.0f - p.value;
+}
+
+/**
+ * `ceilDiv` renvoie ⌈a / b⌉ pour 0 ≤ a et 1 ≤ b. La division entière n'a pas
+ * d'équivalent vectoriel : elle est faite en simple précision, sur des
+ * vecteurs de même largeur que les entiers, et reste exacte tant que
+ * `a + 2b` est inférieur à 2^24 (voir @ref COMBAT_MAX_STAT).
+ */
+static inline int32_t ceilDiv( int32_t a, int32_t b )
+{
+	return ( int32_t )( ( float )( a + b - 1 ) / ( float )b );
+}
+
+/**
+ * `blend` renvoie `a` si `cond` vaut 1, `b` s'il vaut 0. Le choix se fait par
+ * masque plutôt que par branchement, que le compilateur refuse de vectoriser
+ * quand une branche contient un calcul en virgule flottante.
+ */
+static inline int32_t blend( int32_t cond, int32_t a, int32_t b )
+{
+	int32_t mask = -cond;
+	return ( a & mask ) | ( b & ~mask );
+}
+
+/**
+ * `combatDuel` simule tour par tour un duel où le joueur attaque jusqu'à la
+ * mort de l'un des deux, et où le NPC ne se rend jamais.
+ * @param player_atk Attaque du joueur
+ * @param player_def Défense du joueur
+ * @param player_life Points de vie du joueur
+ * @param npc_ata Attaque du NPC
+ * @param npc_def Défense du NPC
+ * @param npc_life Points de vie du NPC
+ * @param hostile Non nul si le NPC riposte dès le premier tour
+ * @param[out] result Le résultat du duel
+ */
+void combatDuel( int player_atk, int player_def, int player_life, int npc_ata, int npc_def, int npc_life, int hostile, CombatResult* result )
+{
+	int dealt = player_atk - npc_def > 0 ? player_atk - npc_def : 0;
+	int taken = npc_ata - player_def > 0 ? npc_ata - player_def : 0;
+	int turn, rolls = 0, outcome = COMBAT_STALEMATE;
+
+	for( turn = 1; turn <= COMBAT_MAX_TURNS; turn++ )
+	{
+		if( hostile )
+		{
+			if( npc_life - COMBAT_SURRENDER_LIFE <= 0 )
+				rolls++;
+			player_life -= taken;
+		}
+		else
+			hostile = 1;
+
+		npc_life -= dealt;
+
+		if( npc_life <= 0 )
+		{
+			outcome = player_life <= 0 ? COMBAT_TRADE : COMBAT_WIN;
+			break;
+		}
+		if( player_life <= 0 )
+		{
+			outcome = COMBAT_LOSS;
+			break;
+		}
+	}
+
+	result->dealt = dealt;
+	result->taken = taken;
+	result->turns = turn <= COMBAT_MAX_TURNS ? turn : COMBAT_MAX_TURNS;
+	result->outcome = outcome;
+	result->rolls = rolls;
+	result->life_left = player_life;
+	result->surrender = surrenderChance( rolls );
+}
+
+/**
+ * `endDuel` ajoute à `odds` les duels de probabilité `mass` terminés au tour
+ * `turn` sur l'issue `outcome`, avec `life` points de vie restants.
+ */
+static void endDuel( CombatOdds* odds, int turn, int outcome, int life, double mass )
+{
+	if( mass <= 0 )
+		return;
+
+	if( life < 0 )
+		life = 0;
+
+	odds->outcome[ outcome ] += mass;
+	odds->length[ turn < COMBAT_ODDS_TURNS ? turn : COMBAT_ODDS_TURNS - 1 ] += mass;
+	odds->life[ life < COMBAT_ODDS_LIFE ? life : COMBAT_ODDS_LIFE - 1 ] += mass;
+	odds->mean_turns += mass * turn;
+	odds->mean_life += mass * life;
+}
+
+/**
+ * `combatOdds` calcule la loi exacte de l'issue d'un duel où le joueur suit
+ * la conduite `tactic`, en reprenant les tirages de `npcResponse` face à un
+ * NPC hostile :
+ * - attaque : s'il reste au plus @ref COMBAT_SURRENDER_LIFE points de vie
+ *   au NPC, il se rend une fois sur deux, sans riposter ; le coup du joueur
+ *   peut encore l'achever ;
+ * - menace : si un coup peut l'achever, le NPC se rend trois fois sur
+ *   quatre ;
+ * - offre de `v` > 300 : le NPC accepte avec la probabilité
+ *   (`v` - 300 - s) / (`v` - 300), `s` étant son seuil de corruption
+ *   (@ref npcCorruptValue), et la refuse toujours sous `s` + 5.
+ *
+ * Chaque tirage met fin au duel ou le laisse se poursuivre de façon
+ * déterminée : la masse des duels encore en cours reste sur un seul état
+ * (points de vie des deux camps), que la récurrence avance d'un tour à la
+ * fois. Le calcul coûte donc un pas par tour, sans échantillonnage.
+ *
+ * Le joueur est considéré mort dès que ses points de vie tombent à 0, même
+ * si le jeu ne le constate qu'à l'attaque suivante. Les effets propres aux
+ * objets offerts (`processItem`) ne sont pas pris en compte, et une
+ * reddition met fin au duel.
+ * @param player_atk Attaque du joueur
+ * @param player_def Défense du joueur
+ * @param player_life Points de vie du joueur
+ * @param npc Le NPC, hostile si son statut vaut 1
+ * @param tactic La conduite du joueur (`COMBAT_TACTIC_*`)
+ * @param offer Valeur offerte par @ref COMBAT_TACTIC_BRIBE (`action_value` de l'objet)
+ * @param[out] odds La loi de l'issue du duel
+ */
+void combatOdds( int player_atk, int player_def, int player_life, const npc_stats* npc, int tactic, int offer, CombatOdds* odds )
+{
+	int dealt = player_atk - npc->def > 0 ? player_atk - npc->def : 0;
+	int taken = npc->ata - player_def > 0 ? npc->ata - player_def : 0;
+	int npc_life = npc->life, life = player_life;
+	int hostile = npc->status == 1, threatened = 0, offered = 0;
+	double mass = 1, p;
+	int turn;
+
+	memset( odds, 0, sizeof( *odds ) );
+
+	for( turn = 1; turn <= COMBAT_MAX_TURNS; turn++ )
+	{
+		int action = ATTACK;
+
+		if( hostile && tactic == COMBAT_TACTIC_THREAT && !threatened && npc_life - player_atk <= 0 )
+			action = TALK;
+		if( hostile && tactic == COMBAT_TACTIC_BRIBE && !offered )
+			action = ITEM;
+
+		if( action == ATTACK )
+		{
+			if( hostile )
+			{
+				p = npc_life - COMBAT_SURRENDER_LIFE <= 0 ? 0.5 : 0;
+				endDuel( odds, turn, npc_life - dealt <= 0 ? COMBAT_WIN : COMBAT_SURRENDERED, life, mass * p );
+				mass *= 1 - p;
+				life -= taken;
+			}
+			else
+				hostile = 1;
+
+			npc_life -= dealt;
+
+			if( npc_life <= 0 )
+			{
+				endDuel( odds, turn, life <= 0 ? COMBAT_TRADE : COMBAT_WIN, life, mass );
+				return;
+			}
+		}
+		else
+		{
+			if( action == TALK )
+			{
+				p = npc_life - player_atk <= 0 ? 0.75 : 0;
+				threatened = 1;
+			}
+			else
+			{
+				int temp = offer - 300, threshold = npcCorruptValue( npc->type );
+				p = offer > 300 && temp >= threshold + 5 ? ( double )( temp - threshold ) / temp : 0;
+				offered = 1;
+			}
+
+			endDuel( odds, turn, action == TALK ? COMBAT_SURRENDERED : COMBAT_BRIBED, life, mass * p );
+			mass *= 1 - p;
+			life -= taken;
+		}
+
+		if( life <= 0 )
+		{
+			endDuel( odds, turn, COMBAT_LOSS, life, mass );
+			return;
+		}
+		if( mass <= 0 )
+			return;
+	}
+
+	endDuel( odds, COMBAT_MAX_TURNS, COMBAT_STALEMATE, life, mass );
+}
+
+/**
+ * `combatBatchInit` alloue les colonnes d'un lot vide. Les colonnes sont
+ * arrondies à un multiple de @ref COMBAT_LANES ; les places libres
+ * contiennent un duel valide, évalué avec les autres puis ignoré.
+ * @param batch Le lot à initialiser
+ * @param capacity Le nombre maximal de duels
+ * @return 0 en cas de succès, -1 si l'allocation échoue
+ */
+int combatBatchInit( CombatBatch* batch, int capacity )
+{
+	int32_t** columns[] = {
+		&batch->player_atk, &batch->player_def, &batch->player_life,
+		&batch->npc_ata, &batch->npc_def, &batch->npc_life, &batch->hostile,
+		&batch->dealt, &batch->taken, &batch->turns, &batch->outcome,
+		&batch->rolls, &batch->life_left
+	};
+	int size = ( capacity + COMBAT_LANES - 1 ) / COMBAT_LANES * COMBAT_LANES;
+	size_t i;
+	int failed = 0;
+
+	memset( batch, 0, sizeof( *batch ) );
+
+	for( i = 0; i < sizeof( columns ) / sizeof( *columns ); i++ )
+	{
+		*columns[ i ] = calloc( size, sizeof( int32_t ) );
+		failed |= !*columns[ i ];
+	}
+	batch->surrender = calloc( size, sizeof( float ) );
+	failed |= !batch->surrender;
+
+	if( failed )
+	{
+		combatBatchFree( batch );
+		return -1;
+	}
+
+	for( i = 0; i < ( size_t )size; i++ )
+		batch->player_life[ i ] = batch->npc_life[ i ] = 1;
+
+	batch->capacity = capacity;
+	return 0;
+}
+
+/**
+ * `combatBatchAdd` ajoute un duel à la fin du lot. Les statistiques doivent
+ * être positives et ne pas dépasser @ref COMBAT_MAX_STAT, les points de vie
+ * strictement positifs.
+ * @return L'indice du duel, ou -1 si le lot est plein ou une statistique
+ * hors bornes
+ */
+int combatBatchAdd( CombatBatch* batch, int player_atk, int player_def, int player_life, int npc_ata, int npc_def, int npc_life, int hostile )
+{
+	int i = batch->count;
+
+	if( i >= batch->capacity )
+		return -1;
+	if( player_atk < 0 || player_def < 0 || player_life <= 0 || npc_ata < 0 || npc_def < 0 || npc_life <= 0
+		|| player_atk > COMBAT_MAX_STAT || player_def > COMBAT_MAX_STAT || player_life > COMBAT_MAX_STAT
+		|| npc_ata > COMBAT_MAX_STAT || npc_def > COMBAT_MAX_STAT || npc_life > COMBAT_MAX_STAT )
+		return -1;
+
+	batch->player_atk[ i ] = player_atk;
+	batch->player_def[ i ] = player_def;
+	batch->player_life[ i ] = player_life;
+	batch->npc_ata[ i ] = npc_ata;
+	batch->npc_def[ i ] = npc_def;
+	batch->npc_life[ i ] = npc_life;
+	batch->hostile[ i ] = hostile != 0;
+	batch->count++;
+	return i;
+}
+
+/**
+ * `evaluateColumns` évalue les `n` premiers duels, une colonne par tableau,
+ * par blocs de @ref COMBAT_LANES : le nombre de tours de la boucle interne
+ * étant connu, le compilateur la vectorise sans boucle de reste, même en
+ * `-O2`. Le dernier bloc déborde sur les places libres du lot.
+ */
+static void evaluateColumns( int n,
+	const int32_t* restrict player_atk, const int32_t* restrict player_def, const int32_t* restrict player_life,
+	const int32_t* restrict npc_ata, const int32_t* restrict npc_def, const int32_t* restrict npc_life,
+	const int32_t* restrict hostile,
+	int32_t* restrict dealt, int32_t* restrict taken, int32_t* restrict turns, int32_t* restrict outcome,
+	int32_t* restrict rolls, int32_t* restrict life_left, float* restrict surrender )
+{
+	int b, i;
+
+	for( b = 0; b < n; b += COMBAT_LANES )
+	{
+		for( i = b; i < b + COMBAT_LANES; i++ )
+		{
+			int32_t d = player_atk[ i ] - npc_def[ i ];
+			int32_t t = npc_ata[ i ] - player_def[ i ];
+			d = d > 0 ? d : 0;
+			t = t > 0 ? t : 0;
+
+			int32_t f = hostile[ i ] == 0;
+
+			/* tours où meurent le NPC et le joueur */
+			int32_t kn = ceilDiv( npc_life[ i ], d > 1 ? d : 1 );
+			int32_t kp = f + ceilDiv( player_life[ i ], t > 1 ? t : 1 );
+			kn = blend( ( d > 0 ) & ( kn < COMBAT_NEVER ), kn, COMBAT_NEVER );
+			kp = blend( ( t > 0 ) & ( kp < COMBAT_NEVER ), kp, COMBAT_NEVER );
+
+			int32_t k = kn < kp ? kn : kp;
+			k = k < COMBAT_MAX_TURNS ? k : COMBAT_MAX_TURNS;
+
+			/* premier tour où le NPC peut se rendre */
+			int32_t low = npc_life[ i ] - COMBAT_SURRENDER_LIFE;
+			int32_t ks = 1 + ceilDiv( low > 0 ? low : 0, d > 1 ? d : 1 );
+			ks = blend( ( low <= 0 ) | ( d > 0 ), ks, COMBAT_NEVER );
+			ks = ks > 1 + f ? ks : 1 + f;
+
+			int32_t r = k - ks + 1;
+			r = r > 0 ? r : 0;
+
+			int32_t hits = k - f;
+			hits = hits > 0 ? hits : 0;
+
+			int32_t tie = blend( kn < COMBAT_NEVER, COMBAT_TRADE, COMBAT_STALEMATE );
+
+			dealt[ i ] = d;
+			taken[ i ] = t;
+			turns[ i ] = k;
+			outcome[ i ] = blend( kn < kp, COMBAT_WIN, blend( kp < kn, COMBAT_LOSS, tie ) );
+			rolls[ i ] = r;
+			life_left[ i ] = player_life[ i ] - t * hits;
+			surrender[ i ] = surrenderChance( r );
+		}
+	}
+}
+
+/**
+ * `combatEvaluate` évalue tous les duels du lot. Pour chaque duel, avec `d`
+ * les dégâts du joueur, `t` ceux du NPC et `f` = 1 si le NPC ne riposte pas
+ * au premier tour :
+ * - le NPC meurt au tour `kn` = ⌈vie du NPC / d⌉ ;
+ * - le joueur meurt au tour `kp` = f + ⌈vie du joueur / t⌉ ;
+ * - le NPC peut se rendre aux tours où il riposte et où il lui reste au plus
+ *   @ref COMBAT_SURRENDER_LIFE points de vie, jusqu'à la fin du duel.
+ *
+ * Les résultats sont identiques à ceux de @ref combatDuel. Le calcul est
+ * fait par @ref evaluateColumns, dont les paramètres `restrict` garantissent
+ * au compilateur que les colonnes ne se chevauchent pas.
+ * @param batch Le lot à évaluer
+ */
+void combatEvaluate( CombatBatch* batch )
+{
+	evaluateColumns( batch->count,
+		batch->player_atk, batch->player_def, batch->player_life,
+		batch->npc_ata, batch->npc_def, batch->npc_life, batch->hostile,
+		batch->dealt, batch->taken, batch->turns, batch->outcome,
+		batch->rolls, batch->life_left, batch->surrender );
+}
+
+/**
+ * `combatBatchResult` rassemble les colonnes de sortie du duel `i`.
+ */
+void combatBatchResult( const CombatBatch* batch, int i, CombatResult* result )
+{
+	result->dealt = batch->dealt[ i ];
+	result->taken = batch->taken[ i ];
+	result->turns = batch->turns[ i ];
+	result->outcome = batch->outcome[ i ];
+	result->rolls = batch->rolls[ i ];
+	result->life_left = batch->life_left[ i ];
+	result->surrender = batch->surrender[ i ];
+}
+
+/**
+ * `combatBatchFree` libère les colonnes du lot et le remet à zéro.
+ */
+void combatBatchFree( CombatBatch* batch )
+{
+	free( batch->player_atk );
+	free( batch->player_def );
+	free( batch->player_life );
+	free( batch->npc_ata );
+	free( batch->npc_def );
+	free( batch->npc_life );
+	free( batch->hostile );
+	free( batch->dealt );
+	free( batch->taken );
+	free( batch->turns );
+	free( batch->outcome );
+	free( batch->rolls );
+	free( batch->life_left );
+	free( batch->surrender );
+	memset( batch, 0, sizeof( *batch ) );
+}
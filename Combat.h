@@ -0,0 +1,127 @@
+/**
+ * @file Combat.h
+ * @brief Évaluation des duels entre le joueur et un NPC : un duel isolé,
+ * tour par tour, et un noyau qui évalue d'un coup un grand nombre de duels
+ * rangés en colonnes (un tableau par statistique).
+ */
+#ifndef __COMBAT_H__
+#define __COMBAT_H__
+
+#include <stdint.h>
+
+#include "Npc.h"
+
+/// Nombre maximal de tours d'un duel ; au-delà, personne ne meurt
+#define COMBAT_MAX_TURNS 10000
+
+/// Valeur maximale d'une statistique dans un lot, pour que @ref combatEvaluate reste exact
+#define COMBAT_MAX_STAT ( 1 << 21 )
+
+/// Points de vie à partir desquels un NPC peut se rendre (argument passé à `npcResponse`)
+#define COMBAT_SURRENDER_LIFE 3
+
+/**
+ * Issues possibles d'un duel où le joueur attaque à chaque tour
+ */
+enum {
+	COMBAT_WIN, ///< Le NPC meurt, le joueur survit
+	COMBAT_TRADE, ///< Le NPC et le joueur meurent au même tour
+	COMBAT_LOSS, ///< Le joueur meurt avant le NPC
+	COMBAT_STALEMATE, ///< Personne ne meurt en @ref COMBAT_MAX_TURNS tours
+	COMBAT_SURRENDERED, ///< Le NPC se rend et survit (voir @ref combatOdds)
+	COMBAT_BRIBED, ///< Le NPC accepte l'offre du joueur (voir @ref combatOdds)
+	COMBAT_NB_OUTCOMES ///< Nombre d'issues
+};
+
+/**
+ * Conduites du joueur évaluées par @ref combatOdds. Tant que le NPC n'est
+ * pas hostile, le joueur l'attaque.
+ */
+enum {
+	COMBAT_TACTIC_ATTACK, ///< Attaquer à chaque tour
+	COMBAT_TACTIC_THREAT, ///< Menacer le NPC une fois, dès qu'un coup peut l'achever, attaquer sinon
+	COMBAT_TACTIC_BRIBE ///< Faire une offre au premier tour où le NPC est hostile, attaquer ensuite
+};
+
+/// Nombre de tours distingués dans @ref CombatOdds, le dernier regroupant les duels plus longs
+#define COMBAT_ODDS_TURNS 64
+/// Nombre de points de vie distingués dans @ref CombatOdds, le dernier regroupant les valeurs supérieures
+#define COMBAT_ODDS_LIFE 256
+
+/**
+ * @struct CombatResult
+ * @brief Résultat d'un duel. Le duel suppose que le NPC ne se rend jamais ;
+ * `rolls` compte les tours où il aurait pu se rendre.
+ */
+typedef struct
+{
+	int32_t dealt; ///< Dégâts infligés au NPC par attaque du joueur
+	int32_t taken; ///< Dégâts infligés au joueur par riposte du NPC
+	int32_t turns; ///< Durée du duel en tours
+	int32_t outcome; ///< Issue du duel (`COMBAT_*`)
+	int32_t rolls; ///< Nombre de tirages de reddition (une chance sur deux chacun)
+	int32_t life_left; ///< Points de vie du joueur à la fin du duel
+	float surrender; ///< Probabilité que le NPC se rende avant la fin du duel
+} CombatResult;
+
+/**
+ * @struct CombatBatch
+ * @brief Lot de duels rangés en colonnes : l'entrée `i` de chaque tableau
+ * décrit le duel `i`. Les tableaux d'entrée sont remplis par l'appelant,
+ * ceux de sortie par @ref combatEvaluate.
+ */
+typedef struct
+{
+	int count; ///< Nombre de duels
+	int capacity; ///< Nombre de duels alloués
+
+	/* entrées */
+	int32_t* player_atk; ///< Attaque du joueur
+	int32_t* player_def; ///< Défense du joueur
+	int32_t* player_life; ///< Points de vie du joueur, strictement positifs
+	int32_t* npc_ata; ///< Attaque du NPC
+	int32_t* npc_def; ///< Défense du NPC
+	int32_t* npc_life; ///< Points de vie du NPC, strictement positifs
+	int32_t* hostile; ///< Non nul si le NPC riposte dès le premier tour
+
+	/* sorties */
+	int32_t* dealt; ///< Voir @ref CombatResult
+	int32_t* taken; ///< Voir @ref CombatResult
+	int32_t* turns; ///< Voir @ref CombatResult
+	int32_t* outcome; ///< Voir @ref CombatResult
+	int32_t* rolls; ///< Voir @ref CombatResult
+	int32_t* life_left; ///< Voir @ref CombatResult
+	float* surrender; ///< Voir @ref CombatResult
+} CombatBatch;
+
+/**
+ * @struct CombatOdds
+ * @brief Loi exacte de l'issue d'un duel, calculée par @ref combatOdds
+ */
+typedef struct
+{
+	double outcome[ COMBAT_NB_OUTCOMES ]; ///< Probabilité de chaque issue (`COMBAT_*`)
+	double length[ COMBAT_ODDS_TURNS ]; ///< `length[ t ]` : probabilité que le duel se termine au tour `t`
+	double life[ COMBAT_ODDS_LIFE ]; ///< `life[ v ]` : probabilité qu'il reste `v` points de vie au joueur (0 s'il est mort)
+	double mean_turns; ///< Durée moyenne du duel
+	double mean_life; ///< Points de vie moyens du joueur à la fin du duel, morts comptés pour 0
+} CombatOdds;
+
+/// @brief Simule un duel tour par tour, selon les règles de `processAction`
+void combatDuel( int player_atk, int player_def, int player_life, int npc_ata, int npc_def, int npc_life, int hostile, CombatResult* result );
+
+/// @brief Calcule la loi exacte de l'issue d'un duel pour une conduite du joueur
+void combatOdds( int player_atk, int player_def, int player_life, const npc_stats* npc, int tactic, int offer, CombatOdds* odds );
+
+/// @brief Alloue un lot pouvant contenir `capacity` duels
+int combatBatchInit( CombatBatch* batch, int capacity );
+/// @brief Ajoute un duel au lot, renvoie son indice ou -1 si le lot est plein ou le duel invalide
+int combatBatchAdd( CombatBatch* batch, int player_atk, int player_def, int player_life, int npc_ata, int npc_def, int npc_life, int hostile );
+/// @brief Évalue tous les duels du lot
+void combatEvaluate( CombatBatch* batch );
+/// @brief Copie le résultat du duel `i` du lot
+void combatBatchResult( const CombatBatch* batch, int i, CombatResult* result );
+/// @brief Libère la mémoire du lot
+void combatBatchFree( CombatBatch* batch );
+
+#endif
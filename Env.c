@@ -0,0 +1,195 @@
+/**
+ * @file Env.c
+ * Environnements d'apprentissage. Chaque environnement est une partie du
+ * cœur du jeu jouée par @ref applyInput ; un pas ne fait aucune allocation
+ * et n'écrit que dans le tampon d'observations de l'appelant. La partie
+ * numéro `e` d'un environnement `i` est jouée avec le flux `e * count + i`
+ * de la graine du lot : un même lot rejoue les mêmes parties.
+ */
+#include "Env.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Préchargement des données partagées du jeu, fait une seule fois pour tous les lots
+static pthread_once_t Preload = PTHREAD_ONCE_INIT;
+
+/**
+ * `envObserve` écrit l'observation de la partie `game`.
+ */
+static void envObserve( const Gameplay_s* game, EnvObservation* obs )
+{
+	obs->area = game->area;
+	obs->state = game->state;
+	obs->hp = game->player_current_life;
+	obs->max_hp = game->player_max_life;
+	obs->atk = game->player_atk;
+	obs->def = game->player_def;
+	obs->gold = game->inventory.gold;
+	memcpy( obs->items, game->inventory.items, sizeof( obs->items ) );
+
+	if( ( game->state == STATE_INTERACTION || game->state == STATE_TALK )
+		&& game->index_current_npc >= 0 && game->index_current_npc < game->nb_npc )
+	{
+		const npc_stats* npc = &game->npcs[ game->index_current_npc ];
+		obs->npc_type = npc->type;
+		obs->npc_status = npc->status;
+		obs->npc_life = npc->life;
+	}
+	else
+		obs->npc_type = obs->npc_status = obs->npc_life = 0;
+
+	obs->reward = game->state == STATE_WON ? 1 : game->state == STATE_LOST ? -1 : 0;
+	obs->done = game->state == STATE_WON || game->state == STATE_LOST;
+	obs->invalid = 0;
+}
+
+/**
+ * `envDecode` convertit une action d'environnement en entrée du joueur.
+ * @return 0 si l'action existe, -1 sinon
+ */
+static int envDecode( int32_t action, Input* input )
+{
+	if( action == ENV_START )
+		*input = ( Input ){ INPUT_START, 0 };
+	else if( action >= ENV_ELEMENT && action < ENV_ACTION )
+		*input = ( Input ){ INPUT_ELEMENT, action - ENV_ELEMENT };
+	else if( action >= ENV_ACTION && action < ENV_SLOT )
+		*input = ( Input ){ INPUT_ACTION, action - ENV_ACTION };
+	else if( action >= ENV_SLOT && action < ENV_NB_ACTIONS )
+		*input = ( Input ){ INPUT_SLOT, action - ENV_SLOT };
+	else
+		return -1;
+	return 0;
+}
+
+/**
+ * `envRestart` commence la partie suivante de l'environnement `i`.
+ */
+static void envRestart( EnvBatch* batch, int i )
+{
+	Gameplay_s* game = batch->games[ i ];
+	seedGameplay( game, batch->seed, batch->episodes[ i ] * batch->count + i );
+	initGameplay( game );
+	batch->episodes[ i ]++;
+}
+
+/**
+ * `envCreate` crée `count` environnements. Les données partagées du jeu
+ * sont préchargées une seule fois, par le premier lot créé (voir
+ * @ref preloadGameData) : plusieurs lots peuvent ensuite être créés et
+ * pilotés depuis des fils différents. @ref closeGameData ne doit être
+ * appelée qu'une fois tous les lots détruits, et aucun lot ne doit plus
+ * être créé ensuite.
+ * @param count Le nombre d'environnements
+ * @param seed La graine du lot
+ * @return Le lot créé
+ */
+EnvBatch* envCreate( int count, uint64_t seed )
+{
+	pthread_once( &Preload, preloadGameData );
+
+	EnvBatch* batch = malloc( sizeof( EnvBatch ) );
+	batch->count = count;
+	batch->seed = seed;
+	batch->episodes = calloc( count, sizeof( uint64_t ) );
+	batch->games = malloc( sizeof( Gameplay_s* ) * count );
+
+	int i;
+	for( i = 0; i < count; i++ )
+	{
+		batch->games[ i ] = createGameplay();
+		envRestart( batch, i );
+	}
+
+	return batch;
+}
+
+/**
+ * `envDestroy` détruit les environnements du lot.
+ * @param batch Le lot
+ */
+void envDestroy( EnvBatch* batch )
+{
+	int i;
+	for( i = 0; i < batch->count; i++ )
+		destroyGameplay( batch->games[ i ] );
+
+	free( batch->games );
+	free( batch->episodes );
+	free( batch );
+}
+
+/**
+ * `envReset` commence une nouvelle partie dans chaque environnement.
+ * @param batch Le lot
+ * @param[out] obs Les `count` observations initiales
+ */
+void envReset( EnvBatch* batch, EnvObservation* obs )
+{
+	int i;
+	for( i = 0; i < batch->count; i++ )
+	{
+		envRestart( batch, i );
+		envObserve( batch->games[ i ], &obs[ i ] );
+	}
+}
+
+/**
+ * `envStep` applique `actions[i]` à l'environnement `i`. Une action
+ * impossible est ignorée et signalée dans l'observation. Un environnement
+ * dont la partie s'est terminée au pas précédent commence une nouvelle
+ * partie et ignore son action.
+ * @param batch Le lot
+ * @param actions Les `count` actions (`ENV_*`)
+ * @param[out] obs Les `count` observations
+ */
+void envStep( EnvBatch* batch, const int32_t* actions, EnvObservation* obs )
+{
+	int i;
+	for( i = 0; i < batch->count; i++ )
+	{
+		Gameplay_s* game = batch->games[ i ];
+		Input input;
+
+		if( game->state == STATE_WON || game->state == STATE_LOST )
+		{
+			envRestart( batch, i );
+			envObserve( game, &obs[ i ] );
+			continue;
+		}
+
+		int valid = envDecode( actions[ i ], &input ) == 0 && inputAllowed( game, input );
+		if( valid )
+			applyInput( game, input );
+
+		envObserve( game, &obs[ i ] );
+		obs[ i ].invalid = !valid;
+	}
+}
+
+/**
+ * `envLegalActions` écrit pour chaque environnement un masque de
+ * `ENV_NB_ACTIONS` octets valant 1 pour les actions possibles. Aucune
+ * action n'est possible dans une partie terminée : le pas suivant la
+ * recommence quelle que soit l'action.
+ * @param batch Le lot
+ * @param[out] mask `count * ENV_NB_ACTIONS` octets
+ */
+void envLegalActions( const EnvBatch* batch, uint8_t* mask )
+{
+	int i, a;
+	for( i = 0; i < batch->count; i++ )
+	{
+		const Gameplay_s* game = batch->games[ i ];
+		uint8_t* m = mask + ( size_t )i * ENV_NB_ACTIONS;
+
+		for( a = 0; a < ENV_NB_ACTIONS; a++ )
+		{
+			Input input;
+			envDecode( a, &input );
+			m[ a ] = inputAllowed( game, input );
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/**
+ * @file Env.h
+ * @brief Environnements d'apprentissage : un lot de parties pilotées
+ * ensemble par un tableau d'actions, chacune rendant une observation
+ * compacte dans un tampon fourni par l'appelant.
+ */
+#ifndef __ENV_H__
+#define __ENV_H__
+
+#include <stdint.h>
+
+#include "Gameplay.h"
+
+/// Nombre maximal d'éléments d'une zone adressables par une action
+#define ENV_MAX_ELEMENTS 32
+
+/**
+ * Actions d'un environnement, numérotées de 0 à `ENV_NB_ACTIONS - 1`
+ */
+enum {
+	ENV_START, ///< Commencer la partie
+	ENV_ELEMENT, ///< `ENV_ELEMENT + i` : cliquer sur l'élément `i` de la zone
+	ENV_ACTION = ENV_ELEMENT + ENV_MAX_ELEMENTS, ///< `ENV_ACTION + a` : action du joueur `a` (`ACTION_*`)
+	ENV_SLOT = ENV_ACTION + ACTION_TALK_QUIT + 1, ///< `ENV_SLOT + i` : case `i` de l'inventaire
+	ENV_NB_ACTIONS = ENV_SLOT + MAX_ITEM ///< Nombre d'actions
+};
+
+/**
+ * @struct EnvObservation
+ * @brief Observation d'un environnement après un pas, formée uniquement
+ * d'entiers 32 bits pour être lue comme un tableau
+ */
+typedef struct
+{
+	int32_t area; ///< Zone du joueur
+	int32_t state; ///< État du jeu (`STATE_*`)
+	int32_t hp, max_hp; ///< Points de vie du joueur
+	int32_t atk, def; ///< Attaque et défense du joueur
+	int32_t gold; ///< Pièces d'or
+	int32_t items[ MAX_ITEM ]; ///< Objets de l'inventaire
+	int32_t npc_type; ///< Type du NPC actif, 0 hors interaction
+	int32_t npc_status; ///< Statut du NPC actif
+	int32_t npc_life; ///< Points de vie du NPC actif
+	int32_t reward; ///< 1 pour une victoire, -1 pour une défaite, 0 sinon
+	int32_t done; ///< Non nul si la partie vient de se terminer
+	int32_t invalid; ///< Non nul si l'action était impossible (elle est ignorée)
+} EnvObservation;
+
+/**
+ * @struct EnvBatch
+ * @brief Lot de parties
+ */
+typedef struct
+{
+	int count; ///< Nombre de parties
+	uint64_t seed; ///< Graine commune, chaque partie ayant son propre flux
+	uint64_t* episodes; ///< Numéro de la partie en cours de chaque environnement
+	Gameplay_s** games; ///< Parties
+} EnvBatch;
+
+/// @brief Crée un lot de `count` environnements
+EnvBatch* envCreate( int count, uint64_t seed );
+/// @brief Détruit un lot d'environnements
+void envDestroy( EnvBatch* batch );
+/// @brief Recommence la partie de chaque environnement
+void envReset( EnvBatch* batch, EnvObservation* obs );
+/// @brief Applique une action à chaque environnement
+void envStep( EnvBatch* batch, const int32_t* actions, EnvObservation* obs );
+/// @brief Écrit le masque des actions possibles de chaque environnement
+void envLegalActions( const EnvBatch* batch, uint8_t* mask );
+
+#endif
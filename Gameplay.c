@@ -6,110 +6,448 @@
 
 #include "Gameplay.h"
 
+#include "Image.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Zone.h"
+
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/// Nombre maximal de zones (identifiants de 1 à `MAX_AREAS - 1`)
+#define MAX_AREAS 64
+
+/**
+ * Zone préchargée par @ref preloadGameData : la zone reste ouverte et les
+ * dimensions de ses sprites sont lues une seule fois pour toutes les parties.
+ */
+typedef struct {
+  int loaded; ///< Non nul si la zone a été préchargée
+  Zone zone; ///< Zone projetée ou lue en mémoire
+  Rect *sizes; ///< Dimensions de chaque sprite de la zone
+} CachedArea;
+
+/// Zones préchargées, partagées en lecture seule par toutes les parties
+static CachedArea Areas[MAX_AREAS];
+
+/**
+ * Les actions des 4 boutons du menu (attaque, discussion, objet,
+ * déplacement) dans chaque état de jeu. C’est aussi la liste des actions
+ * possibles dans cet état (voir @ref listInputs).
+ */
+const int StateActions[NB_STATES][4] = {
+	[STATE_START] = {-1, -1, -1, -1},
+	[STATE_EXPLORATION] = {-1, -1, ACTION_INVENTORY, -1},
+	[STATE_INTERACTION] = {ACTION_ATTACK, ACTION_TALK, ACTION_INVENTORY,
+						   ACTION_MOVE},
+	[STATE_INVENTORY] = {ACTION_INV_USE, ACTION_INV_EQUIP, ACTION_INV_THROW,
+						 ACTION_INV_QUIT},
+	[STATE_TALK] = {ACTION_TALK_YES, ACTION_TALK_NO, ACTION_TALK_THREAT,
+					ACTION_TALK_QUIT},
+	[STATE_WON] = {-1, -1, -1, -1},
+	[STATE_LOST] = {-1, -1, -1, -1}};
+
+/**
+ * `openZone` ouvre la zone `area` : sa version compilée `Data/ZoneN.bin` si
+ * elle existe et est à jour (voir `make zones`), sinon `Data/ZoneN.txt`. La
+ * version compilée est périmée quand le texte a été modifié après elle.
+ *
+ * @param[out] zone La zone ouverte
+ * @param area Identifiant de la zone
+ * @return 0 si la zone a été ouverte, -1 sinon
+ */
+static int openZone(Zone *zone, int area) {
+  char bin_path[64], txt_path[64];
+  struct stat bin_stat, txt_stat;
+
+  sprintf(bin_path, "Data/Zone%d.bin", area);
+  sprintf(txt_path, "Data/Zone%d.txt", area);
+
+  int stale = stat(txt_path, &txt_stat) == 0 && stat(bin_path, &bin_stat) == 0 &&
+			  txt_stat.st_mtime > bin_stat.st_mtime;
+  if (stale)
+	logWarn("%s is older than %s, run make zones", bin_path, txt_path);
+  else {
+	metricAdd(METRIC_FILE_OPENS, 1);
+	if (zoneLoadBinary(zone, bin_path) == 0)
+	  return 0;
+  }
+
+  metricAdd(METRIC_FILE_OPENS, 1);
+  return zoneLoadText(zone, txt_path);
+}
 
 /**
- * `initGameplay` initialise la variable globale @ref Gameplay avec ses valeurs
- * par défaut.
+ * `preloadGameData` charge les données que les parties partagent en lecture
+ * seule : le catalogue des objets, toutes les zones avec les dimensions de
+ * leurs sprites et les fiches des NPC. Les parties créées ensuite ne lisent
+ * plus aucun fichier. Cette fonction doit être appelée avant de lancer des
+ * parties dans plusieurs fils ; sans elle, chaque chargement de zone et
+ * chaque rencontre relisent leurs fichiers.
  */
-void initGameplay() {
+void preloadGameData() {
   initItems();
+  npcPreload();
+
+  int area;
+  for (area = 1; area < MAX_AREAS; area++) {
+	CachedArea *cached = &Areas[area];
+	if (cached->loaded || openZone(&cached->zone, area) != 0)
+	  continue;
+
+	cached->sizes = malloc(sizeof(Rect) * (cached->zone.nb_sprites + 1));
+	metricAdd(METRIC_HEAP_ALLOCS, 1);
+
+	int i;
+	for (i = 0; i < cached->zone.nb_sprites; i++) {
+	  const char *name = zoneSprite(&cached->zone, i);
+	  if (imageSize(name, &cached->sizes[i].w, &cached->sizes[i].h) != 0) {
+		logError("%s not found", name);
+		assert(0);
+	  }
+	}
+
+	cached->loaded = 1;
+  }
+}
+
+/**
+ * `closeGameData` libère les données chargées par @ref preloadGameData.
+ * Aucune partie ne doit plus être en cours.
+ */
+void closeGameData() {
+  int area;
+  for (area = 1; area < MAX_AREAS; area++) {
+	if (Areas[area].loaded) {
+	  zoneClose(&Areas[area].zone);
+	  free(Areas[area].sizes);
+	}
+  }
+  memset(Areas, 0, sizeof(Areas));
+
+  npcUnload();
+  closeItems();
+}
+
+/**
+ * `createGameplay` alloue une nouvelle partie et l’initialise avec
+ * @ref initGameplay. Le catalogue partagé des objets est chargé au premier
+ * appel ; un programme qui crée des parties depuis plusieurs fils doit
+ * appeler @ref initItems avant de les lancer.
+ *
+ * @return La partie créée
+ */
+Gameplay_s *createGameplay() {
+  initItems();
+
+  Gameplay_s *game = calloc(1, sizeof(*game));
+  assert(game);
+  metricAdd(METRIC_HEAP_ALLOCS, 1);
+  metricAdd(METRIC_LIVE_GAMES, 1);
 
-  PlayerLife = &Gameplay.player_current_life;
-  PlayerAta = &Gameplay.player_atk;
-  PlayerDef = &Gameplay.player_def;
-
-  Gameplay.state = STATE_START;
-  Gameplay.elements = NULL;
-  Gameplay.nb_elements = 0;
-  Gameplay.player_max_life = 120;
-  Gameplay.player_current_life = 120;
-  Gameplay.player_atk = 20;
-  Gameplay.player_def = 5;
-  Gameplay.items = inventoryInit();
-  Gameplay.selected_item = 0;
-  Gameplay.index_selected_item = -1;
-  Gameplay.stuff[0] = 50;
-  Gameplay.stuff[1] = 39;
-  Gameplay.gold = START_GOLD;
-
-  Gameplay.npcs = NULL;
-  Gameplay.nb_npc = 0;
-
-  Gameplay.no_leave = 0;
-
-  loadArea(7);
+  initGameplay(game);
+  return game;
 }
 
 /**
- * `cleanArea` permet de libérer la mémoire des éléments affichés à l’écran et
- * permet de décharger la zone.\n Attention, d’éventuels pointeurs vers des
- * objets se situants dans `Gameplay.elements` seront invalides après exécution
- * de cette fonction
+ * `destroyGameplay` libère toute la mémoire d’une partie créée par
+ * @ref createGameplay.
+ *
+ * @param game La partie à détruire
+ */
+void destroyGameplay(Gameplay_s *game) {
+  arenaFree(&game->arena);
+  arenaFree(&game->zone_arena);
+  gridFree(&game->grid);
+  free(game);
+  metricAdd(METRIC_LIVE_GAMES, -1);
+}
+
+/**
+ * `initGameplay` remet la partie `game` à ses valeurs par défaut et charge
+ * la zone de départ. Les arènes et la grille de la partie précédente sont
+ * réutilisées. Le générateur repart de la graine de la partie : la même
+ * suite d’entrées rejoue la même partie.
+ *
+ * @param game La partie à initialiser
+ */
+void initGameplay(Gameplay_s *game) {
+  arenaReset(&game->arena);
+
+  game->state = STATE_START;
+  game->player_max_life = 120;
+  game->player_current_life = 120;
+  game->player_atk = 20;
+  game->player_def = 5;
+  inventoryInit(&game->inventory);
+  game->selected_item = 0;
+  game->index_selected_item = -1;
+  game->stuff[0] = 50;
+  game->stuff[1] = 39;
+
+  memset(game->dialogs, 0, sizeof(game->dialogs));
+  game->dialog_generation++;
+
+  game->npcs = NULL;
+  game->nb_npc = 0;
+  game->cap_npc = 0;
+  memset(game->npc_data, 0, sizeof(game->npc_data));
+
+  game->end_cause = END_NONE;
+  game->no_leave = 0;
+
+  rngSeed(&game->rng, game->rng.seed, game->rng.stream);
+
+  loadArea(game, 7);
+}
+
+/**
+ * `seedGameplay` donne à la partie sa graine et son flux pseudo-aléatoires
+ * (voir @ref rngSeed) et repart du début de leur suite. Tous les tirages du
+ * jeu (combats, dialogues, récompenses) en dépendent ; la graine est
+ * conservée dans `game->rng.seed` pour pouvoir rejouer la partie.
+ *
+ * @param game La partie en cours
+ * @param seed La graine
+ * @param stream Le flux, par exemple le numéro de la partie d’une simulation
+ */
+void seedGameplay(Gameplay_s *game, uint64_t seed, uint64_t stream) {
+  rngSeed(&game->rng, seed, stream);
+}
+
+/**
+ * `cleanArea` permet de libérer la mémoire des éléments de la zone et
+ * permet de décharger la zone. L’arène de la zone est remise à zéro en temps
+ * constant.\n Attention, d’éventuels pointeurs vers les tableaux de
+ * `game->elements` seront invalides après exécution de cette fonction
+ *
+ * @param game La partie en cours
  */
-void cleanArea() {
-  free(Gameplay.elements);
-  Gameplay.elements = NULL;
-  Gameplay.nb_elements = 0;
+void cleanArea(Gameplay_s *game) {
+  arenaReset(&game->zone_arena);
+
+  memset(&game->elements, 0, sizeof(game->elements));
+  gridInvalidate(&game->grid);
+}
+
+/**
+ * `reserveElements` garantit que les tableaux de `game->elements` peuvent
+ * contenir `capacity` éléments. Les tableaux sont réalloués dans l’arène de
+ * la zone s’ils sont trop petits.
+ *
+ * @param game La partie en cours
+ * @param capacity Nombre d’éléments à pouvoir stocker
+ */
+static void reserveElements(Gameplay_s *game, int capacity) {
+  ElementTable *t = &game->elements;
+  if (capacity <= t->capacity)
+	return;
+
+  Arena *arena = &game->zone_arena;
+  Rect *rects = arenaAlloc(arena, sizeof(*rects) * capacity);
+  int *types = arenaAlloc(arena, sizeof(int) * capacity);
+  int *values = arenaAlloc(arena, sizeof(int) * capacity);
+  int *keys = arenaAlloc(arena, sizeof(int) * capacity);
+  int *sprites = arenaAlloc(arena, sizeof(int) * capacity);
+
+  if (t->count) {
+	memcpy(rects, t->rects, sizeof(*rects) * t->count);
+	memcpy(types, t->types, sizeof(int) * t->count);
+	memcpy(values, t->values, sizeof(int) * t->count);
+	memcpy(keys, t->keys, sizeof(int) * t->count);
+	memcpy(sprites, t->sprites, sizeof(int) * t->count);
+  }
+
+  t->rects = rects;
+  t->types = types;
+  t->values = values;
+  t->keys = keys;
+  t->sprites = sprites;
+  t->visible = arenaAlloc(arena, sizeof(int) * capacity);
+  t->capacity = capacity;
+}
+
+/**
+ * `appendSprite` ajoute le sprite `name` à la fin de la table des sprites de
+ * la zone. Si `size` est donné, le nom et les dimensions viennent d’une zone
+ * préchargée qui survit à la partie : le nom n’est pas copié et l’image
+ * n’est pas lue. Sinon le nom est copié dans l’arène de la zone et les
+ * dimensions sont lues dans l’image.
+ *
+ * @param game La partie en cours
+ * @param name Nom du sprite
+ * @param size Dimensions du sprite, ou NULL pour les lire dans l’image
+ * @return Indice du sprite
+ */
+static int appendSprite(Gameplay_s *game, const char *name, const Rect *size) {
+  ElementTable *t = &game->elements;
+  int i = t->nb_sprites;
+
+  Arena *arena = &game->zone_arena;
+  if (t->nb_sprites == t->cap_sprites) {
+	int cap = t->cap_sprites ? t->cap_sprites * 2 : 8;
+	const char **names = arenaAlloc(arena, sizeof(*names) * cap);
+	Rect *sizes = arenaAlloc(arena, sizeof(*sizes) * cap);
+
+	if (t->nb_sprites) {
+	  memcpy(names, t->sprite_names, sizeof(*names) * t->nb_sprites);
+	  memcpy(sizes, t->sprite_sizes, sizeof(*sizes) * t->nb_sprites);
+	}
+
+	t->sprite_names = names;
+	t->sprite_sizes = sizes;
+	t->cap_sprites = cap;
+  }
+
+  if (size) {
+	t->sprite_names[i] = name;
+	t->sprite_sizes[i] = *size;
+  } else {
+	char *copy = arenaAlloc(arena, strlen(name) + 1);
+	strcpy(copy, name);
+
+	t->sprite_names[i] = copy;
+	if (imageSize(copy, &t->sprite_sizes[i].w, &t->sprite_sizes[i].h) != 0) {
+	  logError("%s not found", copy);
+	  assert(0);
+	}
+  }
+  t->nb_sprites++;
+
+  return i;
+}
+
+/**
+ * `internSprite` renvoie l’indice du sprite `name` dans la table des sprites
+ * de la zone. Un sprite absent de la table y est ajouté et les dimensions de
+ * son image sont lues ; chaque image n’est ainsi lue qu’une fois par zone.
+ *
+ * @param game La partie en cours
+ * @param name Nom du sprite
+ * @return Indice du sprite
+ */
+static int internSprite(Gameplay_s *game, const char *name) {
+  ElementTable *t = &game->elements;
+
+  int i;
+  for (i = 0; i < t->nb_sprites; i++) {
+	if (strcmp(t->sprite_names[i], name) == 0)
+	  return i;
+  }
+
+  return appendSprite(game, name, NULL);
 }
 
 /**
  * `loadArea` charge la zone de jeu correspondant à son identifiant donné par
- * argument et l’affiche à l’écran.
+ * argument. La zone préchargée par @ref preloadGameData est utilisée si elle
+ * existe ; sinon la version compilée `Data/ZoneN.bin` ou `Data/ZoneN.txt`
+ * est lue (voir `openZone`). Les tableaux d’éléments sont alloués en une
+ * seule fois et chaque sprite n’est lu qu’une fois. `game->zone_generation`
+ * change pour signaler au client graphique de recharger ses images.
  *
+ * @param game La partie en cours
  * @param area Identifiant de la zone à charger
  */
-void loadArea(int area) {
-  char path[64];
-  sprintf(path, "Data/Zone%d.txt", area);
-
-  FILE *file = fopen(path, "r");
-  if (!file) {
-	printf("%s : not found", path);
+void loadArea(Gameplay_s *game, int area) {
+  const CachedArea *cached = NULL;
+  Zone local;
+  const Zone *zone = &local;
+
+  if (area > 0 && area < MAX_AREAS && Areas[area].loaded) {
+	cached = &Areas[area];
+	zone = &cached->zone;
+  } else if (openZone(&local, area) != 0) {
+	logError("Zone%d not found", area);
 	assert(0);
   }
 
-  cleanArea();
+  cleanArea(game);
 
-  while (!feof(file)) {
-	Element elem;
-	fscanf(file, "%d %s %d %d %d %d\n", &elem.type, elem.name, &elem.rect.x,
-		   &elem.rect.y, &elem.value, &elem.value2);
+  ElementTable *t = &game->elements;
+  reserveElements(game, zone->nb_elements);
 
-	addElement(elem);
+  /* sprites de la zone, dans l’ordre de sa table des sprites, déjà uniques */
+  int i;
+  for (i = 0; i < zone->nb_sprites; i++)
+	appendSprite(game, zoneSprite(zone, i), cached ? &cached->sizes[i] : NULL);
+
+  for (i = 0; i < zone->nb_elements; i++) {
+	const ZoneElement *src = &zone->elements[i];
+
+	t->types[i] = src->type;
+	t->values[i] = src->value;
+	t->keys[i] = src->value2;
+	t->sprites[i] = src->sprite;
+	t->rects[i] = t->sprite_sizes[src->sprite];
+	t->rects[i].x = src->x;
+	t->rects[i].y = src->y;
   }
+  t->count = zone->nb_elements;
 
-  char file_name[12];
-  sprintf(file_name, "Zone%d", area);
+  if (!cached)
+	zoneClose(&local);
 
-  loadImage(file_name, &Gameplay.bg_tex[0], &Gameplay.bg_rect[0]);
+  gridBuild(&game->grid, t->rects, t->count);
 
-  sprintf(file_name, "IZone%d", area);
-  loadImage(file_name, &Gameplay.bg_tex[1], &Gameplay.bg_rect[1]);
+  game->area = area;
+  game->zone_generation++;
+  metricAdd(METRIC_ZONE_LOADS, 1);
+}
 
-  Gameplay.area = area;
+/**
+ * `areaElementCount` renvoie le nombre d’éléments de la zone `area`, sans
+ * rien modifier : avant @ref loadArea, elle permet de vérifier qu’une zone
+ * existe, par exemple celle d’une sauvegarde.
+ *
+ * @param area Identifiant de la zone
+ * @return Le nombre d’éléments de la zone, -1 si elle n’existe pas
+ */
+int areaElementCount(int area) {
+  Zone zone;
+
+  if (area <= 0)
+	return -1;
+  if (area < MAX_AREAS && Areas[area].loaded)
+	return Areas[area].zone.nb_elements;
+  if (openZone(&zone, area) != 0)
+	return -1;
+
+  int count = zone.nb_elements;
+  zoneClose(&zone);
+  return count;
 }
 
 /**
- * Ajoute l’élément passé par argument à la liste des éléments de la zone
- * et l’affiche. Attention, des pointeurs sur `Gameplay.elements` peuvent
- * être invalidés par la fonction.
+ * Ajoute l’élément passé par argument à la liste des éléments de la zone.
+ * Seuls la position et le nom de sprite de `elem` sont lus, ses dimensions
+ * viennent du sprite. Attention, des pointeurs sur les tableaux de
+ * `game->elements` peuvent être invalidés par la fonction.
  *
+ * @param game La partie en cours
  * @param elem Élément à rajouter à la zone actuelle
  */
-void addElement(Element elem) {
-  elem.tex = NULL;
-  loadImage(elem.name, &elem.tex, &elem.rect);
+void addElement(Gameplay_s *game, Element elem) {
+  ElementTable *t = &game->elements;
 
-  int size = Gameplay.nb_elements;
-  Element *elems = Gameplay.elements;
+  if (t->count == t->capacity)
+	reserveElements(game, t->capacity ? t->capacity * 2 : 8);
 
-  elems = realloc(elems, sizeof(*elems) * (size + 1));
-  elems[size] = elem;
+  int sprite = internSprite(game, elem.name);
+  int i = t->count++;
 
-  Gameplay.elements = elems;
-  Gameplay.nb_elements = size + 1;
+  t->types[i] = elem.type;
+  t->values[i] = elem.value;
+  t->keys[i] = elem.value2;
+  t->sprites[i] = sprite;
+  t->rects[i] = t->sprite_sizes[sprite];
+  t->rects[i].x = elem.rect.x;
+  t->rects[i].y = elem.rect.y;
+
+  gridInvalidate(&game->grid);
 }
 
 /**
@@ -122,7 +460,7 @@ void addElement(Element elem) {
  * @param y_mouse Position verticale de la souris
  * @return Retourne 1 si la souris se situe sur le canevas, 0 sinon
  */
-int intersects(SDL_Rect rect, int x_mouse, int y_mouse) {
+int intersects(Rect rect, int x_mouse, int y_mouse) {
   if (x_mouse >= rect.x && x_mouse <= rect.x + rect.w && y_mouse >= rect.y &&
 	  y_mouse <= rect.y + rect.h)
 	return 1;
@@ -130,131 +468,282 @@ int intersects(SDL_Rect rect, int x_mouse, int y_mouse) {
 }
 
 /**
- * `elementTriggered` teste si un élément de l’écran est activé selon la
- * position de la souris passée en argument dans la fonction. Chaque élément
- * à l’écran sera successivement testé jusqu’à ce qu’un élément ne soit en
- * effet activé par le joueur.
+ * `elementHidden` teste si l’élément d’indice `i` doit être ignoré, c’est à
+ * dire s’il représente un NPC mort. Ces éléments ne sont ni affichés ni
+ * activables.
  *
+ * @param game La partie en cours
+ * @param i Indice de l’élément dans `game->elements`
+ * @return Retourne 1 si l’élément est masqué, 0 sinon
+ */
+int elementHidden(const Gameplay_s *game, int i) {
+  const ElementTable *t = &game->elements;
+  if (t->types[i] != 0)
+	return 0;
+
+  int j;
+  for (j = 0; j < game->nb_npc; j++) {
+	if ((int)game->npcs[j].type == t->values[i] &&
+		game->npcs[j].unique_id == t->keys[i])
+	  return encounterEnd(game->npcs[j]);
+  }
+
+  return 0;
+}
+
+/**
+ * `cullElements` retient, dans l’ordre d’affichage, les éléments non masqués
+ * dont le canevas chevauche `view`. Seul le tableau contigu des canevas est
+ * parcouru pour écarter les éléments hors de la vue.
+ *
+ * @param game La partie en cours
+ * @param view Canevas de la vue
+ * @return Nombre d’éléments retenus dans `game->elements.visible`
+ */
+int cullElements(Gameplay_s *game, Rect view) {
+  ElementTable *t = &game->elements;
+  int i, n = 0;
+
+  /* sans branchement : l’indice est toujours écrit, le compteur n’avance
+	 que si l’élément chevauche la vue */
+  for (i = 0; i < t->count; i++) {
+	const Rect *r = &t->rects[i];
+	t->visible[n] = i;
+	n += (r->x < view.x + view.w) & (r->x + r->w > view.x) &
+		 (r->y < view.y + view.h) & (r->y + r->h > view.y);
+  }
+
+  int k, m = 0;
+  for (k = 0; k < n; k++) {
+	if (!elementHidden(game, t->visible[k]))
+	  t->visible[m++] = t->visible[k];
+  }
+
+  return m;
+}
+
+/**
+ * `elementAt` renvoie l’élément visible le plus haut dans l’ordre d’affichage
+ * se trouvant sous la souris. Seuls les éléments de la cellule de
+ * `game->grid` contenant la souris sont testés ; la grille est reconstruite
+ * au préalable si la liste des éléments a changé.
+ *
+ * @param game La partie en cours
  * @param x Position horizontale de la souris
  * @param y Position verticale de la souris
- * @return Retourne 1 si un élément a été activé, 0 sinon
+ * @return Indice de l’élément dans `game->elements`, -1 si aucun
  */
-int elementTriggered(int x, int y) {
+int elementAt(Gameplay_s *game, int x, int y) {
+  if (game->grid.dirty)
+	gridBuild(&game->grid, game->elements.rects, game->elements.count);
+
+  const int *candidates;
+  int n = gridCell(&game->grid, x, y, &candidates);
+
   int i;
-  for (i = 0; i < Gameplay.nb_elements; i++) {
-	if (intersects(Gameplay.elements[i].rect, x, y)) {
-	  processElement(i);
-	  return 1;
-	}
+  for (i = 0; i < n; i++) {
+	int index = candidates[i];
+	if (intersects(game->elements.rects[index], x, y) &&
+		!elementHidden(game, index))
+	  return index;
   }
 
-  return 0;
+  return -1;
 }
 
 /**
- * `buttonTriggered` teste si un bouton du menu a été activé ou non selon la
- * position de la souris au moment de l’appel de la fonction. En mode
- * exploration, le seul bouton disponible est celui de l’inventaire, sinon
- * tous les boutons sont successivement testés. Si un bouton est
- * effectivemenent activé, les boutons suivants ne le seront pas.
+ * `elementTriggered` teste si un élément de l’écran est activé selon la
+ * position de la souris passée en argument dans la fonction. L’élément
+ * activé est le plus haut dans l’ordre d’affichage parmi ceux qui sont sous
+ * la souris (voir @ref elementAt).
  *
+ * @param game La partie en cours
  * @param x Position horizontale de la souris
  * @param y Position verticale de la souris
- * @param rects Liste des boutons du menu
- * @return Retourne 1 is un bouton a été activé, 0 sinon
+ * @return Retourne 1 si un élément a été activé, 0 sinon
  */
-int buttonTriggered(int x, int y, SDL_Rect rects[]) {
-  int i;
-  for (i = 0; i < 4; i++) {
-	if (Gameplay.state == STATE_EXPLORATION && i != 2)
-	  continue;
+int elementTriggered(Gameplay_s *game, int x, int y) {
+  int i = elementAt(game, x, y);
+  if (i < 0)
+	return 0;
+
+  processElement(game, i);
+  return 1;
+}
 
-	if (intersects(rects[i], x, y)) {
-	  if (Gameplay.state == STATE_INVENTORY)
-		processAction(i + 4);
-	  else if (Gameplay.state == STATE_TALK)
-		processAction(i + 8);
-	  else
-		processAction(i);
+/**
+ * `selectItem` marque comme sélectionné l’objet se trouvant dans la case
+ * `index` de l’inventaire du joueur.
+ *
+ * @param game La partie en cours
+ * @param index Case de l’inventaire sélectionnée
+ */
+void selectItem(Gameplay_s *game, int index) {
+  game->selected_item = game->inventory.items[index];
+  game->index_selected_item = index;
+}
 
-	  return 1;
+/**
+ * `listInputs` écrit dans `inputs` les entrées que le joueur peut donner
+ * dans l’état courant, celles que l’interface graphique rend cliquables :
+ * les éléments visibles de la zone en exploration, les cases non vides de
+ * l’inventaire et les boutons actifs de l’état (voir @ref StateActions).
+ * Aucune entrée n’est possible une fois la partie terminée.
+ *
+ * @param game La partie en cours
+ * @param[out] inputs Tableau recevant les entrées possibles
+ * @param max Taille du tableau `inputs`
+ * @return Le nombre d’entrées écrites
+ */
+int listInputs(const Gameplay_s *game, Input *inputs, int max) {
+  int n = 0, i;
+
+  if (game->state == STATE_START) {
+	if (max > 0)
+	  inputs[n++] = (Input){INPUT_START, 0};
+	return n;
+  }
+
+  if (game->state == STATE_EXPLORATION) {
+	for (i = 0; i < game->elements.count && n < max; i++) {
+	  if (!elementHidden(game, i))
+		inputs[n++] = (Input){INPUT_ELEMENT, i};
 	}
   }
 
-  return 0;
+  if (game->state == STATE_INVENTORY) {
+	for (i = 0; i < MAX_ITEM && n < max; i++) {
+	  if (game->inventory.items[i] != 0)
+		inputs[n++] = (Input){INPUT_SLOT, i};
+	}
+  }
+
+  if (game->state >= 0 && game->state < NB_STATES) {
+	for (i = 0; i < 4 && n < max; i++) {
+	  if (StateActions[game->state][i] != -1)
+		inputs[n++] = (Input){INPUT_ACTION, StateActions[game->state][i]};
+	}
+  }
+
+  return n;
 }
 
 /**
- * `itemTriggered` marque un objet comme étant sélectionné si ce dernier se
- * trouve sous la souris au moment de l’appel de la fonction. Chaque objet est
- * testé jusqu’à ce qu’un objet soit en effet sous la souris et sélectionné.
+ * `inputAllowed` indique si l’entrée `input` fait partie des entrées
+ * possibles dans l’état courant (voir @ref listInputs), sans les énumérer.
  *
- * @param x Position horizontale de la souris
- * @param y Position verticale de la souris
- * @param rects Liste des objets affichés à l’écran
- * @return Retourne 1 si un objet a été sélectionné, 0 sinon
+ * @param game La partie en cours
+ * @param input L’entrée à tester
+ * @return Non nul si l’entrée est possible
  */
-int itemTriggered(int x, int y, SDL_Rect rects[]) {
+int inputAllowed(const Gameplay_s *game, Input input) {
   int i;
-  for (i = 0; i < MAX_ITEM; i++) {
-	if (intersects(rects[i], x, y)) {
-	  Gameplay.selected_item = Gameplay.items[i];
-	  Gameplay.index_selected_item = i;
-	  return 1;
+
+  switch (input.kind) {
+  case INPUT_START:
+	return game->state == STATE_START;
+  case INPUT_ELEMENT:
+	return game->state == STATE_EXPLORATION && input.value >= 0 &&
+		   input.value < game->elements.count &&
+		   !elementHidden(game, input.value);
+  case INPUT_SLOT:
+	return game->state == STATE_INVENTORY && input.value >= 0 &&
+		   input.value < MAX_ITEM && game->inventory.items[input.value] != 0;
+  case INPUT_ACTION:
+	if (game->state < 0 || game->state >= NB_STATES || input.value < 0)
+	  return 0;
+	for (i = 0; i < 4; i++) {
+	  if (StateActions[game->state][i] == input.value)
+		return 1;
 	}
+	return 0;
   }
 
   return 0;
 }
 
+/**
+ * `applyInput` applique une entrée du joueur comme le ferait le clic
+ * correspondant dans l’interface graphique. Une entrée que
+ * @ref inputAllowed refuse, venue par exemple d’un journal modifié, n’est
+ * pas appliquée : elle pourrait viser un NPC ou un élément absents.
+ *
+ * @param game La partie en cours
+ * @param input Entrée à appliquer, en principe donnée par @ref listInputs
+ * @return 0 si l’entrée a été appliquée, -1 si elle n’est pas possible
+ */
+int applyInput(Gameplay_s *game, Input input) {
+  if (!inputAllowed(game, input))
+	return -1;
+
+  switch (input.kind) {
+  case INPUT_START:
+	game->state = STATE_EXPLORATION;
+	break;
+  case INPUT_ELEMENT:
+	processElement(game, input.value);
+	break;
+  case INPUT_ACTION:
+	processAction(game, input.value);
+	break;
+  case INPUT_SLOT:
+	selectItem(game, input.value);
+	break;
+  }
+  return 0;
+}
+
 /**
  * `processElement` gère l’élément se situant à l’index spécifié en argument
- * dans la liste des éléments de la variable globale @ref Gameplay. Si le type
+ * dans la liste des éléments de la partie `game`. Si le type
  * de l’élément a pour valeur `1`, alors il s’agit d’une zone à charger ; sinon
  * il s’agit d’un élément de la zone qui est à gérer. Le jeu passe alors en
  * mode interactif. Si l’élément passé par argument correspond à un NPC, alors
  * une interaction avec le NPC est lancée. Sinon le NPC correspondant est
  * rajouté à la scène.
- * \n Attention, les pointeurs éventuels sur `Gameplay.npcs` peuvent être
+ * \n Attention, les pointeurs éventuels sur `game->npcs` peuvent être
  * invalidés après appel de la fonction.
  *
+ * @param game La partie en cours
  * @param element_index Numéro de l’élément à gérer dans la fonction
  */
-void processElement(int element_index) {
-  Element elem = Gameplay.elements[element_index];
+void processElement(Gameplay_s *game, int element_index) {
+  int type = game->elements.types[element_index];
+  int value = game->elements.values[element_index];
+  int key = game->elements.keys[element_index];
 
-  if (elem.type == 0) {
-	Gameplay.state = STATE_INTERACTION;
-	Gameplay.interaction_index = element_index;
+  if (type == 0) {
+	game->state = STATE_INTERACTION;
+	game->interaction_index = element_index;
 
 	int i;
-	for (i = 0; i < Gameplay.nb_npc; i++) {
-	  if (Gameplay.npcs[i].type == elem.value &&
-		  elem.value2 == Gameplay.npcs[i].unique_id) {
-		Gameplay.index_current_npc = i;
-		Gameplay.npcs[i].status =
-			npcResponse(&Gameplay.npcs[i], NONE, 0, Gameplay.name);
+	for (i = 0; i < game->nb_npc; i++) {
+	  if ((int)game->npcs[i].type == value &&
+		  key == game->npcs[i].unique_id) {
+		game->index_current_npc = i;
+		game->npcs[i].status =
+			npcResponse(game, &game->npcs[i], NONE, 0, game->name);
 		return;
 	  }
 	}
 
-	Gameplay.npcs =
-		realloc(Gameplay.npcs, sizeof(*Gameplay.npcs) * (Gameplay.nb_npc + 1));
-	Gameplay.npcs[Gameplay.nb_npc].unique_id = elem.value2;
+	game->npcs = arenaGrow(&game->arena, game->npcs, game->nb_npc,
+							  &game->cap_npc, sizeof(*game->npcs));
+	game->npcs[game->nb_npc].unique_id = key;
 
-	if (encounterInit(elem.value, &Gameplay.npcs[Gameplay.nb_npc],
-					  Gameplay.name) == 1) {
-	  printf("%d.txt not found", elem.value);
+	if (encounterInit(value, &game->npcs[game->nb_npc],
+					  game->name) == 1) {
+	  logError("Data/%d.txt not found", value);
 	  assert(0);
 	}
 
-	Gameplay.index_current_npc = Gameplay.nb_npc;
-	Gameplay.nb_npc++;
+	game->index_current_npc = game->nb_npc;
+	game->nb_npc++;
 
-	Gameplay.npcs[Gameplay.index_current_npc].status = npcResponse(
-		&Gameplay.npcs[Gameplay.index_current_npc], NONE, 0, Gameplay.name);
-  } else if (elem.type == 1) {
-	loadArea(elem.value);
+	game->npcs[game->index_current_npc].status = npcResponse(game, 
+		&game->npcs[game->index_current_npc], NONE, 0, game->name);
+  } else if (type == 1) {
+	loadArea(game, value);
   }
 }
 
@@ -263,39 +752,40 @@ void processElement(int element_index) {
  * ou non l’état du jeu ou en communiquant au joueur l’impossibilité d’une
  * action, ou la fin du jeu.
  *
+ * @param game La partie en cours
  * @param action Action que le joueur souhaite effectuer
  */
-void processAction(int action) {
+void processAction(Gameplay_s *game, int action) {
   switch (action) {
   case ACTION_ATTACK: {
-	int index = Gameplay.index_current_npc;
+	int index = game->index_current_npc;
 
-	if (!encounterEnd(Gameplay.npcs[index])) {
-	  Gameplay.npcs[index].status =
-		  npcResponse(&Gameplay.npcs[index], ATTACK, 3, Gameplay.name);
-	  attaque(1, &Gameplay.npcs[index]);
+	if (!encounterEnd(game->npcs[index])) {
+	  game->npcs[index].status =
+		  npcResponse(game, &game->npcs[index], ATTACK, 3, game->name);
+	  attaque(game, 1, &game->npcs[index]);
 
-	  if (encounterEnd(Gameplay.npcs[index])) {
-		if (Gameplay.npcs[index].type == 501) {
-		  EndGame(0);
+	  if (encounterEnd(game->npcs[index])) {
+		if (game->npcs[index].type == 501) {
+		  EndGame(game, 0, END_PRINCE_KILLED);
 		  return;
-		} else if (Gameplay.npcs[index].type == 500) {
-		  EndGame(1);
+		} else if (game->npcs[index].type == 500) {
+		  EndGame(game, 1, END_DUKE_KILLED);
 		  return;
-		} else if (Gameplay.npcs[index].type == 110) {
-		  Gameplay.no_leave = 0;
+		} else if (game->npcs[index].type == 110) {
+		  game->no_leave = 0;
 		}
 
-		pushQueue("Your opponent died.");
-		Gameplay.state = STATE_EXPLORATION;
+		pushQueue(game, "Your opponent died.");
+		game->state = STATE_EXPLORATION;
 
-		int add = rand() % 10 + 10;
-		Gameplay.gold += add;
-		addDialog("You earn %d gold.", add);
+		int add = rngBelow(&game->rng, 10) + 10;
+		game->inventory.gold += add;
+		addDialog(game, "You earn %d gold.", add);
 	  }
 
-	  if (Gameplay.player_current_life <= 0) {
-		EndGame(0);
+	  if (game->player_current_life <= 0) {
+		EndGame(game, 0, END_KILLED);
 		return;
 	  }
 	}
@@ -304,116 +794,116 @@ void processAction(int action) {
   }
 
   case ACTION_TALK: {
-	Gameplay.state = STATE_TALK;
+	game->state = STATE_TALK;
 	break;
   }
 
   case ACTION_INVENTORY: {
-	Gameplay.old_state = Gameplay.state;
-	Gameplay.state = STATE_INVENTORY;
+	game->old_state = game->state;
+	game->state = STATE_INVENTORY;
 	break;
   }
 
   case ACTION_MOVE: {
-	if (Gameplay.no_leave == 0)
-	  Gameplay.state = STATE_EXPLORATION;
+	if (game->no_leave == 0)
+	  game->state = STATE_EXPLORATION;
 	else
-	  pushQueue("You can't escape from bandit. You will have to kill him.");
+	  pushQueue(game, "You can't escape from bandit. You will have to kill him.");
 
 	break;
   }
 
   case ACTION_INV_USE: {
-	if (Gameplay.selected_item != 0) {
-	  Item *item = getItemFromID(Gameplay.selected_item);
+	if (game->selected_item != 0) {
+	  Item *item = getItemFromID(game->selected_item);
 	  if (item->stat == STAT_NONE) {
-		processItem(Gameplay.selected_item);
-		Gameplay.items = inventoryDel(Gameplay.selected_item);
-
-		if (Gameplay.old_state == STATE_INTERACTION) {
-		  int index = Gameplay.index_current_npc;
-		  Gameplay.npcs[index].status =
-			  npcResponse(&Gameplay.npcs[index], ITEM, item->id, Gameplay.name);
-		  Gameplay.state = STATE_INTERACTION;
+		processItem(game, game->selected_item);
+		inventoryDel(&game->inventory, game->selected_item);
+
+		if (game->old_state == STATE_INTERACTION) {
+		  int index = game->index_current_npc;
+		  game->npcs[index].status =
+			  npcResponse(game, &game->npcs[index], ITEM, item->id, game->name);
+		  game->state = STATE_INTERACTION;
 		}
 	  }
 
-	  Gameplay.selected_item = 0;
-	  Gameplay.index_selected_item = -1;
+	  game->selected_item = 0;
+	  game->index_selected_item = -1;
 	}
 
 	break;
   }
 
   case ACTION_INV_EQUIP: {
-	if (Gameplay.selected_item != 0) {
-	  Item *item = getItemFromID(Gameplay.selected_item);
+	if (game->selected_item != 0) {
+	  Item *item = getItemFromID(game->selected_item);
 	  if (item->stat == STAT_ATK) {
-		int temp = Gameplay.stuff[0];
-		Gameplay.player_atk -= getItemFromID(Gameplay.stuff[0])->value_stat;
+		int temp = game->stuff[0];
+		game->player_atk -= getItemFromID(game->stuff[0])->value_stat;
 
-		Gameplay.stuff[0] = Gameplay.selected_item;
-		Gameplay.items = inventoryDel(Gameplay.selected_item);
-		Gameplay.items = inventoryAdd(temp);
+		game->stuff[0] = game->selected_item;
+		inventoryDel(&game->inventory, game->selected_item);
+		inventoryAdd(&game->inventory, temp);
 
-		Gameplay.player_atk += item->value_stat;
+		game->player_atk += item->value_stat;
 	  } else if (item->stat == STAT_DEF) {
-		int temp = Gameplay.stuff[1];
-		Gameplay.player_def -= getItemFromID(Gameplay.stuff[1])->value_stat;
+		int temp = game->stuff[1];
+		game->player_def -= getItemFromID(game->stuff[1])->value_stat;
 
-		Gameplay.stuff[1] = Gameplay.selected_item;
-		Gameplay.items = inventoryDel(Gameplay.selected_item);
-		Gameplay.items = inventoryAdd(temp);
+		game->stuff[1] = game->selected_item;
+		inventoryDel(&game->inventory, game->selected_item);
+		inventoryAdd(&game->inventory, temp);
 
-		Gameplay.player_def += item->value_stat;
+		game->player_def += item->value_stat;
 	  }
 
-	  Gameplay.selected_item = 0;
-	  Gameplay.index_selected_item = -1;
+	  game->selected_item = 0;
+	  game->index_selected_item = -1;
 	}
 
 	break;
   }
 
   case ACTION_INV_THROW: {
-	if (Gameplay.selected_item != 0) {
-	  Gameplay.items = inventoryDel(Gameplay.selected_item);
-	  Gameplay.selected_item = 0;
-	  Gameplay.index_selected_item = -1;
+	if (game->selected_item != 0) {
+	  inventoryDel(&game->inventory, game->selected_item);
+	  game->selected_item = 0;
+	  game->index_selected_item = -1;
 	}
 	break;
   }
 
   case ACTION_INV_QUIT: {
-	Gameplay.selected_item = 0;
-	Gameplay.index_selected_item = -1;
-	Gameplay.state = Gameplay.old_state;
+	game->selected_item = 0;
+	game->index_selected_item = -1;
+	game->state = game->old_state;
 	break;
   }
 
   case ACTION_TALK_YES: {
-	int index = Gameplay.index_current_npc;
-	Gameplay.npcs[index].status =
-		npcResponse(&Gameplay.npcs[index], TALK, YES, Gameplay.name);
+	int index = game->index_current_npc;
+	game->npcs[index].status =
+		npcResponse(game, &game->npcs[index], TALK, YES, game->name);
 	break;
   }
 
   case ACTION_TALK_NO: {
-	int index = Gameplay.index_current_npc;
-	Gameplay.npcs[index].status =
-		npcResponse(&Gameplay.npcs[index], TALK, NO, Gameplay.name);
+	int index = game->index_current_npc;
+	game->npcs[index].status =
+		npcResponse(game, &game->npcs[index], TALK, NO, game->name);
 	break;
   }
 
   case ACTION_TALK_THREAT: {
-	int index = Gameplay.index_current_npc;
-	Gameplay.npcs[index].status =
-		npcResponse(&Gameplay.npcs[index], TALK, THREAT, Gameplay.name);
+	int index = game->index_current_npc;
+	game->npcs[index].status =
+		npcResponse(game, &game->npcs[index], TALK, THREAT, game->name);
 	break;
   }
 
   case ACTION_TALK_QUIT: {
-	Gameplay.state = STATE_INTERACTION;
+	game->state = STATE_INTERACTION;
 	break;
   }
   }
@@ -424,43 +914,45 @@ void processAction(int action) {
  * perdre 10 points de vie, l’objet d’ID 205 dans la zone 5 met fin à la
  * partie (victoire).
  *
+ * @param game La partie en cours
  * @param item_id Identifiant de l’objet à gérer
  */
-void processItem(int item_id) {
+void processItem(Gameplay_s *game, int item_id) {
 	Item *item = getItemFromID(item_id);
 	if (item->id == 204) {
-		Gameplay.player_current_life -= 10;
-	} else if (item->id == 205 && Gameplay.area == 5) {
-		EndGame(1);
+		game->player_current_life -= 10;
+	} else if (item->id == 205 && game->area == 5) {
+		EndGame(game, 1, END_DUKE_POISONED);
 	} else if (item->id == ITEM_CUPCAKE) {
-		Gameplay.player_current_life = Gameplay.player_max_life;
+		game->player_current_life = game->player_max_life;
 	}
 	else if (item->id == ITEM_APPLE) {
-		EndGame(0);
+		EndGame(game, 0, END_APPLE);
 	}
 }
 
 /**
- * Renvoie la texture d’un objet se situant à l’écran. Si l’argument
- * `inventory` est mis à 1, alors on cherche la texture d’un élément de
+ * Renvoie un objet de l’inventaire ou de l’équipement du joueur. Si
+ * l’argument `inventory` est mis à 1, alors on cherche un élément de
  * l’inventaire, sinon on cherche un élément de l’équipement porté par le
  * joueur.
  *
+ * @param game La partie en cours
  * @param i ième élément de l’inventaire ou de l’équipement du joueur
  * @param inventory 1 pour chercher dans l’inventaire, 0 pour le stuff
- * @return Pointeur sur la texture de l’objet voulu, `NULL` s’il n’existe pas
+ * @return Pointeur sur l’objet voulu, `NULL` s’il n’existe pas
  */
-SDL_Texture *getItemTexture(int i, int inventory) {
+Item *getItem(const Gameplay_s *game, int i, int inventory) {
   if (inventory == 1) {
-	if (Gameplay.items[i] == 0)
+	if (game->inventory.items[i] == 0)
 	  return NULL;
 
-	return getItemFromID(Gameplay.items[i])->tex;
+	return getItemFromID(game->inventory.items[i]);
   } else {
-	if (Gameplay.stuff[i] == 0)
+	if (game->stuff[i] == 0)
 	  return NULL;
 
-	return getItemFromID(Gameplay.stuff[i])->tex;
+	return getItemFromID(game->stuff[i]);
   }
 }
 
@@ -472,11 +964,12 @@ SDL_Texture *getItemTexture(int i, int inventory) {
  * renvoyée. Attention, cette fonction utilise `strcpy`, tout pointeur sur une
  * chaine précédente est invalidé.
  *
+ * @param game La partie en cours
  * @param[out] desc Description de l’objet sélectionné
  */
-void getCurrentItemDesc(char *desc) {
-  if (Gameplay.selected_item != 0) {
-	Item *item = getItemFromID(Gameplay.selected_item);
+void getCurrentItemDesc(const Gameplay_s *game, char *desc) {
+  if (game->selected_item != 0) {
+	Item *item = getItemFromID(game->selected_item);
 	strcpy(desc, item->description);
   } else
 	desc[0] = '\0';
@@ -487,13 +980,16 @@ void getCurrentItemDesc(char *desc) {
  * l’argument `successful` est non-nul, alors le joueur a gagné. Sinon, le
  * joueur a perdu.
  *
+ * @param game La partie en cours
  * @param successful Jeu gagné si non-nul, sinon jeu perdu
+ * @param cause Comment la partie s’est terminée (`END_*`)
  */
-void EndGame(int successful) {
+void EndGame(Gameplay_s *game, int successful, int cause) {
+  game->end_cause = cause;
   if (successful) {
-	Gameplay.state = STATE_WON;
+	game->state = STATE_WON;
   } else {
-	Gameplay.state = STATE_LOST;
+	game->state = STATE_LOST;
   }
 }
 
@@ -501,49 +997,50 @@ void EndGame(int successful) {
  * `buyItem` gère l’achat d’objet par le joueur, en vérifiant si le joueur a
  * assez d’argent, et le cas échéant ajoute à son inventaire les objets
  * correspondants tout en retirant de sa bourse le prix de l’objet.
+ * @param game La partie en cours
  * @param item Identifiant de l’objet que le joueur souhaite acheter
  * @param gold Valeur de l’objet
  */
-void buyItem(int item, int gold) {
+void buyItem(Gameplay_s *game, int item, int gold) {
 	if (item >= 1000) {
-		if (Gameplay.gold >= gold) {
-			inventoryAdd(item);
-			Gameplay.gold -= gold;
+		if (game->inventory.gold >= gold) {
+			inventoryAdd(&game->inventory, item);
+			game->inventory.gold -= gold;
 		}
 	}
 	if (item == ITEM_NONE) {
-		Gameplay.gold -= gold;
-		if (Gameplay.gold < 0)
-			Gameplay.gold = 0;
+		game->inventory.gold -= gold;
+		if (game->inventory.gold < 0)
+			game->inventory.gold = 0;
 	}
 	if (item == ITEM_BEER) {
-		if (Gameplay.gold >= 5) {
-			inventoryAdd(204);
-			Gameplay.gold -= 5;
+		if (game->inventory.gold >= 5) {
+			inventoryAdd(&game->inventory, 204);
+			game->inventory.gold -= 5;
 		}
 	}
 	if (item == ITEM_CLETTER) {
-		inventoryAdd(202);
+		inventoryAdd(&game->inventory, 202);
 	}
 	if (item == ITEM_PLETTER) {
-		inventoryAdd(201);
+		inventoryAdd(&game->inventory, 201);
 	}
 	if (item == ITEM_AXE) {
-		if (Gameplay.gold >= 50) {
-			inventoryAdd(51);
-			Gameplay.gold -= 50;
+		if (game->inventory.gold >= 50) {
+			inventoryAdd(&game->inventory, 51);
+			game->inventory.gold -= 50;
 		}
 	}
 	if (item == ITEM_ARMOR) {
-		if (Gameplay.gold >= 50) {
-			inventoryAdd(40);
-			Gameplay.gold -= 50;
+		if (game->inventory.gold >= 50) {
+			inventoryAdd(&game->inventory, 40);
+			game->inventory.gold -= 50;
 		}
 	}
 	if (item == ITEM_POISON) {
-		if (Gameplay.gold >= 50) {
-			inventoryAdd(205);
-			Gameplay.gold -= 50;
+		if (game->inventory.gold >= 50) {
+			inventoryAdd(&game->inventory, 205);
+			game->inventory.gold -= 50;
 		}
 	}
 }
@@ -1,6 +1,9 @@
 /**
  *   \file Gameplay.h
- *   \brief Header du fichier gérant la logique de jeu
+ *   \brief Header du fichier gérant la logique de jeu. Le cœur du jeu
+ *   (Gameplay, Npc, Inventory, Zone, Spatial, Arena, Image) ne dépend pas de
+ *   la SDL : tout l’état d’une partie est rangé dans une \ref Gameplay_s, et
+ *   plusieurs parties indépendantes peuvent vivre dans le même processus.
  */
 
 
@@ -8,8 +11,10 @@
 #define __GAMEPLAY_H__
 
 #include "Inventory.h"
+#include "Arena.h"
 #include "Npc.h"
-#include <SDL2/SDL.h>
+#include "Random.h"
+#include "Spatial.h"
 
 /// Nombre d’éléments maximal que le joueur peut avoir d’équipé
 #define MAX_STUFF 2
@@ -22,7 +27,19 @@ enum {
   STATE_INVENTORY, ///< Le joueur consulte son inventaire
   STATE_TALK, ///< Le joueur parle à un NPC
   STATE_WON, ///< Le joueur a gagné
-  STATE_LOST ///< Le joueur a perdu
+  STATE_LOST, ///< Le joueur a perdu
+  NB_STATES ///< Nombre d’états
+};
+
+/// Indique comment la partie s’est terminée (voir @ref EndGame)
+enum {
+  END_NONE, ///< La partie n’est pas terminée
+  END_KILLED, ///< Le joueur a été tué par le NPC actif
+  END_PRINCE_KILLED, ///< Le joueur a tué le prince
+  END_APPLE, ///< Le joueur a mangé la pomme empoisonnée
+  END_DUKE_KILLED, ///< Le joueur a tué le duc
+  END_DUKE_POISONED, ///< Le joueur a empoisonné le duc
+  NB_END_CAUSES ///< Nombre de fins de partie
 };
 
 /// Indique l’action du personnage du joueur
@@ -41,6 +58,23 @@ enum {
   ACTION_TALK_QUIT ///< Le personnage arrête de parler au NPC
 };
 
+/// Type d’une entrée du joueur (voir @ref applyInput)
+enum {
+  INPUT_START, ///< Le joueur quitte l’écran de début
+  INPUT_ELEMENT, ///< Le joueur active un élément de la zone
+  INPUT_ACTION, ///< Le joueur déclenche une action (`ACTION_*`)
+  INPUT_SLOT ///< Le joueur sélectionne une case de l’inventaire
+};
+
+/// Entrée du joueur, telle que la produirait un clic résolu par l’interface
+typedef struct {
+  int kind; ///< Type de l’entrée (`INPUT_*`)
+  int value; ///< Indice de l’élément, action ou indice de la case
+} Input;
+
+/// Actions des 4 boutons du menu dans chaque état de jeu, -1 pour un bouton inactif
+extern const int StateActions[NB_STATES][4];
+
 /// Objets que le personnage peut avoir
 enum {
   ITEM_NONE, ///< Objet vide
@@ -54,7 +88,7 @@ enum {
   ITEM_APPLE
 };
 
-/// Une srtucture pour représenter un objet de l’inventaire
+/// Description d’un élément à ajouter à une zone (voir @ref addElement)
 typedef struct {
   int type; ///< Type de l’objet
 
@@ -62,18 +96,42 @@ typedef struct {
   int value; ///< Type de l’objet
   int value2; ///< Identifiant unique de l’objet
 
-  SDL_Rect rect; ///<
-  SDL_Texture *tex; ///< Texture de l’objet
+  Rect rect; ///< Position de l’objet
 } Element;
 
-/// Une structure stockant l’état du jeu
+/**
+ * Éléments d’une zone rangés en tableaux parallèles : les champs lus à chaque
+ * image ou à chaque clic sont contigus, les noms, qui ne servent qu’au
+ * chargement, sont partagés dans la table des sprites. Les textures des
+ * sprites appartiennent au client graphique, qui les indexe comme la table
+ * des sprites.
+ */
 typedef struct {
-  int state; ///< État actuel du jeu
-  Element *elements; ///< Objets disponibles dans le jeu
-  int nb_elements; ///< Nombre d’objets disponibles
+  int count; ///< Nombre d’éléments
+  int capacity; ///< Capacité des tableaux d’éléments
+  Rect *rects; ///< Canevas de chaque élément
+  int *types; ///< Type de chaque élément : 0 pour un NPC, 1 pour un passage
+  int *values; ///< Type du NPC ou zone de destination
+  int *keys; ///< Identifiant unique du NPC
+  int *sprites; ///< Sprite de chaque élément dans la table des sprites
+  int *visible; ///< Éléments retenus par le dernier appel à @ref cullElements
+
+  const char **sprite_names; ///< Nom de chaque sprite
+  Rect *sprite_sizes; ///< Dimensions de l’image de chaque sprite
+  int nb_sprites; ///< Nombre de sprites
+  int cap_sprites; ///< Capacité de la table des sprites
+} ElementTable;
 
-  SDL_Rect bg_rect[2]; ///< Canevas pour les images de fond
-  SDL_Texture *bg_tex[2]; ///< Images de fond
+/**
+ * Une structure stockant l’état d’une partie. Toutes les fonctions du cœur
+ * du jeu la reçoivent en paramètre ; seul le catalogue des objets (\ref
+ * Items) est partagé entre les parties.
+ */
+typedef struct Gameplay_s {
+  int state; ///< État actuel du jeu
+  ElementTable elements; ///< Objets disponibles dans la zone
+  Grid grid; ///< Index spatial des objets pour les tests de clic
+  int zone_generation; ///< Incrémenté à chaque chargement de zone
 
   int player_max_life; ///< Nombre maximum de points de vie du joueur
   int player_current_life; ///< Nombre actuel de points de vie du joueur
@@ -84,61 +142,95 @@ typedef struct {
 
   int interaction_index; ///< État d’interaction du joueur
 
-  int *items; ///< Inventaire du joueur
+  Inventory inventory; ///< Inventaire et pièces d’or du joueur
   int stuff[2]; ///< Objets que porte le joueur (armure et arme)
 
   int selected_item; ///< Objet actuellement sélectionné
   int index_selected_item;
 
-  int gold; ///< Nombre de pièces d’or du joueur
-  char name[30]; ///< Nom du joueur
+  char name[NPC_NAME_SIZE]; ///< Nom du NPC actif
+  char dialogs[NB_DIALOGS][DIALOG_SIZE]; ///< File des dialogues affichés
+  int dialog_generation; ///< Incrémenté à chaque changement de `dialogs`
 
   npc_stats *npcs; ///< Tableau contenant les NPCs du jeu
   int nb_npc; ///< Nombre de NPCs
+  int cap_npc; ///< Capacité du tableau `npcs`
   int index_current_npc; ///< Identifiant du NPC actif
+  unsigned char npc_data[NB_CUSTOM_NPC][NPC_DATA_SIZE]; ///< État interne des NPC scriptés, nul au départ
+
+  int end_cause; ///< Fin de la partie (`END_*`)
+  Rng rng; ///< Tirages pseudo-aléatoires de la partie (voir @ref seedGameplay)
 
   int no_leave; ///< Booléen pour si le joueur peut quitter ou non la zone
   int area; ///< Identifiant de la zone où se trouve le joueur
+
+  Arena arena; ///< Allocations vivant le temps d’une partie (NPCs)
+  Arena zone_arena; ///< Allocations vivant le temps d’une zone (éléments)
 } Gameplay_s;
 
-/// Variable globale pour l’état du jeu
-Gameplay_s Gameplay;
+/// Charge une fois pour toutes les données partagées par les parties
+void preloadGameData();
+/// Libère les données chargées par @ref preloadGameData
+void closeGameData();
+
+/// Crée une partie
+Gameplay_s *createGameplay();
+/// Détruit une partie
+void destroyGameplay(Gameplay_s *game);
 
 /// Initialise l’état du jeu
-void initGameplay();
+void initGameplay(Gameplay_s *game);
+/// Fixe la graine des tirages pseudo-aléatoires de la partie
+void seedGameplay(Gameplay_s *game, uint64_t seed, uint64_t stream);
 
 /// Dé-charge une zone
-void cleanArea();
+void cleanArea(Gameplay_s *game);
 
 /// Charge une zone
-void loadArea(int area);
+void loadArea(Gameplay_s *game, int area);
+/// Renvoie le nombre d’éléments d’une zone, -1 si elle n’existe pas
+int areaElementCount(int area);
 
 /// Ajoute un élément à la zone actuelle
-void addElement(Element elem);
+void addElement(Gameplay_s *game, Element elem);
 
 /// Teste si la souris se trouve sur un élément spécifié
-int intersects(SDL_Rect rect, int x_mouse, int y_mouse);
+int intersects(Rect rect, int x_mouse, int y_mouse);
 
+/// Sélectionne les éléments visibles dans un canevas
+int cullElements(Gameplay_s *game, Rect view);
+
+/// Teste si un élément de la zone est masqué (NPC mort)
+int elementHidden(const Gameplay_s *game, int i);
+/// Renvoie l’élément visible le plus haut sous la souris
+int elementAt(Gameplay_s *game, int x, int y);
 /// Teste si un élément de l’interface est activé
-int elementTriggered(int x, int y);
-/// Teste si un bouton de l’interface est activé
-int buttonTriggered(int x, int y, SDL_Rect rects[]);
-/// Teste si un objet de l’interface est activé
-int itemTriggered(int x, int y, SDL_Rect rects[]);
+int elementTriggered(Gameplay_s *game, int x, int y);
+/// Sélectionne l’objet d’une case de l’inventaire
+void selectItem(Gameplay_s *game, int index);
 
 /// Gère l’interaction avec l’élément activé par le joueur
-void processElement(int i);
+void processElement(Gameplay_s *game, int i);
 /// Gère l’action du joueur
-void processAction(int i);
+void processAction(Gameplay_s *game, int i);
 /// Gère l’action de l’objet sur le jeu
-void processItem(int item_id);
+void processItem(Gameplay_s *game, int item_id);
+
+/// Renvoie l’objet d’une case de l’inventaire ou de l’équipement
+Item *getItem(const Gameplay_s *game, int i, int inventory);
+/// Renvoie la description de l’objet sélectionné
+void getCurrentItemDesc(const Gameplay_s *game, char *desc);
 
-/// Renvoie la texture de l’objet demandé
-SDL_Texture *getItemTexture(int i, int inventory);
+/// Liste les entrées possibles dans l’état courant
+int listInputs(const Gameplay_s *game, Input *inputs, int max);
+/// Applique une entrée du joueur, si elle est possible
+int applyInput(Gameplay_s *game, Input input);
+/// Indique si une entrée est possible dans l’état courant
+int inputAllowed(const Gameplay_s *game, Input input);
 
 /// Termine le jeu
-void EndGame(int successful);
+void EndGame(Gameplay_s *game, int successful, int cause);
 
 /// Permet au joueur d’acquérir un objet
-void buyItem(int item, int gold);
+void buyItem(Gameplay_s *game, int item, int gold);
 #endif
@@ -3,83 +3,509 @@
  * Définition des fonctions liées à l'affichage
  */
 #include "Graphics.h"
+#include "Log.h"
+#include "Metrics.h"
 
 #include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/// Marge du relevé des mesures affiché par @ref renderMetrics
+#define METRICS_MARGIN 6
+/// Hauteur d'une ligne du relevé des mesures
+#define METRICS_LINE 22
+
+/// Instance unique des ressources du client graphique
+Graphics_s Graphics;
+
+/// Nom des images de l'interface dans le dossier Img, indexées comme `Graphics.texture`
+const char* const TextureNames[ NB_TEXTURES ] = {
+	[ START_BG ] = "fond_start",
+	[ MENU_BG ] = "fond_4A",
+	[ MENU_DIALOG ] = "fond_dialogues",
+	[ MENU_ATT ] = "fond_texte",
+	[ MENU_TALK ] = "fond_texte",
+	[ MENU_ITEM ] = "fond_texte",
+	[ MENU_MOVE ] = "fond_texte",
+	[ HP_BARRE ] = "hp_barre",
+	[ HP ] = "hp",
+	[ INVEN_BG ] = "inven_bg",
+	[ INVEN_HIGHLIGHT ] = "inven_highlight",
+	[ VICTORY ] = "victory",
+	[ GAME_OVER ] = "game_over"
+};
+
+/// Taille en octets des pixels d'une texture
+static long textureBytes( SDL_Texture* texture )
+{
+	Uint32 format;
+	int w, h;
+
+	if( !texture || SDL_QueryTexture( texture, &format, NULL, &w, &h ) != 0 )
+		return 0;
+	return ( long )w * h * SDL_BYTESPERPIXEL( format );
+}
 
 /**
- * `initGraphics` charge les ressources graphiques contenues dans
- * les dossiers Data et Img relatifs à l'exécutable du jeu.
- * Cette fonction attribue aussi aux diverse textures des position 
- * où elles seront désinées
+ * `trackTexture` ajoute une texture créée par le client graphique aux
+ * jauges @ref METRIC_LIVE_TEXTURES, @ref METRIC_TEXTURE_BYTES et à celle
+ * des octets de sa sorte.
+ * @param texture La texture créée
+ * @param kind La sorte de la texture (`TEXTURE_*`)
  */
-void initGraphics()
+static void trackTexture( SDL_Texture* texture, int kind )
 {
-	Graphics.font = TTF_OpenFont( "Data/CL.ttf", 20 );
-	if( !Graphics.font )
+	long bytes = textureBytes( texture );
+
+	metricAdd( METRIC_TEXTURES_CREATED, 1 );
+	metricAdd( METRIC_LIVE_TEXTURES, 1 );
+	metricAdd( METRIC_TEXTURE_BYTES, bytes );
+	metricAdd( METRIC_UI_BYTES + kind, bytes );
+}
+
+/**
+ * `destroyTexture` détruit une texture créée par le client graphique et
+ * la retire des jauges de @ref trackTexture. Une texture jamais créée est
+ * ignorée.
+ * @param texture La texture à détruire, ou `NULL`
+ * @param kind La sorte de la texture, celle donnée à sa création
+ */
+static void destroyTexture( SDL_Texture* texture, int kind )
+{
+	if( !texture )
+		return;
+
+	long bytes = textureBytes( texture );
+
+	metricAdd( METRIC_TEXTURE_BYTES, -bytes );
+	metricAdd( METRIC_UI_BYTES + kind, -bytes );
+	SDL_DestroyTexture( texture );
+	metricAdd( METRIC_LIVE_TEXTURES, -1 );
+}
+
+/**
+ * `forgetText` retire un texte du cache de @ref renderText et détruit sa
+ * texture.
+ * @param entry L'entrée du cache à libérer
+ */
+static void forgetText( CachedText* entry )
+{
+	free( entry->text );
+	destroyTexture( entry->texture, TEXTURE_TEXT );
+	memset( entry, 0, sizeof( *entry ) );
+}
+
+/**
+ * `loadGlyphs` rastérise une fois pour toutes les caractères @ref GLYPHS en
+ * blanc dans un seul atlas, et relève la position de chacun : celle de la
+ * largeur du texte qui le précède dans l'atlas. Les compteurs sont ensuite
+ * affichés caractère par caractère, teintés à la couleur voulue. L'avance de
+ * chaque caractère de la police est aussi relevée, pour couper les dialogues
+ * sans mesurer leur texte (voir @ref wrapDialog).
+ */
+static void loadGlyphs()
+{
+	SDL_Color white = { 255, 255, 255, 0 };
+	SDL_Surface* surface = TTF_RenderText_Solid( Graphics.font, GLYPHS, white );
+	if( !surface )
 	{
-		printf( "Font not found\n" );
+		logError( "cannot render glyphs" );
 		assert( 0 );
 	}
 
-	loadImage( "fond_start", &Graphics.texture[ START_BG ], &Graphics.rect[ START_BG ] );
+	Graphics.glyph_tex = SDL_CreateTextureFromSurface( Graphics.renderer, surface );
+	SDL_FreeSurface( surface );
+
+	metricAdd( METRIC_HEAP_ALLOCS, 2 );
+	trackTexture( Graphics.glyph_tex, TEXTURE_UI );
+
+	char prefix[ NB_GLYPHS + 1 ] = GLYPHS;
+	int i, x = 0, h = 0;
+
+	for( i = 0; i < NB_GLYPHS; i++ )
+	{
+		int next;
+		prefix[ i + 1 ] = '\0';
+		TTF_SizeText( Graphics.font, prefix, &next, &h );
+		prefix[ i + 1 ] = GLYPHS[ i + 1 ];
+
+		SDL_Rect glyph = { x, 0, next - x, h };
+		Graphics.glyphs[ i ] = glyph;
+		x = next;
+	}
+
+	for( i = 0; i < 256; i++ )
+	{
+		if( TTF_GlyphMetrics( Graphics.font, i, NULL, NULL, NULL, NULL, &Graphics.advance[ i ] ) != 0 )
+			Graphics.advance[ i ] = 0;
+	}
+}
+
+/**
+ * `openFont` ouvre la police du jeu. Elle n'utilise ni le rendu ni la
+ * fenêtre : elle peut être appelée depuis n'importe quel fil, avant
+ * @ref initStartScreen.
+ */
+void openFont()
+{
+	Graphics.font = TTF_OpenFont( "Data/CL.ttf", 20 );
+	metricAdd( METRIC_FILE_OPENS, 1 );
+	if( !Graphics.font )
+		logError( "Data/CL.ttf not found" );
+}
+
+/**
+ * `openAssets` ouvre le paquet @ref ASSET_PACK et le cache des images
+ * décodées, lus par @ref decodeImage. Elle peut être appelée depuis
+ * n'importe quel fil, avant tout appel de @ref decodeImage.
+ */
+void openAssets()
+{
+	if( packOpen( &Graphics.pack, ASSET_PACK ) == 0 )
+		metricAdd( METRIC_FILE_OPENS, 1 );
+	else
+		logInfo( "%s not found, images decoded from Img (see make pack)", ASSET_PACK );
+	if( imageCacheOpen( &Graphics.image_cache, NULL, IMAGE_CACHE_CAPACITY ) != 0 )
+		logWarn( "image cache unavailable, png decoded at every load" );
+	Graphics.assets_open = 1;
+}
+
+/**
+ * `initStartScreen` charge de quoi afficher la première image : la police,
+ * l'atlas des compteurs et l'écran de début. La police et les images sont
+ * ouvertes ici si @ref openFont et @ref openAssets ne l'ont pas déjà fait.
+ * Le reste des ressources est chargé ensuite par @ref initGraphics.
+ */
+void initStartScreen()
+{
+	if( !Graphics.font )
+		openFont();
+	if( !Graphics.font )
+		assert( 0 );
+	loadGlyphs();
+
+	if( !Graphics.assets_open )
+		openAssets();
+
+	loadImage( TextureNames[ START_BG ], &Graphics.texture[ START_BG ], &Graphics.rect[ START_BG ], TEXTURE_UI );
 	Graphics.rect[ START_BG ].x = 0;
 	Graphics.rect[ START_BG ].y = 0;
+}
+
+/**
+ * `initGraphics` charge les ressources graphiques contenues dans
+ * les dossiers Data et Img relatifs à l'exécutable du jeu, en commençant
+ * par celles de @ref initStartScreen si elle n'a pas été appelée.
+ * Cette fonction attribue aussi aux diverse textures des position 
+ * où elles seront désinées, et charge la texture de chaque objet du
+ * catalogue \ref Items, qui doit donc être lu au préalable : ces images
+ * ne sont chargées qu'à leur première utilisation (voir @ref lazyTexture).
+ * Les images confiées par @ref offerImage ne sont pas décodées de nouveau.
+ */
+void initGraphics()
+{
+	int i;
+
+	if( !Graphics.glyph_tex )
+		initStartScreen();
+
+	for( i = START_BG + 1; i < NB_TEXTURES; i++ )
+		loadImage( TextureNames[ i ], &Graphics.texture[ i ], &Graphics.rect[ i ], TEXTURE_UI );
 
-	loadImage( "fond_4A", &Graphics.texture[ MENU_BG ], &Graphics.rect[ MENU_BG ] );
 	Graphics.rect[ MENU_BG ].x = 0;
 	Graphics.rect[ MENU_BG ].y = 497;
 
-	loadImage( "fond_dialogues", &Graphics.texture[ MENU_DIALOG ], &Graphics.rect[ MENU_DIALOG ]);
 	Graphics.rect[ MENU_DIALOG ].x = 0;
 	Graphics.rect[ MENU_DIALOG ].y = 394;
 
-	loadImage( "fond_texte", &Graphics.texture[ MENU_ATT ], &Graphics.rect[ MENU_ATT ] );
+	Graphics.dialog_tex = SDL_CreateTexture( Graphics.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+		Graphics.rect[ MENU_DIALOG ].w, Graphics.rect[ MENU_DIALOG ].h );
+	if( Graphics.dialog_tex )
+	{
+		SDL_SetTextureBlendMode( Graphics.dialog_tex, SDL_BLENDMODE_BLEND );
+		metricAdd( METRIC_HEAP_ALLOCS, 1 );
+		trackTexture( Graphics.dialog_tex, TEXTURE_UI );
+	}
+	else
+		logWarn( "cannot create dialog panel, dialogs drawn every frame" );
+	Graphics.dialog_generation = -1;
+
 	Graphics.rect[ MENU_ATT ].x = Graphics.rect[ MENU_BG ].x + 150;
 	Graphics.rect[ MENU_ATT ].y = Graphics.rect[ MENU_BG ].y + 10;
 
-	loadImage( "fond_texte", &Graphics.texture[ MENU_TALK ], &Graphics.rect[ MENU_TALK ] );
 	Graphics.rect[ MENU_TALK ].x = Graphics.rect[ MENU_ATT ].x;
 	Graphics.rect[ MENU_TALK ].y = Graphics.rect[ MENU_ATT ].y + Graphics.rect[ MENU_ATT ].h + 5;
 
-	loadImage( "fond_texte", &Graphics.texture[ MENU_ITEM ], &Graphics.rect[ MENU_ITEM ] );
 	Graphics.rect[ MENU_ITEM ].x = Graphics.rect[ MENU_ATT ].x + Graphics.rect[ MENU_ATT ].w + 20;
 	Graphics.rect[ MENU_ITEM ].y = Graphics.rect[ MENU_ATT ].y;
 
-	loadImage( "fond_texte", &Graphics.texture[ MENU_MOVE ], &Graphics.rect[ MENU_MOVE ] );
 	Graphics.rect[ MENU_MOVE ].x = Graphics.rect[ MENU_ATT ].x + Graphics.rect[ MENU_ATT ].w + 20;
 	Graphics.rect[ MENU_MOVE ].y = Graphics.rect[ MENU_ATT ].y + Graphics.rect[ MENU_ATT ].h + 5;	
 
-	loadImage( "hp_barre", &Graphics.texture[ HP_BARRE ], &Graphics.rect[ HP_BARRE ] );
 	Graphics.rect[ HP_BARRE ].x = 10;
 	Graphics.rect[ HP_BARRE ].y = 10;
 
-	loadImage( "hp", &Graphics.texture[ HP ], &Graphics.rect[ HP ] );
 	Graphics.rect[ HP ].x = Graphics.rect[ HP_BARRE ].x + 1;
 	Graphics.rect[ HP ].y = Graphics.rect[ HP_BARRE ].y + 1;
 
-	loadImage( "inven_bg", &Graphics.texture[ INVEN_BG ], &Graphics.rect[ INVEN_BG ] );
 	Graphics.rect[ INVEN_BG ].x = Graphics.rect[ INVEN_BG ].y = 0;
 
-	loadImage( "inven_highlight", &Graphics.texture[ INVEN_HIGHLIGHT ], &Graphics.rect[ INVEN_HIGHLIGHT ] );
-
-	loadImage( "victory", &Graphics.texture[ VICTORY ], &Graphics.rect[ VICTORY ] );
 	Graphics.rect[ VICTORY ].x = Graphics.rect[ VICTORY ].y = 0;
 
-	loadImage( "game_over", &Graphics.texture[ GAME_OVER ], &Graphics.rect[ GAME_OVER ] );
 	Graphics.rect[ GAME_OVER ].x = Graphics.rect[ GAME_OVER ].y = 0;
+
+	/* les images des objets ne sont chargées qu'à leur première utilisation */
+	taskGraphInit( &Graphics.loader, WARMUP_THREADS );
+	Graphics.items = calloc( NbItems, sizeof( LazyImage ) );
+	metricAdd( METRIC_HEAP_ALLOCS, 1 );
+
+	for( i = 0; i < NbItems; i++ )
+		setLazyImage( &Graphics.items[ i ], Items[ i ].name, TEXTURE_ITEM );
+
+	if( !Graphics.texture_budget )
+		Graphics.texture_budget = TEXTURE_BUDGET;
 }
 
 /**
  * `destroyGraphics` libère les ressources précedemment acquises
  */
-void destroyGraphics()
+void destroyGraphics( void )
 {
 	TTF_CloseFont( Graphics.font );
+	Graphics.font = NULL;
+	destroyTexture( Graphics.glyph_tex, TEXTURE_UI );
+	Graphics.glyph_tex = NULL;
+	if( Graphics.dialog_tex )
+		destroyTexture( Graphics.dialog_tex, TEXTURE_UI );
 
 	int i;
 	for( i = 0; i < NB_TEXTURES; i++ )
-		SDL_DestroyTexture( Graphics.texture[ i ] );
+		destroyTexture( Graphics.texture[ i ], TEXTURE_UI );
+
+	/* plus aucun décodage en arrière-plan n'écrit dans les images */
+	taskGraphDestroy( &Graphics.loader );
+	memset( &Graphics.loader, 0, sizeof( Graphics.loader ) );
+
+	/* absentes si le chargement a été abandonné avant @ref initGraphics */
+	if( Graphics.items )
+	{
+		for( i = 0; i < NbItems; i++ )
+			setLazyImage( &Graphics.items[ i ], NULL, TEXTURE_ITEM );
+	}
+	free( Graphics.items );
+	Graphics.items = NULL;
+
+	for( i = 0; i < Graphics.nb_zones; i++ )
+	{
+		setLazyImage( &Graphics.zones[ i ].bg, NULL, TEXTURE_ZONE );
+		setLazyImage( &Graphics.zones[ i ].interaction, NULL, TEXTURE_ZONE );
+	}
+	free( Graphics.zones );
+	Graphics.zones = NULL;
+	Graphics.nb_zones = 0;
+	Graphics.zone_bg = NULL;
+	Graphics.interaction_bg = NULL;
+
+	for( i = 0; i < Graphics.nb_sprites; i++ )
+		destroyTexture( Graphics.sprite_tex[ i ], TEXTURE_SPRITE );
+	free( Graphics.sprite_tex );
+
+	for( i = 0; i < TEXT_CACHE_SIZE; i++ )
+	{
+		if( Graphics.texts[ i ].text )
+			forgetText( &Graphics.texts[ i ] );
+	}
+
+	clearOfferedImages();
+	packClose( &Graphics.pack );
+	Graphics.assets_open = 0;
+	arenaFree( &Graphics.frame );
+}
+
+/**
+ * `frameAlloc` alloue `size` octets initialisés à zéro dans l'arène de
+ * l'image en cours. La zone reste valide jusqu'au prochain appel à
+ * @ref presentFrame ; une fois l'arène à sa taille, aucune image ne fait
+ * plus d'allocation sur le tas.
+ * @param size La taille demandée
+ * @return La zone allouée
+ */
+void* frameAlloc( size_t size )
+{
+	return arenaAlloc( &Graphics.frame, size );
+}
+
+/**
+ * `frameFormat` met en forme une chaine comme `sprintf`, dans l'arène de
+ * l'image en cours (voir @ref frameAlloc) : la chaine n'est jamais tronquée.
+ * @param format Le format, comme pour `printf`
+ * @return La chaine, valide jusqu'à la fin de l'image
+ */
+char* frameFormat( const char* format, ... )
+{
+	va_list args;
+
+	va_start( args, format );
+	int length = vsnprintf( NULL, 0, format, args );
+	va_end( args );
+
+	char* text = frameAlloc( length + 1 );
+	va_start( args, format );
+	vsnprintf( text, length + 1, format, args );
+	va_end( args );
+	return text;
+}
+
+/**
+ * `presentFrame` présente l'image dessinée, libère d'un coup les
+ * allocations de l'image (voir @ref frameAlloc) et oublie les textes qui ne
+ * sont plus affichés depuis @ref TEXT_CACHE_TTL images.
+ */
+void presentFrame()
+{
+	SDL_RenderPresent( Graphics.renderer );
+	arenaReset( &Graphics.frame );
+	Graphics.frame_number++;
+
+	int i;
+	for( i = 0; i < TEXT_CACHE_SIZE; i++ )
+	{
+		CachedText* entry = &Graphics.texts[ i ];
+		if( entry->text && Graphics.frame_number - entry->last_frame > TEXT_CACHE_TTL )
+			forgetText( entry );
+	}
+}
+
+/**
+ * `decodeImage` lit une image du dossier Img : ses pixels sont décompressés
+ * du paquet @ref ASSET_PACK s'il la contient, sinon relus du cache des
+ * images décodées (voir @ref ImageCache.h) s'il y a ceux de ce png, sinon le
+ * png est décodé et ses pixels ajoutés au cache. Elle
+ * n'utilise ni le rendu ni la fenêtre : elle peut être appelée depuis
+ * n'importe quel fil, par exemple pour décoder des images pendant que
+ * l'écran de début est affiché.
+ * @param name Nom du fichier dans le dossier Img, sans extension
+ * @return L'image décodée, à libérer avec `SDL_FreeSurface`, ou `NULL` si
+ * elle n'a pas pu être lue
+ */
+SDL_Surface* decodeImage( const char* name )
+{
+	const PackEntry* entry = packFind( &Graphics.pack, name );
+	if( entry )
+	{
+		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat( 0, entry->w, entry->h, 32, SDL_PIXELFORMAT_ARGB8888 );
+		if( surface && surface->pitch == ( int )entry->w * 4 && packRead( &Graphics.pack, entry, surface->pixels ) == 0 )
+		{
+			metricAdd( METRIC_HEAP_ALLOCS, 1 );
+			return surface;
+		}
+
+		SDL_FreeSurface( surface );
+		logWarn( "%s: invalid in %s, decoded from Img", name, ASSET_PACK );
+	}
+
+	char path[ 64 ];
+	snprintf( path, sizeof( path ), "Img/%s.png", name );
+
+	/* le png est lu en entier : son empreinte désigne ses pixels dans le cache */
+	FILE* file = fopen( path, "rb" );
+	metricAdd( METRIC_FILE_OPENS, 1 );
+	if( !file )
+		return NULL;
+	fseek( file, 0, SEEK_END );
+	long size = ftell( file );
+	rewind( file );
+	void* data = size > 0 ? malloc( size ) : NULL;
+	if( data && fread( data, 1, size, file ) != ( size_t )size )
+	{
+		free( data );
+		data = NULL;
+	}
+	fclose( file );
+	if( !data )
+		return NULL;
+
+	uint64_t key = imageCacheKey( data, size );
+	CachedPixels cached;
+	if( imageCacheFind( &Graphics.image_cache, key, size, &cached ) == 0 )
+	{
+		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat( 0, cached.w, cached.h, 32, SDL_PIXELFORMAT_ARGB8888 );
+		if( surface )
+		{
+			int y;
+			for( y = 0; y < cached.h; y++ )
+				memcpy( ( Uint8* )surface->pixels + y * surface->pitch, ( const Uint8* )cached.pixels + y * cached.w * 4,
+					cached.w * 4 );
+			metricAdd( METRIC_HEAP_ALLOCS, 1 );
+			metricAdd( METRIC_IMAGE_CACHE_HITS, 1 );
+		}
+		imageCacheRelease( &cached );
+		free( data );
+		return surface;
+	}
+
+	SDL_Surface* decoded = IMG_Load_RW( SDL_RWFromConstMem( data, size ), 1 );
+	SDL_Surface* surface = decoded ? SDL_ConvertSurfaceFormat( decoded, SDL_PIXELFORMAT_ARGB8888, 0 ) : NULL;
+	SDL_FreeSurface( decoded );
+	if( surface )
+	{
+		metricAdd( METRIC_HEAP_ALLOCS, 1 );
+		if( surface->pitch == surface->w * 4
+			&& imageCacheStore( &Graphics.image_cache, key, size, surface->w, surface->h, surface->pixels ) == 0 )
+			metricAdd( METRIC_IMAGE_CACHE_STORES, 1 );
+	}
+	free( data );
+	return surface;
+}
+
+/**
+ * `offerImage` confie une image décodée d'avance (voir @ref decodeImage) :
+ * @ref loadImage l'utilise au lieu de décoder de nouveau le fichier, autant
+ * de fois que l'image est chargée, jusqu'à @ref clearOfferedImages. L'image
+ * est libérée aussitôt s'il n'y a plus de place.
+ * @param name Nom du fichier de l'image
+ * @param surface L'image décodée, qui appartient ensuite au client graphique
+ */
+void offerImage( const char* name, SDL_Surface* surface )
+{
+	if( Graphics.nb_offered == MAX_OFFERED_IMAGES || strlen( name ) >= IMAGE_NAME_SIZE )
+	{
+		SDL_FreeSurface( surface );
+		return;
+	}
+
+	DecodedImage* image = &Graphics.offered[ Graphics.nb_offered++ ];
+	strcpy( image->name, name );
+	image->surface = surface;
+}
+
+/**
+ * `clearOfferedImages` libère les images confiées par @ref offerImage.
+ */
+void clearOfferedImages()
+{
+	int i;
+	for( i = 0; i < Graphics.nb_offered; i++ )
+		SDL_FreeSurface( Graphics.offered[ i ].surface );
+	Graphics.nb_offered = 0;
+}
+
+/**
+ * `uploadImage` crée la texture d'une image décodée, sur le fil du rendu.
+ * @param surface L'image décodée, qui reste à l'appelant
+ * @param texture La texture créée
+ * @param rect Les dimensions de la texture
+ * @param kind La sorte de la texture (`TEXTURE_*`)
+ */
+static void uploadImage( SDL_Surface* surface, SDL_Texture** texture, SDL_Rect* rect, int kind )
+{
+	*texture = SDL_CreateTextureFromSurface( Graphics.renderer, surface );
+	metricAdd( METRIC_HEAP_ALLOCS, 1 );
+	trackTexture( *texture, kind );
+
+	SDL_QueryTexture( *texture, NULL, NULL, &rect->w, &rect->h );
 }
 
 /**
@@ -88,24 +514,349 @@ void destroyGraphics()
  * L'appelant doit passer en paramètres un pointeur vers un pointeur vers
  * un SDL_Texture, qui pointera vers la texture ainsi créée à la fin de la 
  * fonction, ainsi qu'un pointeur vers un SDL_Rect qui contiendra les dimensions
- * de la textures à la fin de l'éxécution de cette fonction.
+ * de la textures à la fin de l'éxécution de cette fonction. Une image confiée
+ * par @ref offerImage n'est pas décodée de nouveau.
  * @param filename Nom du fichier dans le dossier Img sans extension de l'image à charger
  * @param texture Pointeur vers Pointeur vers SDL_Texture qui pointera vers la texture chargée
  * @param rect Pointeur vers rectangle qui contiendra les dimensions de la texture chargée
+ * @param kind Sorte de la texture (`TEXTURE_*`), pour le relevé de la mémoire
  */
-void loadImage( char* fileName, SDL_Texture** texture, SDL_Rect* rect )
+void loadImage( const char* fileName, SDL_Texture** texture, SDL_Rect* rect, int kind )
 {
-	char path[ 64 ];
-	sprintf( path, "Img/%s.png", fileName );
+	SDL_Surface* surface = NULL;
+	int i;
+
+	for( i = 0; i < Graphics.nb_offered && !surface; i++ )
+	{
+		if( strcmp( Graphics.offered[ i ].name, fileName ) == 0 )
+			surface = Graphics.offered[ i ].surface;
+	}
 
-	*texture = IMG_LoadTexture( Graphics.renderer, path );
-	if( *texture == NULL )
+	int offered = surface != NULL;
+	if( !offered )
+		surface = decodeImage( fileName );
+	if( surface == NULL )
 	{
-		printf( "%s not found\n", fileName );
+		logError( "%s not found", fileName );
 		assert( 0 );
 	}
 
-	SDL_QueryTexture( *texture, NULL, NULL, &rect->w, &rect->h );
+	uploadImage( surface, texture, rect, kind );
+	if( !offered )
+		SDL_FreeSurface( surface );
+}
+
+/// Tâche de @ref warmImage : décode l'image en arrière-plan, sauf si elle a été reprise avant
+static void warmTask( void* arg )
+{
+	LazyImage* image = arg;
+	int queued = LAZY_QUEUED;
+
+	if( !atomic_compare_exchange_strong( &image->state, &queued, LAZY_DECODING ) )
+		return;
+	image->surface = decodeImage( image->name );
+	atomic_store_explicit( &image->state, LAZY_DECODED, memory_order_release );
+}
+
+/**
+ * `claimImage` reprend une image à son décodage en arrière-plan : un
+ * décodage pas encore commencé est annulé, un décodage en cours est attendu,
+ * sans attendre les autres images. L'image est ensuite dans l'état
+ * `LAZY_IDLE` ou `LAZY_DECODED`.
+ * @param image L'image à la demande
+ */
+static void claimImage( LazyImage* image )
+{
+	int state = LAZY_QUEUED;
+
+	if( !atomic_compare_exchange_strong( &image->state, &state, LAZY_IDLE ) && state == LAZY_DECODING )
+		taskJoin( &Graphics.loader, image->task );
+}
+
+/**
+ * `setLazyImage` fait d'une image chargée à la demande celle du fichier
+ * `name` : l'image précédente est libérée, la nouvelle n'est décodée qu'à
+ * sa première utilisation (@ref lazyTexture), ou d'avance par
+ * @ref warmImage.
+ * @param image L'image à la demande
+ * @param name Le nom du fichier dans le dossier Img, `NULL` pour aucune image
+ * @param kind La sorte de sa texture (`TEXTURE_*`)
+ */
+void setLazyImage( LazyImage* image, const char* name, int kind )
+{
+	/* un décodage en cours écrit encore dans l'image */
+	claimImage( image );
+
+	SDL_FreeSurface( image->surface );
+	if( image->texture )
+		destroyTexture( image->texture, image->kind );
+	memset( image, 0, sizeof( *image ) );
+
+	image->kind = kind;
+	if( name )
+		snprintf( image->name, sizeof( image->name ), "%s", name );
+}
+
+/**
+ * `warmImage` lance en arrière-plan le décodage d'une image chargée à la
+ * demande, si elle n'est ni chargée ni déjà en cours de décodage : sa
+ * première utilisation n'aura plus qu'à créer sa texture.
+ * @param image L'image à la demande
+ */
+void warmImage( LazyImage* image )
+{
+	if( image->texture || !image->name[ 0 ] || !Graphics.loader.nb_threads
+		|| atomic_load_explicit( &image->state, memory_order_acquire ) != LAZY_IDLE )
+		return;
+
+	atomic_store_explicit( &image->state, LAZY_QUEUED, memory_order_relaxed );
+	taskGraphReset( &Graphics.loader );
+	image->task = taskAdd( &Graphics.loader, warmTask, image, 0, NULL );
+	if( image->task < 0 )
+		atomic_store_explicit( &image->state, LAZY_IDLE, memory_order_relaxed );
+	else
+		metricAdd( METRIC_WARMUPS, 1 );
+}
+
+/**
+ * `lazyTexture` renvoie la texture d'une image chargée à la demande, en la
+ * créant à sa première utilisation ou à la première qui suit sa libération
+ * par @ref trimTextures : à partir de l'image décodée par @ref warmImage si
+ * elle l'a été ou l'est en ce moment, sinon en la décodant aussitôt, sans
+ * attendre les décodages d'avance des autres images.
+ * @param image L'image à la demande
+ * @return La texture, `NULL` si l'image n'a pas de fichier ; ses
+ * dimensions sont alors dans `image->rect`
+ */
+SDL_Texture* lazyTexture( LazyImage* image )
+{
+	image->last_use = Graphics.frame_number;
+	if( image->texture || !image->name[ 0 ] )
+		return image->texture;
+
+	/* seul le décodage de cette image est attendu, s'il a commencé */
+	claimImage( image );
+
+	if( image->surface )
+	{
+		uploadImage( image->surface, &image->texture, &image->rect, image->kind );
+		SDL_FreeSurface( image->surface );
+		image->surface = NULL;
+	}
+	else
+		loadImage( image->name, &image->texture, &image->rect, image->kind );
+
+	atomic_store_explicit( &image->state, LAZY_IDLE, memory_order_relaxed );
+	metricAdd( METRIC_LAZY_LOADS, 1 );
+	return image->texture;
+}
+
+/**
+ * `warmItems` lance en arrière-plan le décodage des images des objets de
+ * l'inventaire et de l'équipement du joueur (voir @ref warmImage).
+ * @param game La partie affichée
+ */
+void warmItems( const Gameplay_s* game )
+{
+	int i;
+
+	for( i = 0; i < MAX_ITEM; i++ )
+	{
+		Item* item = getItem( game, i, 1 );
+		if( item )
+			warmImage( &Graphics.items[ item - Items ] );
+	}
+	for( i = 0; i < MAX_STUFF; i++ )
+	{
+		Item* item = getItem( game, i, 0 );
+		if( item )
+			warmImage( &Graphics.items[ item - Items ] );
+	}
+}
+
+/**
+ * `zoneImages` renvoie les fonds de la zone `area`, en agrandissant
+ * `Graphics.zones` au besoin.
+ */
+static ZoneImages* zoneImages( int area )
+{
+	int i;
+
+	if( area >= Graphics.nb_zones )
+	{
+		/* les décodages en cours écrivent dans les fonds déplacés */
+		taskGraphWait( &Graphics.loader );
+
+		Graphics.zones = realloc( Graphics.zones, sizeof( ZoneImages ) * ( area + 1 ) );
+		memset( Graphics.zones + Graphics.nb_zones, 0, sizeof( ZoneImages ) * ( area + 1 - Graphics.nb_zones ) );
+		metricAdd( METRIC_HEAP_ALLOCS, 1 );
+
+		for( i = Graphics.nb_zones; i <= area; i++ )
+		{
+			char file_name[ 16 ];
+			sprintf( file_name, "Zone%d", i );
+			setLazyImage( &Graphics.zones[ i ].bg, file_name, TEXTURE_ZONE );
+			sprintf( file_name, "IZone%d", i );
+			setLazyImage( &Graphics.zones[ i ].interaction, file_name, TEXTURE_ZONE );
+		}
+		Graphics.nb_zones = area + 1;
+	}
+
+	return &Graphics.zones[ area ];
+}
+
+/**
+ * `syncZoneTextures` met les images de la zone en accord avec la partie
+ * `game`. Quand la partie a changé de zone (voir `zone_generation`), les
+ * sprites de l'ancienne zone sont détruits et le fond de la nouvelle est
+ * chargé, s'il ne l'est pas encore ; son fond des interactions ne l'est
+ * qu'à sa première utilisation (voir @ref lazyTexture). Les fonds des zones
+ * quittées restent chargés jusqu'à ce que @ref trimTextures les libère. Les
+ * sprites ajoutés depuis le dernier appel sont ensuite chargés. La durée de
+ * l'entrée dans une zone est relevée dans @ref METRIC_ZONE_ENTRY. À appeler
+ * avant d'afficher la zone, à chaque image : les textures au-delà du budget
+ * sont aussi libérées.
+ * @param game La partie affichée
+ */
+void syncZoneTextures( const Gameplay_s* game )
+{
+	const ElementTable* t = &game->elements;
+	int i;
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	int entered = Graphics.zone_generation != game->zone_generation;
+
+	if( entered )
+	{
+		for( i = 0; i < Graphics.nb_sprites; i++ )
+			destroyTexture( Graphics.sprite_tex[ i ], TEXTURE_SPRITE );
+		Graphics.nb_sprites = 0;
+
+		ZoneImages* zone = zoneImages( game->area );
+		Graphics.zone_bg = &zone->bg;
+		Graphics.interaction_bg = &zone->interaction;
+		lazyTexture( Graphics.zone_bg );
+
+		Graphics.zone_generation = game->zone_generation;
+	}
+
+	if( t->nb_sprites > Graphics.cap_sprites )
+	{
+		Graphics.cap_sprites = t->nb_sprites;
+		Graphics.sprite_tex = realloc( Graphics.sprite_tex, sizeof( SDL_Texture* ) * Graphics.cap_sprites );
+		metricAdd( METRIC_HEAP_ALLOCS, 1 );
+	}
+
+	for( i = Graphics.nb_sprites; i < t->nb_sprites; i++ )
+	{
+		SDL_Rect size;
+		loadImage( t->sprite_names[ i ], &Graphics.sprite_tex[ i ], &size, TEXTURE_SPRITE );
+	}
+	Graphics.nb_sprites = t->nb_sprites;
+
+	if( entered )
+		metricObserve( METRIC_ZONE_ENTRY,
+			( long )( ( SDL_GetPerformanceCounter() - start ) * 1000000 / SDL_GetPerformanceFrequency() ) );
+
+	trimTextures( game );
+}
+
+/// Indique si le joueur de la partie `game` porte l'objet d'indice `index` dans \ref Items
+static int holdsItem( const Gameplay_s* game, int index )
+{
+	int i;
+
+	for( i = 0; i < MAX_ITEM; i++ )
+	{
+		Item* item = getItem( game, i, 1 );
+		if( item && item - Items == index )
+			return 1;
+	}
+	for( i = 0; i < MAX_STUFF; i++ )
+	{
+		Item* item = getItem( game, i, 0 );
+		if( item && item - Items == index )
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * `trimTextures` libère des textures tant que les textures en vie dépassent
+ * `Graphics.texture_budget` octets, en commençant par celle qui n'a pas été
+ * utilisée depuis le plus longtemps. Seules les images chargées à la
+ * demande dont la partie ne se sert pas peuvent l'être : les fonds des
+ * autres zones que la zone courante, et les images des objets que le joueur
+ * ne porte pas. L'interface, les sprites de la zone et les textes ne le
+ * sont jamais. Une image libérée est rechargée à sa prochaine utilisation
+ * (voir @ref lazyTexture).
+ * @param game La partie affichée
+ */
+void trimTextures( const Gameplay_s* game )
+{
+	int i;
+
+	while( metricValue( METRIC_TEXTURE_BYTES ) > Graphics.texture_budget )
+	{
+		LazyImage* victim = NULL;
+
+		for( i = 0; i < Graphics.nb_zones; i++ )
+		{
+			LazyImage* bg = &Graphics.zones[ i ].bg;
+			LazyImage* interaction = &Graphics.zones[ i ].interaction;
+			if( i == game->area )
+				continue;
+			if( bg->texture && ( !victim || bg->last_use < victim->last_use ) )
+				victim = bg;
+			if( interaction->texture && ( !victim || interaction->last_use < victim->last_use ) )
+				victim = interaction;
+		}
+
+		for( i = 0; i < NbItems; i++ )
+		{
+			LazyImage* item = &Graphics.items[ i ];
+			if( item->texture && ( !victim || item->last_use < victim->last_use ) && !holdsItem( game, i ) )
+				victim = item;
+		}
+
+		if( !victim )
+			break;
+
+		destroyTexture( victim->texture, victim->kind );
+		victim->texture = NULL;
+		metricAdd( METRIC_EVICTIONS, 1 );
+	}
+}
+
+/**
+ * `renderElement` affiche l'élément d'indice `index` de la zone de la
+ * partie `game` avec la texture de son sprite.
+ * @param game La partie affichée
+ * @param index L'indice de l'élément dans `game->elements`
+ */
+void renderElement( const Gameplay_s* game, int index )
+{
+	const Rect* r = &game->elements.rects[ index ];
+	SDL_Rect rect = { r->x, r->y, r->w, r->h };
+
+	renderImage( Graphics.sprite_tex[ game->elements.sprites[ index ] ], rect );
+}
+
+/**
+ * `getItemTexture` renvoie la texture d'un objet de la partie `game` (voir
+ * @ref getItem), chargée à sa première utilisation.
+ * @param game La partie affichée
+ * @param i ième élément de l'inventaire ou de l'équipement du joueur
+ * @param inventory 1 pour chercher dans l'inventaire, 0 pour l'équipement
+ * @return La texture de l'objet, `NULL` si la case est vide
+ */
+SDL_Texture* getItemTexture( const Gameplay_s* game, int i, int inventory )
+{
+	Item* item = getItem( game, i, inventory );
+	if( !item )
+		return NULL;
+
+	return lazyTexture( &Graphics.items[ item - Items ] );
 }
 
 /**
@@ -119,40 +870,190 @@ void renderImage( SDL_Texture* texture, SDL_Rect rect )
 	SDL_RenderCopy( Graphics.renderer, texture, NULL, &rect );
 }
 
+/**
+ * `hashText` calcule l'empreinte (FNV-1a) d'un texte et de sa couleur.
+ */
+static unsigned hashText( const char* text, SDL_Color color )
+{
+	unsigned hash = 2166136261u;
+
+	hash = ( hash ^ ( ( unsigned )color.r << 16 | ( unsigned )color.g << 8 | color.b ) ) * 16777619u;
+	for( ; *text; text++ )
+		hash = ( hash ^ ( unsigned char )*text ) * 16777619u;
+	return hash;
+}
+
+/**
+ * `textTexture` renvoie la texture du texte `text` de couleur `color` : celle
+ * du cache si le texte a été affiché récemment, sinon le texte est rastérisé
+ * à la place de l'entrée la moins récemment affichée.
+ * @param text Le texte, non vide
+ * @param color La couleur du texte
+ * @return L'entrée du cache, `NULL` si le texte n'a pas pu être rastérisé
+ */
+static CachedText* textTexture( const char* text, SDL_Color color )
+{
+	unsigned hash = hashText( text, color );
+	CachedText* victim = &Graphics.texts[ 0 ];
+	int i;
+
+	for( i = 0; i < TEXT_CACHE_SIZE; i++ )
+	{
+		CachedText* entry = &Graphics.texts[ i ];
+		if( entry->text && entry->hash == hash && entry->color.r == color.r && entry->color.g == color.g
+			&& entry->color.b == color.b && strcmp( entry->text, text ) == 0 )
+		{
+			entry->last_frame = Graphics.frame_number;
+			metricAdd( METRIC_TEXT_CACHE_HITS, 1 );
+			return entry;
+		}
+
+		if( victim->text && ( !entry->text || entry->last_frame < victim->last_frame ) )
+			victim = entry;
+	}
+
+	SDL_Surface* surface = TTF_RenderText_Solid( Graphics.font, text, color );
+	if( !surface )
+		return NULL;
+
+	if( victim->text )
+		forgetText( victim );
+
+	victim->texture = SDL_CreateTextureFromSurface( Graphics.renderer, surface );
+	SDL_FreeSurface( surface );
+	SDL_QueryTexture( victim->texture, NULL, NULL, &victim->w, &victim->h );
+
+	victim->text = strdup( text );
+	victim->hash = hash;
+	victim->color = color;
+	victim->last_frame = Graphics.frame_number;
+
+	metricAdd( METRIC_TEXT_RENDERS, 1 );
+	metricAdd( METRIC_HEAP_ALLOCS, 3 );
+	trackTexture( victim->texture, TEXTURE_TEXT );
+	return victim;
+}
+
 /**
  * `renderText` affiche du texte à l'écran à une position et avec
- * une couleur donné.
+ * une couleur donné. Le texte n'est rastérisé que s'il n'a pas été
+ * affiché récemment (voir @ref TEXT_CACHE_TTL).
+ * @param text Le texte à afficher
+ * @param x L'abscisse où afficher le texte
+ * @param y L'ordonnée où afficher le texte
+ * @param color La couleur du texte à afficher
+ * @return La largeur du texte affiché
+ */
+int renderText( const char* text, int x, int y, SDL_Color color )
+{
+	if( text[ 0 ] == '\0' )
+		return 0;
+
+	CachedText* entry = textTexture( text, color );
+	if( !entry )
+		return 0;
+
+	SDL_Rect rect = { x, y, entry->w, entry->h };
+	renderImage( entry->texture, rect );
+	return entry->w;
+}
+
+/**
+ * `renderGlyphs` affiche `text` caractère par caractère depuis l'atlas
+ * @ref GLYPHS, sans rastérisation ni allocation. Les caractères absents de
+ * l'atlas sont ignorés.
+ * @param text Le texte à afficher
+ * @param x L'abscisse où afficher le texte
+ * @param y L'ordonnée où afficher le texte
+ * @param color La couleur du texte
+ * @return La largeur du texte affiché
+ */
+int renderGlyphs( const char* text, int x, int y, SDL_Color color )
+{
+	int start = x;
+
+	SDL_SetTextureColorMod( Graphics.glyph_tex, color.r, color.g, color.b );
+	for( ; *text; text++ )
+	{
+		const char* glyph = strchr( GLYPHS, *text );
+		if( !glyph )
+			continue;
+
+		const SDL_Rect* src = &Graphics.glyphs[ glyph - GLYPHS ];
+		SDL_Rect dst = { x, y, src->w, src->h };
+		SDL_RenderCopy( Graphics.renderer, Graphics.glyph_tex, src, &dst );
+		x += src->w;
+	}
+
+	return x - start;
+}
+
+/**
+ * `renderNumber` affiche l'entier `value` avec l'atlas @ref GLYPHS. Les
+ * chiffres sont tirés de la valeur absolue, calculée en non signé pour que
+ * `INT_MIN` soit lui aussi affiché correctement.
+ * @param value L'entier à afficher
+ * @param x L'abscisse où afficher l'entier
+ * @param y L'ordonnée où afficher l'entier
+ * @param color La couleur de l'entier
+ * @return La largeur de l'entier affiché
+ */
+int renderNumber( int value, int x, int y, SDL_Color color )
+{
+	char digits[ 12 ];
+	unsigned magnitude = value < 0 ? 0u - ( unsigned )value : ( unsigned )value;
+	int n = sizeof( digits ) - 1;
+
+	digits[ n ] = '\0';
+	do
+	{
+		digits[ --n ] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while( magnitude );
+
+	if( value < 0 )
+		digits[ --n ] = '-';
+
+	return renderGlyphs( digits + n, x, y, color );
+}
+
+/**
+ * `renderTextOnce` affiche un texte sans le garder en cache : pour les
+ * textes qui changent à chaque image et ne feraient que chasser du cache
+ * ceux qui restent affichés.
  * @param text Le texte à afficher
  * @param x L'abscisse où afficher le texte
  * @param y L'ordonnée où afficher le texte
  * @param color La couleur du texte à afficher
  */
-void renderText( char* text, int x, int y, SDL_Color color )
+static void renderTextOnce( const char* text, int x, int y, SDL_Color color )
 {
 	SDL_Surface* surface = TTF_RenderText_Solid( Graphics.font, text, color );
-	SDL_Texture* texture = SDL_CreateTextureFromSurface( Graphics.renderer, surface );
+	if( !surface )
+		return;
 
+	SDL_Texture* texture = SDL_CreateTextureFromSurface( Graphics.renderer, surface );
 	SDL_FreeSurface( surface );
 
-	SDL_Rect rect;
-	SDL_QueryTexture( texture, NULL, NULL, &rect.w, &rect.h );
-	rect.x = x;
-	rect.y = y;
+	metricAdd( METRIC_TEXT_RENDERS, 1 );
+	metricAdd( METRIC_HEAP_ALLOCS, 2 );
+	trackTexture( texture, TEXTURE_TEXT );
 
+	SDL_Rect rect = { x, y, 0, 0 };
+	SDL_QueryTexture( texture, NULL, NULL, &rect.w, &rect.h );
 	renderImage( texture, rect );
 
-	SDL_DestroyTexture( texture );
+	destroyTexture( texture, TEXTURE_TEXT );
 }
 
 /**
- * `getButtonRects` écrit dans le tableau rects les rectangles des 4 boutons du bas de l'écran
- * @param rects Le tableau où copier les coordonnées
+ * `getButtonRects` renvoie les rectangles des 4 boutons du bas de l'écran,
+ * rangés à la suite dans `Graphics.rect` de `MENU_ATT` à `MENU_MOVE`.
+ * @return Les 4 rectangles
  */
-void getButtonRects( SDL_Rect rects[] )
+const SDL_Rect* getButtonRects()
 {
-	int i;
-	for( i = 0; i < 4; i++ )
-		rects[ i ] = Graphics.rect[ MENU_ATT + i ];
+	return &Graphics.rect[ MENU_ATT ];
 }
 
 /**
@@ -163,19 +1064,123 @@ void renderStartScreen()
 	renderImage( Graphics.texture[ START_BG ], Graphics.rect[ START_BG ] );
 }
 
+/**
+ * `wrapDialog` renvoie la longueur du début de `text` qui tient sur une
+ * ligne de `width` pixels, d'après l'avance des caractères relevée par
+ * @ref loadGlyphs : le texte est coupé à la dernière espace qui tient, ou
+ * au dernier caractère qui tient si la ligne n'a pas d'espace.
+ * @param text Le texte à couper
+ * @param width La largeur de la ligne
+ * @return La longueur de la ligne, au moins 1 si le texte n'est pas vide
+ */
+static int wrapDialog( const char* text, int width )
+{
+	int i, x = 0, space = -1;
+
+	for( i = 0; text[ i ]; i++ )
+	{
+		if( text[ i ] == ' ' )
+			space = i;
+		x += Graphics.advance[ ( unsigned char )text[ i ] ];
+		if( x > width && i > 0 )
+			return space > 0 ? space : i;
+	}
+	return i;
+}
+
+/**
+ * `drawDialogs` dessine le fond du panneau des dialogues à la position
+ * `( x, y )`, puis les dialogues coupés à la largeur du panneau. Seules les
+ * @ref NB_DIALOGS dernières lignes, les plus récentes, sont dessinées.
+ * @param game La partie dont les dialogues sont dessinés
+ * @param x L'abscisse du panneau
+ * @param y L'ordonnée du panneau
+ */
+static void drawDialogs( const Gameplay_s* game, int x, int y )
+{
+	SDL_Color color = { 0, 0, 0, 0 };
+	SDL_Rect panel = Graphics.rect[ MENU_DIALOG ];
+	int width = panel.w - 2 * DIALOG_MARGIN;
+	const char* starts[ NB_DIALOGS ];
+	int lengths[ NB_DIALOGS ];
+	int i, nb_lines = 0;
+
+	panel.x = x;
+	panel.y = y;
+	renderImage( Graphics.texture[ MENU_DIALOG ], panel );
+
+	/* les dernières lignes, dans un tampon circulaire */
+	for( i = 0; i < NB_DIALOGS; i++ )
+	{
+		const char* text = game->dialogs[ i ];
+		while( *text )
+		{
+			int length = wrapDialog( text, width );
+			starts[ nb_lines % NB_DIALOGS ] = text;
+			lengths[ nb_lines % NB_DIALOGS ] = length;
+			nb_lines++;
+
+			text += length;
+			while( *text == ' ' )
+				text++;
+		}
+	}
+
+	int first = nb_lines > NB_DIALOGS ? nb_lines - NB_DIALOGS : 0;
+	for( i = first; i < nb_lines; i++ )
+	{
+		char line[ DIALOG_SIZE ];
+		memcpy( line, starts[ i % NB_DIALOGS ], lengths[ i % NB_DIALOGS ] );
+		line[ lengths[ i % NB_DIALOGS ] ] = '\0';
+		renderTextOnce( line, x + DIALOG_MARGIN, y + DIALOG_TOP + DIALOG_LINE * ( i - first ), color );
+	}
+}
+
+/**
+ * `renderDialogs` affiche le panneau des dialogues. Il est dessiné une fois
+ * dans `Graphics.dialog_tex`, puis seulement recopié tant que la génération
+ * des dialogues de la partie ne change pas : ses textes ne sont rastérisés
+ * qu'à l'arrivée d'un nouveau dialogue. Sans rendu dans une texture, il est
+ * dessiné à chaque image.
+ * @param game La partie dont les dialogues sont affichés
+ */
+static void renderDialogs( const Gameplay_s* game )
+{
+	if( !Graphics.dialog_tex )
+	{
+		drawDialogs( game, Graphics.rect[ MENU_DIALOG ].x, Graphics.rect[ MENU_DIALOG ].y );
+		return;
+	}
+
+	if( Graphics.dialog_generation != game->dialog_generation )
+	{
+		SDL_SetRenderTarget( Graphics.renderer, Graphics.dialog_tex );
+		SDL_SetRenderDrawColor( Graphics.renderer, 0, 0, 0, 0 );
+		SDL_RenderClear( Graphics.renderer );
+		drawDialogs( game, 0, 0 );
+		SDL_SetRenderDrawColor( Graphics.renderer, 0, 0, 0, 255 );
+		SDL_SetRenderTarget( Graphics.renderer, NULL );
+
+		Graphics.dialog_generation = game->dialog_generation;
+		metricAdd( METRIC_DIALOG_REBUILDS, 1 );
+	}
+
+	renderImage( Graphics.dialog_tex, Graphics.rect[ MENU_DIALOG ] );
+}
+
 /**
  * `renderMenu` affiche un écran et les éléments de l'interface utilisateur
- * selon l'état de jeu `render_state`, ainsi que les 3 dernieres lignes de dialogue
- * avec un NPC `dialogs`.
+ * selon l'état de jeu `render_state`, ainsi que les dernières lignes de dialogue
+ * de la partie `game` (voir @ref renderDialogs).
  * @param render_state L'état du jeu à afficher.
- * @param dialogs Les lignes de dialogues à afficher.
+ * @param game La partie dont les dialogues sont affichés.
  */
-void renderMenu( int render_state, char* dialogs[] )
+void renderMenu( int render_state, const Gameplay_s* game )
 {	
 	SDL_Color color = { 0, 0, 0, 0 };
 
 	renderImage( Graphics.texture[ MENU_BG ], Graphics.rect[ MENU_BG ] );
-	renderImage( Graphics.texture[ MENU_DIALOG ], Graphics.rect[ MENU_DIALOG ] );
+	renderDialogs( game );
 
 	if( render_state == RENDER_EXPLORATION )
 	{
@@ -211,12 +1216,6 @@ void renderMenu( int render_state, char* dialogs[] )
 			renderText( "Quit", Graphics.rect[ MENU_MOVE ].x + 70, Graphics.rect[ MENU_MOVE ].y + 10, color );
 		}
 	}
-
-	int i;
-	int offset = 30;
-
-	for( i = 0; i < 3; i++ )
-		renderText( dialogs[ i ], 10, 402 + offset * i, color );
 }
 
 /**
@@ -226,7 +1225,7 @@ void renderMenu( int render_state, char* dialogs[] )
  * `hp_remains * 100 / hp_all`. Le comportement est indéfini
  * si le joueur amasse une certaine quantité de points de vie.
  * La représentation textuelle de la vie est alors superposée
- * sur la barre de vie.
+ * sur la barre de vie, avec l'atlas des compteurs (voir @ref renderNumber).
  * @param hp_remains Le nombre de points de vie restants.
  * @param hp_all Le nombre de points de vie maximum.
  */
@@ -239,9 +1238,12 @@ void renderHp( int hp_remains, int hp_all )
 	renderImage( Graphics.texture[ HP ], Graphics.rect[ HP ] );
 
 	SDL_Color color = { 0, 0, 0, 0 };
-	char life[ 20 ];
-	sprintf( life, "%d / %d", hp_remains, hp_all );
-	renderText( life, Graphics.rect[ HP_BARRE ].x + 20, Graphics.rect[ HP_BARRE ].y, color );
+	int x = Graphics.rect[ HP_BARRE ].x + 20;
+	int y = Graphics.rect[ HP_BARRE ].y;
+
+	x += renderNumber( hp_remains, x, y, color );
+	x += renderGlyphs( " / ", x, y, color );
+	renderNumber( hp_all, x, y, color );
 }
 
 /**
@@ -285,12 +1287,13 @@ void renderItem( SDL_Texture* texture, int index )
 }
 
 /**
- * `getItemRects` écrit dans le tableau rects les rectangles 
- * des 10 objets qui peuvent tenir dans l'inventaire
- * @param rects Le tableau où copier les coordonnées
+ * `getItemRects` renvoie les rectangles des 10 objets qui peuvent tenir
+ * dans l'inventaire, alloués pour l'image en cours (voir @ref frameAlloc).
+ * @return Les 10 rectangles
  */
-void getItemRects( SDL_Rect rects[] )
+const SDL_Rect* getItemRects()
 {
+	SDL_Rect* rects = frameAlloc( sizeof( SDL_Rect ) * 10 );
 	int i;
 
 	for( i = 0; i < 10; i++ )
@@ -299,53 +1302,49 @@ void getItemRects( SDL_Rect rects[] )
 		rects[ i ].x = 415 + ( ( rects[ i ].w + 48 ) * ( i%4 ) );
 		rects[ i ].y = 88 + ( ( rects[ i ].h + 55 ) * ( i/4 ) );
 	}
+
+	return rects;
 }
 
 /**
-   `renderGold` affiche une quantité d'argent obtenu.
+   `renderGold` affiche une quantité d'argent obtenu, quelle qu'elle soit,
+   avec l'atlas des compteurs (voir @ref renderNumber).
    \param gold La quantité de gold affiché.
  */
 void renderGold( int gold )
 {
-	// D'étrange choses se passerons à plus de 100 million de gold
-	char gold_str[ 8 ];
-	sprintf( gold_str, "%d", gold );
-
 	SDL_Color color = { 0, 0, 0, 0 };
-	renderText( gold_str, 550, 355, color );
+	renderNumber( gold, 550, 355, color );
 }
 
 /**
  * `renderItemDesc` affiche la description d'un objet
- * dans l'inventaire, générallement un objet séléctionné.
+ * dans l'inventaire, générallement un objet séléctionné. Chaque partie de
+ * la description séparée par un ';' est affichée sur sa propre ligne.
  * @param item_desc Une chaine représentant la description d'un objet
  */
-void renderItemDesc( char* item_desc )
+void renderItemDesc( const char* item_desc )
 {
 	SDL_Color color = { 0, 0, 0, 0 };
 	int x = 200;
-	int y;
-	
-	char tmp[ 300 ];
-	int i;
-	int compteur = 0; int nb_lignes = 0;
+	int y = 110;
+
+	/* copie découpée en lignes sur place, libérée à la fin de l'image */
+	char* line = frameFormat( "%s", item_desc );
 
-	while( compteur < strlen( item_desc ) )
+	while( *line )
 	{
-		for( i = 0; item_desc[ compteur ] != ';' && item_desc[ compteur ] != '\0' ; i++ )
-		{
-			tmp[ i ] = item_desc[ compteur ];
-			compteur++;
+		char* end = strchr( line, ';' );
+		if( end )
+			*end = '\0';
 
-		}
-		compteur++;
-		y = 110 + nb_lignes * 30;
-		nb_lignes++;
-		tmp[ i ] = '\0';
-		renderText( tmp, x, y, color );
-		memset( tmp, 0, 300 );
+		renderText( line, x, y, color );
+		y += 30;
+
+		if( !end )
+			break;
+		line = end + 1;
 	}
-	
 }
 
 /**
@@ -378,3 +1377,42 @@ void renderEnd( int won )
 	else
 		renderImage( Graphics.texture[ GAME_OVER ], Graphics.rect[ GAME_OVER ] );
 }
+
+/**
+ * `renderMetrics` affiche le relevé des mesures (voir @ref metricsFormat)
+ * en haut à gauche de l'écran, sur un fond semi-transparent. Le relevé
+ * change à chaque image : il est rastérisé ligne par ligne sans passer par
+ * le cache des textes, et ses propres textures apparaissent donc dans les
+ * mesures de l'image suivante.
+ */
+void renderMetrics()
+{
+	SDL_Color color = { 255, 255, 255, 0 };
+	char* text = frameAlloc( 2048 );
+	char* lines[ METRIC_NB ];
+	int nb_lines = 0;
+
+	metricsFormat( text, 2048 );
+
+	char* line = text;
+	while( *line && nb_lines < METRIC_NB )
+	{
+		char* end = strchr( line, '\n' );
+		if( end )
+			*end = '\0';
+		lines[ nb_lines++ ] = line;
+		if( !end )
+			break;
+		line = end + 1;
+	}
+
+	SDL_Rect back = { 0, 0, 560, METRICS_MARGIN * 2 + METRICS_LINE * nb_lines };
+	SDL_SetRenderDrawBlendMode( Graphics.renderer, SDL_BLENDMODE_BLEND );
+	SDL_SetRenderDrawColor( Graphics.renderer, 0, 0, 0, 160 );
+	SDL_RenderFillRect( Graphics.renderer, &back );
+	SDL_SetRenderDrawColor( Graphics.renderer, 0, 0, 0, 255 );
+
+	int i;
+	for( i = 0; i < nb_lines; i++ )
+		renderTextOnce( lines[ i ], METRICS_MARGIN, METRICS_MARGIN + METRICS_LINE * i, color );
+}
@@ -9,6 +9,41 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_image.h>
 
+#include "Arena.h"
+#include "Gameplay.h"
+#include "ImageCache.h"
+#include "Pack.h"
+#include "TaskGraph.h"
+
+#include <stdatomic.h>
+
+/// Nombre de textes rastérisés gardés par @ref renderText
+#define TEXT_CACHE_SIZE 64
+/// Nombre d'images au bout duquel un texte qui n'est plus affiché est oublié
+#define TEXT_CACHE_TTL 120
+/// Caractères de l'atlas des compteurs, dans l'ordre de l'atlas
+#define GLYPHS "0123456789/ :-"
+/// Nombre de caractères de l'atlas des compteurs
+#define NB_GLYPHS ( ( int )sizeof( GLYPHS ) - 1 )
+/// Marge gauche et droite des lignes du panneau des dialogues
+#define DIALOG_MARGIN 10
+/// Ordonnée de la première ligne du panneau des dialogues
+#define DIALOG_TOP 8
+/// Hauteur d'une ligne du panneau des dialogues
+#define DIALOG_LINE 30
+/// Paquet des images décodées d'avance, construit par `make pack`
+#define ASSET_PACK "Data/assets.pack"
+/// Taille maximale du cache des images décodées des png, en octets
+#define IMAGE_CACHE_CAPACITY ( 256ull << 20 )
+/// Longueur maximale du nom d'une image, fin de chaine comprise
+#define IMAGE_NAME_SIZE PACK_NAME_SIZE
+/// Nombre maximal d'images confiées par @ref offerImage
+#define MAX_OFFERED_IMAGES 128
+/// Nombre de fils qui décodent d'avance les images chargées à la demande
+#define WARMUP_THREADS 1
+/// Budget par défaut des textures en vie, en octets (voir @ref trimTextures)
+#define TEXTURE_BUDGET ( 32l << 20 )
+
 /**
    Constantes correspondantes à des composants d'interface utilisateur
  */
@@ -39,6 +74,82 @@ enum {
 	RENDER_TALK ///< Le joueur parle avec un NPC
 };
 
+/**
+   Sortes de textures, pour le relevé de leur mémoire : la sorte `k` est
+   comptée dans la jauge `METRIC_UI_BYTES + k`
+ */
+enum {
+	TEXTURE_UI, ///< Interface : images de `Graphics.texture`, atlas des compteurs, panneau des dialogues
+	TEXTURE_ZONE, ///< Fonds des zones et des interactions
+	TEXTURE_SPRITE, ///< Sprites de la zone
+	TEXTURE_ITEM, ///< Images des objets
+	TEXTURE_TEXT, ///< Textes rastérisés
+	NB_TEXTURE_KINDS ///< Nombre de sortes de textures
+};
+
+/**
+ * @struct CachedText
+ * @brief Texte rastérisé par @ref renderText, réutilisé tant qu'il est affiché
+ */
+typedef struct
+{
+	char* text; ///< Texte, `NULL` si l'entrée est libre
+	unsigned hash; ///< Empreinte du texte et de la couleur
+	SDL_Color color; ///< Couleur du texte
+	SDL_Texture* texture; ///< Texture du texte
+	int w; ///< Largeur de la texture
+	int h; ///< Hauteur de la texture
+	int last_frame; ///< Dernière image où le texte a été affiché
+} CachedText;
+
+/**
+ * @struct DecodedImage
+ * @brief Image du dossier Img décodée d'avance, par exemple par un autre fil
+ */
+typedef struct
+{
+	char name[IMAGE_NAME_SIZE]; ///< Nom du fichier, sans extension
+	SDL_Surface* surface; ///< Image décodée
+} DecodedImage;
+
+/**
+   États d'une image chargée à la demande
+ */
+enum {
+	LAZY_IDLE, ///< Ni décodée ni en cours de décodage
+	LAZY_QUEUED, ///< Décodage ajouté par @ref warmImage, pas encore commencé
+	LAZY_DECODING, ///< Décodée en arrière-plan par @ref warmImage
+	LAZY_DECODED ///< Décodée en arrière-plan, en attente de sa texture
+};
+
+/**
+ * @struct LazyImage
+ * @brief Image du dossier Img chargée à sa première utilisation
+ * (@ref lazyTexture), ou décodée d'avance en arrière-plan (@ref warmImage)
+ */
+typedef struct
+{
+	char name[IMAGE_NAME_SIZE]; ///< Nom du fichier, vide si aucune image
+	int kind; ///< Sorte de la texture (`TEXTURE_*`)
+	atomic_int state; ///< État du décodage (`LAZY_*`)
+	TaskId task; ///< Tâche de décodage de @ref warmImage, valable hors de l'état `LAZY_IDLE`
+	SDL_Surface* surface; ///< Image décodée d'avance, `NULL` sinon
+	SDL_Texture* texture; ///< Texture, `NULL` tant que l'image n'a pas été utilisée ou depuis qu'elle a été libérée
+	SDL_Rect rect; ///< Dimensions de la texture
+	int last_use; ///< Dernière image où la texture a été utilisée
+} LazyImage;
+
+/**
+ * @struct ZoneImages
+ * @brief Fonds d'une zone, gardés après sa sortie tant que le budget des
+ * textures le permet
+ */
+typedef struct
+{
+	LazyImage bg; ///< Image de fond de la zone
+	LazyImage interaction; ///< Image de fond des interactions de la zone
+} ZoneImages;
+
 /**
  * @struct Graphics_s
  * @brief Structure maintenant une référence vers le contexte
@@ -51,31 +162,105 @@ typedef struct
 
 	SDL_Texture* texture[NB_TEXTURES];
 	SDL_Rect rect[NB_TEXTURES]; 
+
+	LazyImage* items; ///< Image de chaque objet du catalogue \ref Items
+
+	int zone_generation; ///< Génération de la zone dont les images sont chargées
+	SDL_Texture** sprite_tex; ///< Texture de chaque sprite de la zone, indexées comme sa table des sprites
+	int nb_sprites; ///< Nombre de sprites chargés
+	int cap_sprites; ///< Capacité de `sprite_tex`
+	ZoneImages* zones; ///< Fonds de chaque zone déjà visitée, indexés par numéro de zone
+	int nb_zones; ///< Nombre d'entrées de `zones`
+	LazyImage* zone_bg; ///< Image de fond de la zone courante, dans `zones`
+	LazyImage* interaction_bg; ///< Image de fond des interactions de la zone courante, dans `zones`
+
+	SDL_Texture* glyph_tex; ///< Atlas des caractères @ref GLYPHS, en blanc
+	SDL_Rect glyphs[NB_GLYPHS]; ///< Position de chaque caractère dans l'atlas
+	int advance[256]; ///< Avance de chaque caractère de la police, pour couper les dialogues
+
+	SDL_Texture* dialog_tex; ///< Panneau des dialogues déjà dessiné, `NULL` sans rendu dans une texture
+	int dialog_generation; ///< Génération des dialogues dessinés dans `dialog_tex`, -1 pour le redessiner
+
+	Arena frame; ///< Allocations de l'image en cours, libérées par @ref presentFrame
+	int frame_number; ///< Numéro de l'image en cours
+	CachedText texts[TEXT_CACHE_SIZE]; ///< Textes rastérisés récemment
+
+	Pack pack; ///< Paquet @ref ASSET_PACK, fermé s'il est absent : les images sont alors décodées des png
+	ImageCache image_cache; ///< Pixels des png déjà décodés, utilisés pour les images absentes du paquet
+	int assets_open; ///< Non nul quand `pack` et `image_cache` sont ouverts (voir @ref openAssets)
+	DecodedImage offered[MAX_OFFERED_IMAGES]; ///< Images confiées par @ref offerImage
+	int nb_offered; ///< Nombre d'images confiées
+	TaskGraph loader; ///< Décodage en arrière-plan des images chargées à la demande (voir @ref warmImage)
+	long texture_budget; ///< Octets des textures en vie au-delà desquels @ref trimTextures en libère, 0 pour @ref TEXTURE_BUDGET
 } Graphics_s;
 
-/// @brief Instance unique de \ref Graphics_s
-Graphics_s Graphics;
+/// @brief Instance unique de \ref Graphics_s, définie dans Graphics.c
+extern Graphics_s Graphics;
 
+/// @brief Nom des images de l'interface, indexées comme `Graphics.texture`
+extern const char* const TextureNames[NB_TEXTURES];
+
+/// @brief Ouvre la police, depuis n'importe quel fil
+void openFont();
+/// @brief Ouvre le paquet et le cache des images, depuis n'importe quel fil
+void openAssets();
+/// @brief Charge la police et l'écran de début, de quoi afficher la première image
+void initStartScreen();
 /// @brief Initialise la variable globale Graphics
 void initGraphics();
 /// @brief Libère les ressources associées à la variable globale Graphics
-void destroyGraphics();
+void destroyGraphics( void );
+
+/// @brief Alloue une zone mémoire libérée à la fin de l'image
+void* frameAlloc( size_t size );
+/// @brief Met en forme une chaine libérée à la fin de l'image
+char* frameFormat( const char* format, ... ) __attribute__( ( format( printf, 1, 2 ) ) );
+/// @brief Présente l'image et libère ses allocations
+void presentFrame();
 
+/// @brief Décode une image à partir d'un nom de fichier, depuis n'importe quel fil
+SDL_Surface* decodeImage( const char* name );
+/// @brief Confie à @ref loadImage une image décodée d'avance
+void offerImage( const char* name, SDL_Surface* surface );
+/// @brief Libère les images confiées par @ref offerImage
+void clearOfferedImages();
 /// @brief Charge une image à partir d'un nom de fichier
-void loadImage( char* fileName, SDL_Texture** texture, SDL_Rect* rect );
+void loadImage( const char* fileName, SDL_Texture** texture, SDL_Rect* rect, int kind );
+/// @brief Change l'image d'une image chargée à la demande
+void setLazyImage( LazyImage* image, const char* name, int kind );
+/// @brief Lance le décodage en arrière-plan d'une image chargée à la demande
+void warmImage( LazyImage* image );
+/// @brief Renvoie la texture d'une image chargée à la demande, en la chargeant au besoin
+SDL_Texture* lazyTexture( LazyImage* image );
+/// @brief Lance le décodage en arrière-plan des images des objets du joueur
+void warmItems( const Gameplay_s* game );
+/// @brief Charge les images de la zone courante d'une partie
+void syncZoneTextures( const Gameplay_s* game );
+/// @brief Libère les textures inutilisées les plus anciennes au-delà du budget
+void trimTextures( const Gameplay_s* game );
+/// @brief Affiche un élément de la zone
+void renderElement( const Gameplay_s* game, int index );
+/// @brief Renvoie la texture d'un objet de l'inventaire ou de l'équipement
+SDL_Texture* getItemTexture( const Gameplay_s* game, int i, int inventory );
 /// @brief Blit une image dans un rectangle donné
 void renderImage( SDL_Texture* texture, SDL_Rect rect );
 /// @brief Affiche un texte à une position donnée avec une couleur donnée
-void renderText( char* text, int x, int y, SDL_Color color );
+int renderText( const char* text, int x, int y, SDL_Color color );
+/// @brief Affiche une suite de caractères de l'atlas @ref GLYPHS
+int renderGlyphs( const char* text, int x, int y, SDL_Color color );
+/// @brief Affiche un entier avec l'atlas @ref GLYPHS
+int renderNumber( int value, int x, int y, SDL_Color color );
 
 /// @brief Récupère les surface clickable
-void getButtonRects( SDL_Rect rects[] );
+const SDL_Rect* getButtonRects();
+/// @brief Récupère les cases de l'inventaire
+const SDL_Rect* getItemRects();
 
 /// @brief Affiche l'écran de début
 void renderStartScreen();
 
 /// @brief Affiche le menu du joueur, avec un log des conversation du joueur
-void renderMenu( int render_state, char* dialogs[] );
+void renderMenu( int render_state, const Gameplay_s* game );
 /// @brief Affiche la barre de vie du joueur
 void renderHp( int hp_restants, int hp_totaux );
 
@@ -87,10 +272,12 @@ void renderItem( SDL_Texture* texture, int index );
 /// @brief Affiche la quantité d'or du joueur
 void renderGold( int gold );
 /// @brief Affiche la description d'un objet
-void renderItemDesc( char* item_desc );
+void renderItemDesc( const char* item_desc );
 
 /// @brief Met en évidence un objet
 void renderItemHighlighting( int index );
 /// @brief Affiche l'écran de fin du jeu
 void renderEnd( int won );
+/// @brief Affiche le relevé des mesures du jeu
+void renderMetrics();
 #endif
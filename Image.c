@@ -0,0 +1,53 @@
+/**
+ * @file Image.c
+ * Dimensions des images du jeu, lues dans l'en-tête `IHDR` des fichiers png.
+ */
+#include "Image.h"
+#include "Metrics.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Signature d'un fichier png
+static const unsigned char PngSignature[ 8 ] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+/**
+ * `readBig32` lit un entier de 32 bits rangé poids fort en tête.
+ */
+static int readBig32( const unsigned char* p )
+{
+	return ( p[ 0 ] << 24 ) | ( p[ 1 ] << 16 ) | ( p[ 2 ] << 8 ) | p[ 3 ];
+}
+
+/**
+ * `imageSize` lit les dimensions de l'image `Img/<name>.png`, le même fichier
+ * que celui chargé par `loadImage`. Seuls les 24 premiers octets du fichier
+ * sont lus : la signature puis le bloc `IHDR`, qui est toujours le premier.
+ * @param name Nom de l'image sans extension
+ * @param[out] w Largeur de l'image
+ * @param[out] h Hauteur de l'image
+ * @return 0 si les dimensions ont été lues, -1 si le fichier est absent ou
+ * n'est pas un png
+ */
+int imageSize( const char* name, int* w, int* h )
+{
+	char path[ 64 ];
+	snprintf( path, sizeof( path ), "Img/%s.png", name );
+
+	FILE* file = fopen( path, "rb" );
+	metricAdd( METRIC_FILE_OPENS, 1 );
+	if( !file )
+		return -1;
+
+	unsigned char header[ 24 ];
+	size_t n = fread( header, 1, sizeof( header ), file );
+	fclose( file );
+
+	if( n != sizeof( header ) || memcmp( header, PngSignature, 8 ) != 0
+		|| memcmp( header + 12, "IHDR", 4 ) != 0 )
+		return -1;
+
+	*w = readBig32( header + 16 );
+	*h = readBig32( header + 20 );
+	return 0;
+}
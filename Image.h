@@ -0,0 +1,12 @@
+/**
+ * @file Image.h
+ * @brief Lecture des dimensions des images du dossier Img sans les décoder,
+ * pour que le cœur du jeu connaisse la taille des sprites sans la SDL.
+ */
+#ifndef __IMAGE_H__
+#define __IMAGE_H__
+
+/// @brief Lit les dimensions d'une image png du dossier Img
+int imageSize( const char* name, int* w, int* h );
+
+#endif
@@ -0,0 +1,349 @@
+/**
+ * @file ImageCache.c
+ * Cache des images décodées. Chaque image est un fichier
+ * `<empreinte>-<taille>.px` du dossier du cache : un en-tête puis les
+ * pixels, non compressés pour être utilisés directement dans la
+ * projection. La clé est l'empreinte du contenu du png et sa taille : un
+ * png modifié n'a plus la même clé, et son ancienne entrée finit supprimée
+ * par @ref imageCacheTrim.
+ *
+ * La date de modification d'une entrée sert de date de dernier usage : elle
+ * est mise à jour à chaque lecture. Une entrée est écrite dans un fichier
+ * temporaire puis renommée, si bien que plusieurs fils ou plusieurs
+ * instances du jeu peuvent partager le même cache.
+ *
+ * Le dossier n'est parcouru qu'à l'ouverture et quand la taille tenue à jour
+ * par @ref imageCacheStore dépasse la taille maximale. Cette taille ignore
+ * les entrées des autres instances et compte deux fois une entrée réécrite :
+ * le parcours de @ref imageCacheTrim la corrige. Ce parcours supprime aussi
+ * les fichiers temporaires d'écritures interrompues (fil ou instance
+ * arrêtés entre l'écriture et le renommage), plus vieux que
+ * @ref IMAGE_CACHE_TEMP_AGE secondes.
+ */
+#include "ImageCache.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @struct ImageCacheHeader
+ * @brief En-tête d'une entrée du cache, suivie de `4 * w * h` octets de pixels
+ */
+typedef struct
+{
+	char magic[ 4 ]; ///< @ref IMAGE_CACHE_MAGIC
+	uint32_t version; ///< @ref IMAGE_CACHE_VERSION
+	uint32_t w; ///< Largeur de l'image
+	uint32_t h; ///< Hauteur de l'image
+	uint64_t key; ///< Empreinte du png
+	uint64_t source_size; ///< Taille du png
+} ImageCacheHeader;
+
+/**
+ * @struct CacheFile
+ * @brief Entrée du cache vue par @ref imageCacheTrim
+ */
+typedef struct
+{
+	char name[ 64 ]; ///< Nom du fichier
+	uint64_t size; ///< Taille du fichier
+	struct timespec used; ///< Dernier usage
+} CacheFile;
+
+/// Crée un dossier et ses parents, comme `mkdir -p`
+static int makeDirs( char* path )
+{
+	char* p;
+
+	for( p = path + 1; *p; p++ )
+	{
+		if( *p != '/' )
+			continue;
+		*p = '\0';
+		int failed = mkdir( path, 0755 ) != 0 && errno != EEXIST;
+		*p = '/';
+		if( failed )
+			return -1;
+	}
+	return mkdir( path, 0755 ) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+/// Chemin de l'entrée de clé `key`
+static void entryPath( const ImageCache* cache, uint64_t key, uint64_t source_size, char* path, size_t size )
+{
+	snprintf( path, size, "%s/%016llx-%llu.px", cache->dir, ( unsigned long long )key, ( unsigned long long )source_size );
+}
+
+/**
+ * `imageCacheOpen` prépare le cache dans le dossier `dir`, ou par défaut
+ * dans `$XDG_CACHE_HOME/4A/images` (`~/.cache/4A/images`).
+ * @param cache Le cache à remplir
+ * @param dir Le dossier du cache, `NULL` pour le dossier par défaut
+ * @param capacity La taille maximale du cache, en octets
+ * @return 0 en cas de succès, -1 si le dossier n'a pas pu être créé : le
+ * cache reste alors désactivé et ne trouve ni n'ajoute rien
+ */
+int imageCacheOpen( ImageCache* cache, const char* dir, uint64_t capacity )
+{
+	char path[ IMAGE_CACHE_PATH_SIZE ];
+	int n;
+
+	memset( cache, 0, sizeof( *cache ) );
+	cache->capacity = capacity;
+
+	if( dir )
+		n = snprintf( path, sizeof( path ), "%s", dir );
+	else if( getenv( "XDG_CACHE_HOME" ) && *getenv( "XDG_CACHE_HOME" ) )
+		n = snprintf( path, sizeof( path ), "%s/4A/images", getenv( "XDG_CACHE_HOME" ) );
+	else if( getenv( "HOME" ) )
+		n = snprintf( path, sizeof( path ), "%s/.cache/4A/images", getenv( "HOME" ) );
+	else
+		return -1;
+
+	if( n <= 0 || ( size_t )n >= sizeof( path ) - 64 || makeDirs( path ) != 0 )
+		return -1;
+
+	strcpy( cache->dir, path );
+	imageCacheTrim( cache );
+	return 0;
+}
+
+/**
+ * `imageCacheKey` calcule une empreinte de 64 bits du contenu d'un fichier,
+ * 8 octets à la fois.
+ * @param data Le contenu du fichier
+ * @param size Sa taille
+ * @return L'empreinte
+ */
+uint64_t imageCacheKey( const void* data, size_t size )
+{
+	const uint64_t p1 = 0x9e3779b185ebca87ull, p2 = 0xc2b2ae3d27d4eb4full;
+	const unsigned char* bytes = data;
+	uint64_t h = size * p1;
+	size_t i;
+
+	for( i = 0; i + 8 <= size; i += 8 )
+	{
+		uint64_t word;
+		memcpy( &word, bytes + i, 8 );
+		h ^= word * p2;
+		h = ( ( h << 31 ) | ( h >> 33 ) ) * p1;
+	}
+	for( ; i < size; i++ )
+		h = ( h ^ bytes[ i ] ) * p1;
+
+	h ^= h >> 33;
+	h *= p2;
+	h ^= h >> 29;
+	return h;
+}
+
+/**
+ * `imageCacheFind` projette en mémoire les pixels de l'image de clé `key`,
+ * et en fait l'entrée la plus récemment utilisée.
+ * @param cache Le cache
+ * @param key L'empreinte du png (voir @ref imageCacheKey)
+ * @param source_size La taille du png
+ * @param[out] pixels Les pixels trouvés, à libérer avec @ref imageCacheRelease
+ * @return 0 si l'image est dans le cache, -1 sinon
+ */
+int imageCacheFind( const ImageCache* cache, uint64_t key, uint64_t source_size, CachedPixels* pixels )
+{
+	char path[ IMAGE_CACHE_PATH_SIZE + 64 ];
+
+	memset( pixels, 0, sizeof( *pixels ) );
+	if( !cache->dir[ 0 ] )
+		return -1;
+
+	entryPath( cache, key, source_size, path, sizeof( path ) );
+	int fd = open( path, O_RDONLY );
+	if( fd < 0 )
+		return -1;
+
+	struct stat st;
+	if( fstat( fd, &st ) != 0 || ( size_t )st.st_size < sizeof( ImageCacheHeader ) )
+	{
+		close( fd );
+		return -1;
+	}
+
+	void* map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	futimens( fd, NULL );
+	close( fd );
+	if( map == MAP_FAILED )
+		return -1;
+
+	const ImageCacheHeader* header = map;
+	if( memcmp( header->magic, IMAGE_CACHE_MAGIC, 4 ) != 0 || header->version != IMAGE_CACHE_VERSION
+		|| header->key != key || header->source_size != source_size
+		|| ( uint64_t )st.st_size != sizeof( ImageCacheHeader ) + 4ull * header->w * header->h )
+	{
+		munmap( map, st.st_size );
+		unlink( path );
+		return -1;
+	}
+
+	pixels->map = map;
+	pixels->map_size = st.st_size;
+	pixels->w = header->w;
+	pixels->h = header->h;
+	pixels->pixels = header + 1;
+	return 0;
+}
+
+/**
+ * `imageCacheRelease` libère la projection de pixels trouvés par
+ * @ref imageCacheFind.
+ * @param pixels Les pixels à libérer
+ */
+void imageCacheRelease( CachedPixels* pixels )
+{
+	if( pixels->map )
+		munmap( pixels->map, pixels->map_size );
+	memset( pixels, 0, sizeof( *pixels ) );
+}
+
+/**
+ * `imageCacheStore` ajoute au cache les pixels décodés d'un png, puis
+ * supprime les entrées les moins récemment utilisées si sa taille tenue à
+ * jour dépasse la taille maximale.
+ * @param cache Le cache
+ * @param key L'empreinte du png
+ * @param source_size La taille du png
+ * @param w La largeur de l'image
+ * @param h La hauteur de l'image
+ * @param pixels Les pixels ARGB de l'image, sans remplissage
+ * @return 0 en cas de succès, -1 sinon
+ */
+int imageCacheStore( ImageCache* cache, uint64_t key, uint64_t source_size, int w, int h, const void* pixels )
+{
+	char path[ IMAGE_CACHE_PATH_SIZE + 64 ], temp[ IMAGE_CACHE_PATH_SIZE + 96 ];
+
+	if( !cache->dir[ 0 ] )
+		return -1;
+
+	entryPath( cache, key, source_size, path, sizeof( path ) );
+	snprintf( temp, sizeof( temp ), "%s.%ld.%lx.tmp", path, ( long )getpid(), ( unsigned long )pthread_self() );
+
+	FILE* file = fopen( temp, "wb" );
+	if( !file )
+		return -1;
+
+	ImageCacheHeader header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, IMAGE_CACHE_MAGIC, 4 );
+	header.version = IMAGE_CACHE_VERSION;
+	header.w = w;
+	header.h = h;
+	header.key = key;
+	header.source_size = source_size;
+
+	size_t size = ( size_t )w * h * 4;
+	int ok = fwrite( &header, sizeof( header ), 1, file ) == 1 && fwrite( pixels, 1, size, file ) == size;
+	if( fclose( file ) != 0 )
+		ok = 0;
+
+	if( !ok || rename( temp, path ) != 0 )
+	{
+		unlink( temp );
+		return -1;
+	}
+
+	uint64_t added = sizeof( header ) + size;
+	if( atomic_fetch_add( &cache->size, added ) + added > cache->capacity )
+		imageCacheTrim( cache );
+	return 0;
+}
+
+/// Ordre des entrées, de la moins à la plus récemment utilisée
+static int compareUse( const void* a, const void* b )
+{
+	const struct timespec* x = &( ( const CacheFile* )a )->used;
+	const struct timespec* y = &( ( const CacheFile* )b )->used;
+
+	if( x->tv_sec != y->tv_sec )
+		return x->tv_sec < y->tv_sec ? -1 : 1;
+	return ( x->tv_nsec > y->tv_nsec ) - ( x->tv_nsec < y->tv_nsec );
+}
+
+/**
+ * `imageCacheTrim` supprime les fichiers temporaires abandonnés, relève la
+ * taille des entrées du dossier et, si le cache
+ * dépasse sa taille maximale, supprime les moins récemment utilisées
+ * jusqu'à ce qu'il n'en occupe plus que les trois quarts : un cache plein
+ * n'est pas parcouru de nouveau à chaque ajout.
+ * @param cache Le cache
+ */
+void imageCacheTrim( ImageCache* cache )
+{
+	char path[ IMAGE_CACHE_PATH_SIZE + 64 ], temp[ IMAGE_CACHE_PATH_SIZE + 256 ];
+	CacheFile* files = NULL;
+	time_t now = time( NULL );
+	int nb_files = 0, cap_files = 0, i;
+	uint64_t total = 0;
+
+	DIR* dir = cache->dir[ 0 ] ? opendir( cache->dir ) : NULL;
+	if( !dir )
+		return;
+
+	struct dirent* entry;
+	while( ( entry = readdir( dir ) ) )
+	{
+		size_t length = strlen( entry->d_name );
+		struct stat st;
+
+		/* écriture interrompue : un fichier temporaire plus écrit depuis longtemps */
+		if( length > 4 && strcmp( entry->d_name + length - 4, ".tmp" ) == 0 )
+		{
+			snprintf( temp, sizeof( temp ), "%s/%s", cache->dir, entry->d_name );
+			if( stat( temp, &st ) == 0 && now - st.st_mtime > IMAGE_CACHE_TEMP_AGE )
+				unlink( temp );
+			continue;
+		}
+
+		if( length < 4 || length >= sizeof( files->name ) || strcmp( entry->d_name + length - 3, ".px" ) != 0 )
+			continue;
+		snprintf( path, sizeof( path ), "%s/%.63s", cache->dir, entry->d_name );
+		if( stat( path, &st ) != 0 )
+			continue;
+
+		if( nb_files == cap_files )
+		{
+			cap_files = cap_files ? 2 * cap_files : 64;
+			CacheFile* grown = realloc( files, sizeof( CacheFile ) * cap_files );
+			if( !grown )
+				break;
+			files = grown;
+		}
+
+		CacheFile* file = &files[ nb_files++ ];
+		strcpy( file->name, entry->d_name );
+		file->size = st.st_size;
+		file->used = st.st_mtim;
+		total += st.st_size;
+	}
+	closedir( dir );
+
+	if( total > cache->capacity )
+	{
+		qsort( files, nb_files, sizeof( CacheFile ), compareUse );
+		for( i = 0; i < nb_files && total > cache->capacity - cache->capacity / 4; i++ )
+		{
+			snprintf( path, sizeof( path ), "%s/%s", cache->dir, files[ i ].name );
+			unlink( path );
+			total -= files[ i ].size;
+		}
+	}
+	atomic_store( &cache->size, total );
+
+	free( files );
+}
@@ -0,0 +1,60 @@
+/**
+ * @file ImageCache.h
+ * @brief Cache sur disque des images déjà décodées : les pixels d'un png
+ * sont rangés sous l'empreinte de son contenu, et relus par projection en
+ * mémoire au lieu d'être décodés de nouveau.
+ */
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Signature des fichiers du cache
+#define IMAGE_CACHE_MAGIC "4AIC"
+/// Version du format des fichiers du cache
+#define IMAGE_CACHE_VERSION 1
+/// Taille maximale du chemin du dossier du cache
+#define IMAGE_CACHE_PATH_SIZE 256
+/// Âge, en secondes, au-delà duquel un fichier temporaire du cache est celui d'une écriture interrompue
+#define IMAGE_CACHE_TEMP_AGE 300
+
+/**
+ * @struct ImageCache
+ * @brief Dossier du cache, sa taille maximale et sa taille actuelle
+ */
+typedef struct
+{
+	char dir[ IMAGE_CACHE_PATH_SIZE ]; ///< Dossier du cache, vide si le cache est désactivé
+	uint64_t capacity; ///< Taille maximale du cache, en octets
+	atomic_ullong size; ///< Taille des entrées, relevée par @ref imageCacheTrim puis tenue à jour par @ref imageCacheStore
+} ImageCache;
+
+/**
+ * @struct CachedPixels
+ * @brief Pixels d'une image du cache, projetés en mémoire
+ */
+typedef struct
+{
+	void* map; ///< Projection du fichier
+	size_t map_size; ///< Taille de la projection
+	int w; ///< Largeur de l'image
+	int h; ///< Hauteur de l'image
+	const void* pixels; ///< Pixels ARGB, ligne après ligne sans remplissage
+} CachedPixels;
+
+/// @brief Ouvre le cache, en créant son dossier au besoin
+int imageCacheOpen( ImageCache* cache, const char* dir, uint64_t capacity );
+/// @brief Calcule l'empreinte du contenu d'un fichier source
+uint64_t imageCacheKey( const void* data, size_t size );
+/// @brief Cherche les pixels d'une image dans le cache
+int imageCacheFind( const ImageCache* cache, uint64_t key, uint64_t source_size, CachedPixels* pixels );
+/// @brief Libère la projection de pixels trouvés par @ref imageCacheFind
+void imageCacheRelease( CachedPixels* pixels );
+/// @brief Ajoute les pixels d'une image au cache
+int imageCacheStore( ImageCache* cache, uint64_t key, uint64_t source_size, int w, int h, const void* pixels );
+/// @brief Supprime les images les moins récemment utilisées au-delà de la taille maximale
+void imageCacheTrim( ImageCache* cache );
+
+#endif
@@ -3,12 +3,13 @@
  * Gestion de l'inventaire et de l'équipement du joueur :\n
  * - Définition de l'ensemble @ref Items des objets du jeu à partir du fichier
  * `"Data/equipement.txt"`.\n
- * - Gestion dynamique de l'inventaire @ref InvJoueur du joueur.\n
- * - Gestion dynamique de l'équipement @ref EquipementCourant du joueur.\n
+ * - Gestion dynamique de l'inventaire @ref Inventory d'une partie.\n
+ * - Gestion dynamique de l'équipement `Inventory.equipment` du joueur.\n
  */
 
 #include "Inventory.h"
-#include "Graphics.h"
+#include "Log.h"
+#include "Metrics.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,21 +19,12 @@
 /** type entier non signé qui n'est jamais utilisé. */
 typedef unsigned int uint;
 
-/**
- * Tableau de deux entiers représentant l'équipement courant du joueur. La
- * première case doit contenir l'identifiant d'un objet de type attaque, et la
- * seconde, l'identifiant d'un objet de type défense.\n
- * Les identifiants par défaut (24 et 18) ne correspondent à aucun objet dans
- * le fichier `"Data/equipement.txt"`.
- */
-int EquipementCourant[2]={24,18};
+/** Catalogue des objets du jeu, lu une fois et partagé par les parties. */
+Item* Items;
+
+/** Nombre d'objets du catalogue @ref Items. */
+int NbItems;
 
-/**
- * Inventaire du joueur.\n
- * Tableau statique de 8 valeurs contenant les identifiants des objets détenus
- * par le joueur.
- */
-int InvJoueur[8];
 /** Inventaire du marchand d'arme.\n
 	Tableau statique de 8 valeurs, jamais utilisé **/
 int InvMarchandArme[8] = {20, 21, 22, 23, 19, 0, 0, 0};
@@ -40,9 +32,6 @@ int InvMarchandArme[8] = {20, 21, 22, 23, 19, 0, 0, 0};
 	Tableau statique de 8 valeurs, jamais utilisé **/
 int InvMarchandArmure[8] =  {16, 17, 18, 0, 0, 0, 0, 0};
 
-/** Réserve d'or du joueur */
-int Gold;
-
 /**
  * Modifie les variables globales @ref Items et @ref NbItems :\n
  * - @ref NbItems reçoit le nombre de lignes du fichier `"Data/equipement.txt"`\n
@@ -50,18 +39,22 @@ int Gold;
  * - Chaque élément du tableau est initialisé aux valeurs définies à la ligne
  * corespondante du fichier `"Data/equipement.txt"`, suivant le format [nom]
  * [id] [value_stat] [stat] [price] [description].\n
- * Si @ref Items est déjà alloué avant l'appel à la fonction @ref initItems(),
- * une fuite de mémoire se produit.\n
+ * Si @ref Items est déjà alloué, la fonction ne fait rien : le catalogue est
+ * en lecture seule et partagé par toutes les parties.\n
  * L'accès au fichier `"Data/equipement.txt"` n'est pas sécurisé et il n'y a
  * pas de gestion d'erreurs. C'est pourquoi chaque ligne du fichier
  * `"Data/equipement.txt"` doit respecter scupuleusement le format demandé.
  */
 void initItems()
 {
+	if( Items )
+		return;
+
 	FILE* file = fopen( "Data/equipement.txt", "r" );
+	metricAdd( METRIC_FILE_OPENS, 1 );
 	if( !file )
 	{
-		printf( "equipement.txt not found" );
+		logError( "Data/equipement.txt not found" );
 		return;
 	}
 
@@ -74,14 +67,10 @@ void initItems()
 		fscanf( file, "%s %d %d %d %d %s\n", item.name, &item.id, &item.value_stat, &item.stat, &item.price, item.description );
 		removeUnderscore( item.description );
 
-		SDL_Rect rect;
-		loadImage( item.name, &item.tex, &rect );
-
 		Items = realloc( Items, sizeof( *Items ) * ( NbItems + 1 ) );
+		metricAdd( METRIC_HEAP_ALLOCS, 1 );
 		Items[ NbItems ] = item;
 
-		item.tex = NULL;
-
 		NbItems++;
 	}
 
@@ -89,32 +78,34 @@ void initItems()
 }
 
 /**
- * Libère le champs `.tex` de chacune des structures @ref Item du tableau @ref
- * Items, puis libère le pointeur sur @ref Items.
+ * Libère le pointeur sur @ref Items. Les textures des objets appartiennent
+ * au client graphique, qui les libère lui-même.
  */
 void closeItems()
 {
-	int i;
-	for( i = 0; i < NbItems; i++ )
-		SDL_DestroyTexture( Items[ i ] .tex );
-
 	free( Items );
+	Items = NULL;
+	NbItems = 0;
 }
 
 /**
- * Initialise l'inventaire du joueur @ref InvJoueur.
- * @return Pointeur @ref InvJoueur sur l'inventaire du joueur
+ * Initialise l'inventaire `inv` : aucun objet, @ref START_GOLD pièces d'or
+ * et l'équipement par défaut. Les identifiants par défaut de l'équipement
+ * (24 et 18) ne correspondent à aucun objet dans le fichier
+ * `"Data/equipement.txt"`.
+ * @param inv : l'inventaire à initialiser.
+ * @return Pointeur sur les objets de l'inventaire
  */
-int * inventoryInit () {
-	int incrementation;                        // pas utilisé
-	memset(InvJoueur, 0, sizeof(InvJoueur));
-	Gold = START_GOLD;
-	return InvJoueur;
+int * inventoryInit (Inventory * inv) {
+	memset(inv->items, 0, sizeof(inv->items));
+	inv->gold = START_GOLD;
+	inv->equipment[0] = 24;
+	inv->equipment[1] = 18;
+	return inv->items;
 }
 
 /**
- * Cherche l'objet d'identifiant `id` dans l'inventaire du joueur @ref
- * InvJoueur. Produit une erreur `assert(0)` si l'objet demandé n'appartient
+ * Cherche l'objet d'identifiant `id` dans le catalogue @ref Items. Produit une erreur `assert(0)` si l'objet demandé n'appartient
  * pas à l'inventaire.
  * @param id : l'identifiant d'un objet
  * @return pointeur sur l'objet d'indentifiant `id`.
@@ -130,10 +121,30 @@ Item* getItemFromID(int id)
 		}
 	}
 
-	printf( "Item missing %d\n", id );
+	logError( "Item missing %d", id );
 	assert( 0 );
 }
 
+/**
+ * Indique si `id` est 0, la case vide, ou l'identifiant d'un objet du
+ * catalogue @ref Items : seuls ceux-là peuvent être passés à
+ * @ref getItemFromID sans erreur.
+ * @param id : un identifiant d'objet quelconque.
+ * @return 1 si l'identifiant est connu, 0 sinon.
+ */
+int itemKnown(int id)
+{
+	int i;
+	if( id == 0 )
+		return 1;
+	for( i = 0; i < NbItems; i++ )
+	{
+		if( id == Items[ i ].id )
+			return 1;
+	}
+	return 0;
+}
+
 /**
  * Modifie la chaîne de caractères `description` passée en argument en
  * remplaçant chaque caractère '_' par un espace. Cette fonction est de
@@ -154,107 +165,111 @@ void removeUnderscore( char* description )
 
 
 /**
- * Modifie l'inventaire du joueur @ref InvJoueur en lui ajoutant l'objet
- * d'identifiant `id_obj`. Si l'inventaire est plein, l'objet n'est pas ajouté
- * et un affichage le signale. Si la constante @ref MAX_ITEM est supérieure à
- * 8, un débordement de mémoire se produira.
+ * Modifie l'inventaire `inv` en lui ajoutant l'objet d'identifiant `id_obj`.
+ * Si l'inventaire est plein, l'objet n'est pas ajouté et un affichage le
+ * signale.
+ * @param inv : l'inventaire du joueur.
  * @param id_obj : identifiant de l'objet à ajouter à l'inventaire.
- * @return pointeur @ref InvJoueur sur l'inventaire du joueur
+ * @return pointeur sur les objets de l'inventaire
  */
-int * inventoryAdd(int id_obj) {
+int * inventoryAdd(Inventory * inv, int id_obj) {
 	int incrementation, plein =0;
 
 	for (incrementation = 0; incrementation < MAX_ITEM; incrementation ++) {
-		if (InvJoueur[incrementation] == 0) {
-			InvJoueur[incrementation] = id_obj;
-			return InvJoueur;
+		if (inv->items[incrementation] == 0) {
+			inv->items[incrementation] = id_obj;
+			return inv->items;
 		}
 		else plein ++;
 		if (plein == MAX_ITEM){
-			printf("Ton inventaire est plein. What a shame! Supprime un objet ou oublie\n");
-			return InvJoueur;
+			logInfo("inventory full, item %d not added", id_obj);
+			return inv->items;
 		}
 	}
 
-	return InvJoueur;
+	return inv->items;
 }
 
 /**
- * Modifie la variable globale @ref Gold en lui ajoutant la valeur de son
- * argument `gold_more`, laquelle peut être négative.
- * @param gold_more : la quantité d'or à ajouter à @ref Gold
- * @return la nouvelle valeur de la variable @ref Gold
+ * Modifie la réserve d'or de `inv` en lui ajoutant la valeur de son argument
+ * `gold_more`, laquelle peut être négative.
+ * @param inv : l'inventaire du joueur.
+ * @param gold_more : la quantité d'or à ajouter
+ * @return la nouvelle réserve d'or
  */
-int inventoryAddGold(int gold_more) {
-	Gold += gold_more;
-	return Gold;
+int inventoryAddGold(Inventory * inv, int gold_more) {
+	inv->gold += gold_more;
+	return inv->gold;
 }
 
 /**
- * Modifie l'inventaire du joueur @ref InvJoueur en lui retranchant l'objet
- * d'identifiant `id_obj`. Le cas échéant, un affichage signale que l'objet
- * `id_obj` n'apparaît pas dans @ref InvJoueur. Si la constante @ref MAX_ITEM
- * est supérieur à 8, un débordement de mémoire se produira.
+ * Modifie l'inventaire `inv` en lui retranchant l'objet d'identifiant
+ * `id_obj`. Le cas échéant, un affichage signale que l'objet `id_obj`
+ * n'apparaît pas dans l'inventaire.
+ * @param inv : l'inventaire du joueur.
  * @param id_obj : identifiant de l'objet à retirer à l'inventaire.
- * @return Pointeur @ref InvJoueur sur l'inventaire du joueur
+ * @return Pointeur sur les objets de l'inventaire
  */
-int * inventoryDel(int id_obj) {
-	int incrementation, present;
+int * inventoryDel(Inventory * inv, int id_obj) {
+	int incrementation, present = 0;
 
    for(incrementation = 0; incrementation < MAX_ITEM; incrementation ++) {
-	  if (InvJoueur[incrementation] == id_obj) {
-		InvJoueur[incrementation] = 0;
-		if (id_obj == EquipementCourant[0]) EquipementCourant[0] = 0;
-		if (id_obj == EquipementCourant[1]) EquipementCourant[1] = 0;
-		return InvJoueur;
+	  if (inv->items[incrementation] == id_obj) {
+		inv->items[incrementation] = 0;
+		if (id_obj == inv->equipment[0]) inv->equipment[0] = 0;
+		if (id_obj == inv->equipment[1]) inv->equipment[1] = 0;
+		return inv->items;
 	  }
 	  else present ++;
 	}
 	if (present == MAX_ITEM) {
-		printf("Ton inventaire ne contient pas l'objet\n");
-		return InvJoueur;
+		logWarn("item %d not in inventory", id_obj);
+		return inv->items;
 	 }
-return InvJoueur;
+return inv->items;
 }
 
 /**
- * Modifie la variable globale @ref Gold en lui retranchant la valeur de son
+ * Modifie la réserve d'or de `inv` en lui retranchant la valeur de son
  * argument `gold_less`, laquelle peut être négative.
- * @param gold_more : la quantité d'or à retrancher à @ref Gold
- * @return la nouvelle valeur de la variable @ref Gold
+ * @param inv : l'inventaire du joueur.
+ * @param gold_less : la quantité d'or à retrancher
+ * @return la nouvelle réserve d'or
  */
-int inventoryDelGold(int gold_less) {
-	Gold -= gold_less;
-	return Gold;
+int inventoryDelGold(Inventory * inv, int gold_less) {
+	inv->gold -= gold_less;
+	return inv->gold;
 }
 
 
 /**
-  * Teste si la valeur de @ref Gold est supérieure au prix de l'objet
+  * Teste si la réserve d'or de `inv` est supérieure au prix de l'objet
   * d'identifiant `id_obj`
+  * @param inv : l'inventaire du joueur.
   * @param id_obj : identifiant d'un objet
   * \return
-  * - `1` si la valeur de @ref Gold est supérieure au prix de l'objet
+  * - `1` si la réserve d'or est supérieure au prix de l'objet
   * d'identifiant `id_obj`\n
   * - `-1` en cas d'erreur\n
   * - `0` sinon.\n
   */
-int enoughtGold(int id_obj) {
+int enoughtGold(Inventory * inv, int id_obj) {
 	int incrementation;
 	char nom[15], type[4];
 	int equi, ajout_stat, temporaire, cout;
 	FILE * equipement;
 	equipement=fopen("equipement.txt", "r+");
+	metricAdd(METRIC_FILE_OPENS, 1);
 	if(equipement == NULL)
    {
-	  printf("Error in opening file");
+	  logError("equipement.txt not found");
 	  return -1;
    }
 	while (!feof(equipement)) {
 		fscanf(equipement, "%s %d %d %s %d\n", nom, &equi, &ajout_stat, type, &cout);
 		if (id_obj == equi) {
-			if (cout < Gold) {
-				inventoryDelGold(cout);
+			if (cout < inv->gold) {
+				inventoryDelGold(inv, cout);
 				return 1;
 			}
 			else return 0;
@@ -263,47 +278,48 @@ int enoughtGold(int id_obj) {
 }
 
 /**
-  * Affiche une description de l'équipement @ref EquipementCourant du joueur.
-  * Les deux entiers du tableau global @ref EquipementCourant sont les
+  * Affiche une description de l'équipement `inv->equipment` du joueur.
+  * Les deux entiers du tableau `inv->equipment` sont les
   * identifiants de deux objets décrits dans le fichier `"equipement.txt"`.
   * Lors de l'appel à cette fonction, le fichier "equipement.txt" est ouvert
   * en mode lecture et écriture. Si l'ouverture du fichier échoue, un affichage
   * le signale.
   */
-void equipementContenu() {
+void equipementContenu(const Inventory * inv) {
 	int incrementation;
 	int id_obj;
 	char nom[15], type[4];
 	int equi, ajout_stat, cout;
 	FILE * equipement;
 	equipement=fopen("equipement.txt", "r+");
+	metricAdd(METRIC_FILE_OPENS, 1);
 	if(equipement == NULL)
    {
-	  printf("Error in opening file");
+	  logError("equipement.txt not found");
 	  return ;
    }
 	while (!feof(equipement)) {
 		fscanf(equipement, "%s %d %d %s %d\n", nom, &equi, &ajout_stat, type, &cout);
-		if (EquipementCourant[0] == equi) printf("Vous êtes équipé d'un(e) %s qui rajoute %d en %s (id : %d)\n", nom, ajout_stat, type, equi);
-		if (EquipementCourant[1] == equi) printf("Vous êtes équipé d'un(e) %s qui rajoute %d en %s (id : %d)\n", nom, ajout_stat, type, equi);
+		if (inv->equipment[0] == equi) printf("Vous êtes équipé d'un(e) %s qui rajoute %d en %s (id : %d)\n", nom, ajout_stat, type, equi);
+		if (inv->equipment[1] == equi) printf("Vous êtes équipé d'un(e) %s qui rajoute %d en %s (id : %d)\n", nom, ajout_stat, type, equi);
 	}
 }
 
 /**
- * Modifie le tableau global @ref EquipementCourant.\n
+ * Modifie l'équipement `inv->equipment` du joueur.\n
  * Demande à l'utilisateur l'identifiant de l'objet qu'il souhaite prendre en
  * main, via l'entrée standard (non protégée) :\n
  * - Si l'objet désiré est de type "attaque", l'identifiant de l'objet est
  * affecté à la première case du tableau.\n
  * - Si l'objet désiré est de type "défense", l'identifiant de l'objet est
  * affecté à la deuxième case du tableau.\n
- * - Si le tableau `EquipementCourant` contient déjà l'identifiant d'un objet
+ * - Si le tableau `inv->equipment` contient déjà l'identifiant d'un objet
  * de type "attaque" ou "défense", l'utilisateur est invité à confirmer qu'il
  * souhaite en effet remplacer cet objet par le nouveau, en saissisant via
  * l'entrée standard (non protégée), le nombre `1` (pour Oui) ou le nombre `2`
  * (pour Non).
  */
-void equiper() {
+void equiper(Inventory * inv) {
 	int reponse;
 	char * type_att = "att";
 	char * type_def = "def";
@@ -313,9 +329,10 @@ void equiper() {
 	int equi, ajout_stat, temporaire, cout;
 	FILE * equipement;
 	equipement=fopen("equipement.txt", "r+");
+	metricAdd(METRIC_FILE_OPENS, 1);
 	if(equipement == NULL)
    {
-	  printf("Error in opening file");
+	  logError("equipement.txt not found");
 	  return ;
    }
 	printf("Entrez un equipement que vous voulez equiper (vous ne pouvez avoir qu'une seule arme et une seule armure d'equiper en meme temps):");
@@ -324,27 +341,27 @@ void equiper() {
 		fscanf(equipement, "%s %d %d %s %d\n", nom, &equi, &ajout_stat, type, &cout);
 		for (incrementation = 0; incrementation < MAX_ITEM; incrementation ++) {
 			if (equi == id_obj && !strcmp(type, type_att)) {
-				if (EquipementCourant[0] == 0) EquipementCourant[0] = id_obj;
+				if (inv->equipment[0] == 0) inv->equipment[0] = id_obj;
 				else {
 					printf("Il y a deja un objet en attaque. Le remplacer? (1 pour oui, 2 pour non) \n");
 					scanf("%d", &reponse);
 					if (reponse == 1) {
-						EquipementCourant[0] = id_obj;
+						inv->equipment[0] = id_obj;
 						return;
 					}
 					else return;
 				}
 			}
 			if (equi == id_obj  && !strcmp(type, type_def)) {
-				if (EquipementCourant[1] == 0) {
-					EquipementCourant[1] = id_obj;
+				if (inv->equipment[1] == 0) {
+					inv->equipment[1] = id_obj;
 					return;
 				}
 				else {
 					printf("Il y a deja un objet en defense. Le remplacer? (1 pour oui, 2 pour non) \n");
 					scanf("%d", &reponse);
 					if (reponse == 1) {
-						EquipementCourant[1] = id_obj;
+						inv->equipment[1] = id_obj;
 						return;
 					}
 					else return;
@@ -355,7 +372,7 @@ void equiper() {
 }
 
 /**
- * Modifie le tableau global @ref  EquipementCourant.\n
+ * Modifie l'équipement `inv->equipment` du joueur.\n
  * Invite l'utilisateur en déséquiper un objet en saisissant l'identifiant de
  * l'objet via l'entrée standard (non protégée).\n
  * - Si l'identifiant saisi égale la valeur de la première case du tableau, le
@@ -365,12 +382,12 @@ void equiper() {
  * - Si l'identifiant saisi n'apparaît pas dans le tableau, un affichage le
  * signale.
  */
-void desequiper() {
+void desequiper(Inventory * inv) {
 	int id_obj;
 	printf("Entrez un equipement que vous voulez desequiper :");
 	scanf("%d", &id_obj);
-	if(EquipementCourant[0] == id_obj) { EquipementCourant[0] = 0; return; }
-	if(EquipementCourant[1] == id_obj) { EquipementCourant[1] = 0; return; }
+	if(inv->equipment[0] == id_obj) { inv->equipment[0] = 0; return; }
+	if(inv->equipment[1] == id_obj) { inv->equipment[1] = 0; return; }
 	else printf("vous n'avez pas cet objet equipé");
 }
 
@@ -387,7 +404,7 @@ void desequiper() {
 	equipement=fopen("equipement.txt", "r+");
 	if(equipement == NULL)
    {
-	  printf("Error in opening file");
+	  logError("equipement.txt not found");
 	  return(invJoueur);
    }
    if (npc == 0) {
@@ -5,8 +5,6 @@
  * \file Inventory.h
  */
 
-#include <SDL2/SDL.h>
-
 /// Nombre maximal d'élément dans l'inventaire du joueur
 #define MAX_ITEM 8
 
@@ -25,39 +23,51 @@ typedef struct
 	int stat;                 ///< statut de l'objet : 0 = aucun / 1 = attaque / 2 = défense.
 	int price;                ///< prix de l'objet
 	char description[ 300 ];  ///< description de l'objet
-	SDL_Texture * tex;        ///< texture de l'objet
 } Item;
 
-/// Tableau référençant tout les objets du jeu.
-Item* Items;
+/**
+ * Inventaire d'une partie : objets portés, or et équipement saisi par les
+ * fonctions en mode console.
+ */
+typedef struct
+{
+	int items[ MAX_ITEM ];    ///< identifiants des objets détenus par le joueur, 0 pour une case vide
+	int gold;                 ///< réserve d'or du joueur
+	int equipment[ 2 ];       ///< équipement courant : un objet d'attaque et un objet de défense
+} Inventory;
+
+/// Tableau référençant tout les objets du jeu, partagé par toutes les parties.
+extern Item* Items;
 
 /// Nombre d'objets du jeu.
-int NbItems;
+extern int NbItems;
 
 /// \brief Initialise les variables globales \ref Items et \ref NbItems suivant le contenu du fichier `"Data/equipement.txt"`
 void initItems();
 /// \brief Libère la mémoire de chaque élément du tableau global \ref Items puis libère le pointeur sur \ref Items 
 void closeItems();
-/// \brief Initialise l'inventaire du joueur \ref InvJoueur
-int * inventoryInit ();
-/// \brief Accède à l'objet d'identifiant `id` dans l'inventaire du joueur \ref InvJoueur.
+/// \brief Initialise l'inventaire du joueur
+int * inventoryInit (Inventory * inv);
+/// \brief Accède à l'objet d'identifiant `id` dans le tableau \ref Items.
 Item* getItemFromID(int id);
+/// \brief Indique si `id` est une case vide ou l'identifiant d'un objet de \ref Items.
+int itemKnown(int id);
 /// \brief Ajoute un objet à l'inventaire du joueur 
-int * inventoryAdd(int id_obj);
+int * inventoryAdd(Inventory * inv, int id_obj);
 /// \brief Modifie la réserve d'or du joueur. 
-int inventoryAddGold(int gold_more);
+int inventoryAddGold(Inventory * inv, int gold_more);
 /// \brief Retir un objet à l'inventaire du joueur 
-int * inventoryDel(int id_obj);
+int * inventoryDel(Inventory * inv, int id_obj);
 /// \brief Modifie la réserve d'or du joueur. 
-int inventoryDelGold(int gold_less);
+int inventoryDelGold(Inventory * inv, int gold_less);
 /// \brief Prédicat indiquant si le joueur a suffisamment d'or pour obtenir un certain objet.
-int enoughtGold(int id_obj);
+int enoughtGold(Inventory * inv, int id_obj);
 /// \brief Affiche une description de l'équipement.
-void equipementContenu();
+void equipementContenu(const Inventory * inv);
 /// \brief Demande à l'utilisateur quel objet il souhaite équiper.
-void equiper();
+void equiper(Inventory * inv);
 /// \brief Demande à l'utilisateur quel objet il souhaite déséquiper.
-void desequiper();
+void desequiper(Inventory * inv);
 
 /// \brief Fonction non définie.
 int getGold();
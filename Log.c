@@ -0,0 +1,289 @@
+/**
+ * @file Log.c
+ * Journal par niveaux. Tant que @ref logInit n'a pas été appelée, les
+ * messages sont écrits directement sur la sortie d'erreur. Ensuite, chaque
+ * thread qui écrit reçoit un tampon circulaire à un seul producteur (lui) et
+ * un seul consommateur (le thread d'écriture) : écrire un message ne prend
+ * aucun verrou, seuls les consommateurs se partagent un mutex.
+ */
+#include "Log.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// Longueur maximale d'un message, sans le préfixe
+#define LOG_TEXT_SIZE 200
+/// Nombre de messages d'un tampon, puissance de deux
+#define LOG_RING_SIZE 128
+/// Période du thread d'écriture, en millisecondes
+#define LOG_PERIOD_MS 10
+
+/**
+ * @struct LogRecord
+ * @brief Message en attente d'écriture
+ */
+typedef struct
+{
+	const char* file; ///< Fichier source de l'appel
+	int line; ///< Ligne de l'appel
+	int level; ///< Niveau du message
+	unsigned suppressed; ///< Messages du même appel ignorés avant celui-ci
+	char text[ LOG_TEXT_SIZE ]; ///< Texte mis en forme
+} LogRecord;
+
+/**
+ * @struct LogRing
+ * @brief Tampon circulaire d'un thread. `head` n'est écrit que par le thread
+ * propriétaire, `tail` que par le consommateur.
+ */
+typedef struct LogRing
+{
+	LogRecord records[ LOG_RING_SIZE ]; ///< Messages
+	atomic_uint head; ///< Nombre de messages écrits
+	atomic_uint tail; ///< Nombre de messages vidés
+	atomic_uint dropped; ///< Messages perdus faute de place
+	atomic_int in_use; ///< Non nul tant qu'un thread possède le tampon
+	struct LogRing* next; ///< Tampon suivant dans la liste de tous les tampons
+} LogRing;
+
+static FILE* Out = NULL; ///< Destination des messages, `stderr` si `NULL`
+static atomic_int Level = LOG_INFO; ///< Niveau minimal des messages écrits
+static atomic_int Running = 0; ///< Non nul si le thread d'écriture tourne
+static atomic_int Stop = 0; ///< Demande l'arrêt du thread d'écriture
+static pthread_t Writer; ///< Thread d'écriture
+
+static LogRing* _Atomic Rings = NULL; ///< Tous les tampons, jamais libérés
+static _Thread_local LogRing* Ring = NULL; ///< Tampon du thread courant
+static pthread_key_t RingKey; ///< Rend le tampon d'un thread qui se termine
+static pthread_once_t RingKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t DrainLock = PTHREAD_MUTEX_INITIALIZER; ///< Sérialise les consommateurs
+
+/**
+ * `writeRecord` écrit un message dans `out`, précédé de son niveau et de
+ * l'appel d'où il vient. Le préfixe est ajouté ici, par le consommateur,
+ * plutôt que par le thread qui écrit le message.
+ */
+static void writeRecord( FILE* out, const LogRecord* record )
+{
+	static const char levels[] = { 'D', 'I', 'W', 'E' };
+
+	fprintf( out, "[%c] %s:%d: %s", levels[ record->level & 3 ], record->file, record->line, record->text );
+	if( record->suppressed )
+		fprintf( out, " (%u similar messages suppressed)", record->suppressed );
+	fputc( '\n', out );
+}
+
+/// Rend son tampon à la liste quand un thread se termine
+static void releaseRing( void* ring )
+{
+	atomic_store_explicit( &( ( LogRing* )ring )->in_use, 0, memory_order_release );
+}
+
+static void createRingKey()
+{
+	pthread_key_create( &RingKey, releaseRing );
+}
+
+/**
+ * `acquireRing` donne le tampon du thread courant : un tampon rendu par un
+ * thread terminé, sinon un nouveau tampon ajouté à la liste.
+ * @return Le tampon, ou `NULL` si l'allocation échoue
+ */
+static LogRing* acquireRing()
+{
+	LogRing* ring;
+
+	if( Ring )
+		return Ring;
+
+	pthread_once( &RingKeyOnce, createRingKey );
+
+	for( ring = atomic_load( &Rings ); ring; ring = ring->next )
+	{
+		int free_ring = 0;
+		if( atomic_compare_exchange_strong( &ring->in_use, &free_ring, 1 ) )
+			break;
+	}
+
+	if( !ring )
+	{
+		ring = calloc( 1, sizeof( LogRing ) );
+		if( !ring )
+			return NULL;
+		atomic_store( &ring->in_use, 1 );
+
+		ring->next = atomic_load( &Rings );
+		while( !atomic_compare_exchange_weak( &Rings, &ring->next, ring ) )
+			;
+	}
+
+	Ring = ring;
+	pthread_setspecific( RingKey, ring );
+	return ring;
+}
+
+/**
+ * `drain` écrit les messages de tous les tampons, en signalant ceux qui ont
+ * été perdus. Appelée par le thread d'écriture et par @ref logFlush.
+ */
+static void drain()
+{
+	FILE* out = Out ? Out : stderr;
+	LogRing* ring;
+
+	pthread_mutex_lock( &DrainLock );
+
+	for( ring = atomic_load( &Rings ); ring; ring = ring->next )
+	{
+		unsigned tail = atomic_load_explicit( &ring->tail, memory_order_relaxed );
+		unsigned head = atomic_load_explicit( &ring->head, memory_order_acquire );
+		unsigned dropped = atomic_exchange( &ring->dropped, 0 );
+
+		if( dropped )
+			fprintf( out, "[W] log: %u messages dropped\n", dropped );
+
+		for( ; tail != head; tail++ )
+			writeRecord( out, &ring->records[ tail % LOG_RING_SIZE ] );
+
+		atomic_store_explicit( &ring->tail, tail, memory_order_release );
+	}
+
+	fflush( out );
+	pthread_mutex_unlock( &DrainLock );
+}
+
+/// Boucle du thread d'écriture
+static void* writerMain( void* arg )
+{
+	struct timespec period = { 0, LOG_PERIOD_MS * 1000000L };
+	( void )arg;
+
+	while( !atomic_load( &Stop ) )
+	{
+		drain();
+		nanosleep( &period, NULL );
+	}
+	return NULL;
+}
+
+/**
+ * `logInit` démarre le thread d'écriture. Les messages écrits jusque-là
+ * l'ont été directement.
+ * @param out La destination des messages, `stderr` si `NULL`
+ * @param level Le niveau minimal des messages écrits (`LOG_*`)
+ * @return 0 en cas de succès, -1 si le thread n'a pas pu être créé
+ */
+int logInit( FILE* out, int level )
+{
+	Out = out;
+	atomic_store( &Level, level );
+
+	if( atomic_load( &Running ) )
+		return 0;
+
+	atomic_store( &Stop, 0 );
+	if( pthread_create( &Writer, NULL, writerMain, NULL ) != 0 )
+		return -1;
+
+	atomic_store( &Running, 1 );
+	return 0;
+}
+
+/**
+ * `logShutdown` arrête le thread d'écriture et écrit les derniers messages.
+ * Les threads qui écrivent doivent être arrêtés avant. Les messages suivants
+ * sont de nouveau écrits directement.
+ */
+void logShutdown()
+{
+	if( !atomic_load( &Running ) )
+		return;
+
+	atomic_store( &Running, 0 );
+	atomic_store( &Stop, 1 );
+	pthread_join( Writer, NULL );
+	drain();
+}
+
+/**
+ * `logFlush` écrit aussitôt les messages en attente de tous les threads.
+ */
+void logFlush()
+{
+	drain();
+}
+
+/**
+ * `logWrite` met en forme un message et l'ajoute au tampon du thread
+ * courant. Au-delà de @ref LOG_BURST messages par seconde depuis un même
+ * appel, les messages sont seulement comptés, et leur nombre est ajouté au
+ * message suivant écrit depuis cet appel. Si le tampon est plein, le
+ * message est perdu et compté. Un message de niveau @ref LOG_ERROR vide
+ * aussitôt les tampons, pour qu'un `assert` qui le suit ne le perde pas.
+ * @param site L'appel d'où vient le message
+ * @param level Le niveau du message
+ * @param format Le format du message, comme pour `printf`
+ */
+void logWrite( LogSite* site, int level, const char* format, ... )
+{
+	LogRecord local, * record = &local;
+	LogRing* ring = NULL;
+	unsigned head = 0, suppressed = 0;
+	va_list args;
+
+	if( level < atomic_load_explicit( &Level, memory_order_relaxed ) )
+		return;
+
+	/* limitation des messages répétés */
+	long now = ( long )time( NULL );
+	long window = atomic_load_explicit( &site->window, memory_order_relaxed );
+	if( window != now && atomic_compare_exchange_strong( &site->window, &window, now ) )
+	{
+		atomic_store( &site->count, 0 );
+		suppressed = atomic_exchange( &site->suppressed, 0 );
+	}
+	if( atomic_fetch_add( &site->count, 1 ) >= LOG_BURST )
+	{
+		atomic_fetch_add( &site->suppressed, 1 );
+		return;
+	}
+
+	/* le message est mis en forme directement dans le tampon */
+	if( atomic_load_explicit( &Running, memory_order_acquire ) )
+		ring = acquireRing();
+	if( ring )
+	{
+		head = atomic_load_explicit( &ring->head, memory_order_relaxed );
+		if( head - atomic_load_explicit( &ring->tail, memory_order_acquire ) >= LOG_RING_SIZE )
+		{
+			atomic_fetch_add( &ring->dropped, 1 );
+			return;
+		}
+		record = &ring->records[ head % LOG_RING_SIZE ];
+	}
+
+	record->file = site->file;
+	record->line = site->line;
+	record->level = level;
+	record->suppressed = suppressed;
+	va_start( args, format );
+	int n = vsnprintf( record->text, LOG_TEXT_SIZE, format, args );
+	va_end( args );
+	if( n > LOG_TEXT_SIZE - 1 )
+		n = LOG_TEXT_SIZE - 1;
+	while( n > 0 && record->text[ n - 1 ] == '\n' )
+		record->text[ --n ] = '\0';
+
+	if( !ring )
+	{
+		writeRecord( Out ? Out : stderr, record );
+		return;
+	}
+
+	atomic_store_explicit( &ring->head, head + 1, memory_order_release );
+	if( level >= LOG_ERROR )
+		drain();
+}
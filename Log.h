@@ -0,0 +1,84 @@
+/**
+ * @file Log.h
+ * @brief Journal du jeu par niveaux. Chaque thread écrit ses messages dans
+ * son propre tampon circulaire, sans verrou ; un thread d'écriture les vide
+ * périodiquement dans un fichier.
+ */
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+/**
+ * Niveaux des messages, du plus bavard au plus grave
+ */
+enum {
+	LOG_DEBUG, ///< Détails utiles au développement
+	LOG_INFO, ///< Événements normaux de la partie
+	LOG_WARN, ///< Situation anormale mais sans conséquence
+	LOG_ERROR ///< Erreur, les tampons sont vidés aussitôt
+};
+
+/**
+ * Niveau en dessous duquel les appels à @ref logDebug, @ref logInfo, etc.
+ * ne sont pas compilés. Se règle avec `-DLOG_LEVEL=...`.
+ */
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_INFO
+#endif
+
+/// Nombre de messages d'un même appel écrits par seconde, les suivants sont comptés puis résumés
+#define LOG_BURST 8
+
+/**
+ * @struct LogSite
+ * @brief Appel au journal, propre à chaque ligne de code qui écrit : sert à
+ * limiter les messages répétés
+ */
+typedef struct
+{
+	const char* file; ///< Fichier source
+	int line; ///< Ligne de l'appel
+	atomic_long window; ///< Seconde en cours
+	atomic_uint count; ///< Messages écrits pendant la seconde en cours
+	atomic_uint suppressed; ///< Messages ignorés depuis le dernier écrit
+} LogSite;
+
+/// @brief Démarre le thread d'écriture vers `out`, en ignorant les messages sous `level`
+int logInit( FILE* out, int level );
+/// @brief Vide les tampons puis arrête le thread d'écriture
+void logShutdown();
+/// @brief Écrit aussitôt les messages en attente
+void logFlush();
+/// @brief Ajoute un message au journal (utiliser plutôt @ref logInfo, etc.)
+void logWrite( LogSite* site, int level, const char* format, ... ) __attribute__( ( format( printf, 3, 4 ) ) );
+
+/// @brief Ajoute un message de niveau `level` depuis l'appel courant
+#define LOG_AT( level, ... ) \
+	do { \
+		static LogSite log_site_ = { __FILE__, __LINE__, 0, 0, 0 }; \
+		logWrite( &log_site_, level, __VA_ARGS__ ); \
+	} while( 0 )
+
+#if LOG_LEVEL <= LOG_DEBUG
+#define logDebug( ... ) LOG_AT( LOG_DEBUG, __VA_ARGS__ )
+#else
+#define logDebug( ... ) ( ( void )0 )
+#endif
+
+#if LOG_LEVEL <= LOG_INFO
+#define logInfo( ... ) LOG_AT( LOG_INFO, __VA_ARGS__ )
+#else
+#define logInfo( ... ) ( ( void )0 )
+#endif
+
+#if LOG_LEVEL <= LOG_WARN
+#define logWarn( ... ) LOG_AT( LOG_WARN, __VA_ARGS__ )
+#else
+#define logWarn( ... ) ( ( void )0 )
+#endif
+
+#define logError( ... ) LOG_AT( LOG_ERROR, __VA_ARGS__ )
+
+#endif
@@ -0,0 +1,247 @@
+/**
+ * @file Lz.c
+ * Compression au format de bloc LZ4. Un bloc est une suite de séquences :
+ * un jeton (4 bits de longueur de littéraux, 4 bits de longueur de copie
+ * moins 4), les octets de longueur suivants quand une longueur atteint 15,
+ * les littéraux, puis le décalage de la copie sur 2 octets, poids faible en
+ * tête. La dernière séquence n'a que des littéraux ; comme en LZ4, les 5
+ * derniers octets sont toujours des littéraux et aucune copie ne commence
+ * dans les 12 derniers.
+ *
+ * Le compresseur est glouton : une table de hachage sur 4 octets donne la
+ * dernière position où ils ont été vus, et la copie est prolongée tant que
+ * les octets sont égaux. Il avance de plus en plus vite dans les données
+ * qui ne se répètent pas.
+ */
+#include "Lz.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/// Nombre de bits de la table de hachage du compresseur
+#define LZ_HASH_BITS 16
+/// Longueur minimale d'une copie
+#define LZ_MIN_MATCH 4
+/// Décalage maximal d'une copie
+#define LZ_MAX_OFFSET 65535
+/// Aucune copie ne commence dans les `LZ_MF_LIMIT` derniers octets
+#define LZ_MF_LIMIT 12
+/// Les `LZ_LAST_LITERALS` derniers octets sont des littéraux
+#define LZ_LAST_LITERALS 5
+/// Taille des blocs copiés d'un coup par le décompresseur
+#define LZ_WILD_COPY 16
+
+/// Lit 4 octets quelconques, sans contrainte d'alignement
+static uint32_t read32( const uint8_t* p )
+{
+	uint32_t v;
+	memcpy( &v, p, sizeof( v ) );
+	return v;
+}
+
+/// Empreinte de 4 octets dans la table du compresseur
+static uint32_t hash32( uint32_t v )
+{
+	return ( v * 2654435761u ) >> ( 32 - LZ_HASH_BITS );
+}
+
+/// Écrit le reste d'une longueur qui atteint 15 dans le jeton
+static uint8_t* writeLength( uint8_t* op, size_t length )
+{
+	while( length >= 255 )
+	{
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = ( uint8_t )length;
+	return op;
+}
+
+/**
+ * `writeSequence` écrit une séquence : `nb_literals` littéraux puis, si
+ * `match_length` est non nul, une copie de `match_length` octets situés
+ * `offset` octets plus tôt.
+ */
+static uint8_t* writeSequence( uint8_t* op, const uint8_t* literals, size_t nb_literals, size_t offset, size_t match_length )
+{
+	uint8_t* token = op++;
+	size_t match_code = match_length ? match_length - LZ_MIN_MATCH : 0;
+
+	*token = ( uint8_t )( ( nb_literals < 15 ? nb_literals : 15 ) << 4 );
+	if( nb_literals >= 15 )
+		op = writeLength( op, nb_literals - 15 );
+	memcpy( op, literals, nb_literals );
+	op += nb_literals;
+
+	if( !match_length )
+		return op;
+
+	*op++ = ( uint8_t )offset;
+	*op++ = ( uint8_t )( offset >> 8 );
+	*token |= match_code < 15 ? match_code : 15;
+	if( match_code >= 15 )
+		op = writeLength( op, match_code - 15 );
+	return op;
+}
+
+/**
+ * `lzBound` renvoie la taille maximale du bloc compressé de `size` octets,
+ * celle à allouer pour `lzCompress`.
+ * @param size La taille des données à compresser
+ * @return La taille maximale du bloc
+ */
+size_t lzBound( size_t size )
+{
+	return size + size / 255 + 16;
+}
+
+/**
+ * `lzCompress` compresse `size` octets en un bloc.
+ * @param src Les données à compresser
+ * @param size La taille des données
+ * @param dst Le bloc compressé, d'au moins @ref lzBound `( size )` octets
+ * @return La taille du bloc, 0 si la table de hachage n'a pas pu être allouée
+ */
+size_t lzCompress( const uint8_t* src, size_t size, uint8_t* dst )
+{
+	uint8_t* op = dst;
+	size_t anchor = 0, i = 0;
+
+	if( size > LZ_MF_LIMIT )
+	{
+		/* position + 1 des derniers 4 octets de chaque empreinte, 0 si aucune */
+		uint32_t* table = calloc( 1u << LZ_HASH_BITS, sizeof( uint32_t ) );
+		if( !table )
+			return 0;
+
+		size_t limit = size - LZ_MF_LIMIT;
+		while( i < limit )
+		{
+			uint32_t sequence = read32( src + i );
+			uint32_t h = hash32( sequence );
+			size_t ref = table[ h ];
+			table[ h ] = ( uint32_t )( i + 1 );
+
+			if( ref && i - ( ref - 1 ) <= LZ_MAX_OFFSET && read32( src + ref - 1 ) == sequence )
+			{
+				ref--;
+				size_t length = LZ_MIN_MATCH;
+				while( i + length < size - LZ_LAST_LITERALS && src[ ref + length ] == src[ i + length ] )
+					length++;
+
+				op = writeSequence( op, src + anchor, i - anchor, i - ref, length );
+				i += length;
+				anchor = i;
+			}
+			else
+				i += 1 + ( ( i - anchor ) >> 6 );
+		}
+
+		free( table );
+	}
+
+	op = writeSequence( op, src + anchor, size - anchor, 0, 0 );
+	return op - dst;
+}
+
+/**
+ * `lzDecompress` décompresse un bloc. Le bloc est vérifié à mesure : un
+ * bloc tronqué ou corrompu ne fait jamais lire ni écrire hors des tampons.
+ * @param src Le bloc compressé
+ * @param size La taille du bloc
+ * @param dst Les données décompressées
+ * @param dst_size La taille exacte des données décompressées
+ * @return 0 en cas de succès, -1 si le bloc est invalide
+ */
+int lzDecompress( const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size )
+{
+	const uint8_t* ip = src;
+	const uint8_t* iend = src + size;
+	uint8_t* op = dst;
+	uint8_t* oend = dst + dst_size;
+
+	while( ip < iend )
+	{
+		unsigned token = *ip++;
+		size_t length = token >> 4;
+
+		if( length == 15 )
+		{
+			unsigned byte;
+			do
+			{
+				if( ip == iend )
+					return -1;
+				byte = *ip++;
+				length += byte;
+			} while( byte == 255 );
+		}
+
+		if( length > ( size_t )( iend - ip ) || length > ( size_t )( oend - op ) )
+			return -1;
+		/* les littéraux courts sont copiés d'un bloc de 16 octets quand les
+		   deux tampons ont la place : la copie déborde sans conséquence */
+		if( length <= LZ_WILD_COPY && iend - ip >= LZ_WILD_COPY && oend - op >= LZ_WILD_COPY )
+			memcpy( op, ip, LZ_WILD_COPY );
+		else
+			memcpy( op, ip, length );
+		ip += length;
+		op += length;
+
+		/* dernière séquence : des littéraux seulement */
+		if( ip == iend )
+			break;
+
+		if( iend - ip < 2 )
+			return -1;
+		size_t offset = ip[ 0 ] | ( size_t )ip[ 1 ] << 8;
+		ip += 2;
+		if( offset == 0 || offset > ( size_t )( op - dst ) )
+			return -1;
+
+		length = token & 15;
+		if( length == 15 )
+		{
+			unsigned byte;
+			do
+			{
+				if( ip == iend )
+					return -1;
+				byte = *ip++;
+				length += byte;
+			} while( byte == 255 );
+		}
+		length += LZ_MIN_MATCH;
+		if( length > ( size_t )( oend - op ) )
+			return -1;
+
+		const uint8_t* match = op - offset;
+		if( offset >= LZ_WILD_COPY && ( size_t )( oend - op ) >= length + LZ_WILD_COPY )
+		{
+			/* par blocs de 16 octets, en débordant de moins d'un bloc */
+			uint8_t* end = op + length;
+			do
+			{
+				memcpy( op, match, LZ_WILD_COPY );
+				op += LZ_WILD_COPY;
+				match += LZ_WILD_COPY;
+			} while( op < end );
+			op = end;
+			continue;
+		}
+
+		/* une copie qui recouvre sa source répète un motif de `offset`
+		   octets : on le recopie par morceaux de plus en plus grands */
+		while( length )
+		{
+			size_t chunk = ( size_t )( op - match );
+			if( chunk > length )
+				chunk = length;
+			memcpy( op, match, chunk );
+			op += chunk;
+			length -= chunk;
+		}
+	}
+
+	return op == oend ? 0 : -1;
+}
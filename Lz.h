@@ -0,0 +1,20 @@
+/**
+ * @file Lz.h
+ * @brief Compression rapide sans perte au format de bloc LZ4 : une
+ * décompression coûte à peine plus qu'une copie, ce qui en fait le format
+ * des données lues au démarrage.
+ */
+#ifndef __LZ_H__
+#define __LZ_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Renvoie la taille maximale d'un bloc compressé de `size` octets
+size_t lzBound( size_t size );
+/// @brief Compresse un bloc et renvoie sa taille compressée
+size_t lzCompress( const uint8_t* src, size_t size, uint8_t* dst );
+/// @brief Décompresse un bloc dont la taille décompressée est connue
+int lzDecompress( const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size );
+
+#endif
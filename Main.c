@@ -2,25 +2,40 @@
 /**
  * @file Main.c
  * Point d'entrée du programme. Alloue et détruit les ressources, et gère les
- * évènements utilisateur.
+ * évènements utilisateur. Le client graphique ne garde aucun état de jeu :
+ * il affiche une partie du cœur du jeu (@ref Gameplay_s) et lui transmet
+ * les clics du joueur.
  */
 
+#include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
 
 #include <SDL2/SDL.h>
 
+#include "Boot.h"
 #include "Graphics.h"
 #include "Gameplay.h"
 #include "Inventory.h"
+#include "Log.h"
+#include "Metrics.h"
 #include "Npc.h"
+#include "Replay.h"
+#include "Snapshot.h"
+#include "Ui.h"
 
 /// Largeur de la fenêtre 
 #define WINDOW_WIDTH 800
 /// Hauteur de la fenêtre
 #define WINDOW_HEIGHT 600
+/// Fichier de la sauvegarde rapide (F5 pour sauvegarder, F9 pour recharger)
+#define SAVE_PATH "save.bin"
+/// Période des relevés de mesures écrits avec `--metrics`, en millisecondes
+#define METRICS_PERIOD_MS 5000
 
 /// @brief Ouvre la SDL et construit la fenêtre.
 SDL_Window* initSDL();
@@ -28,108 +43,205 @@ SDL_Window* initSDL();
 void closeSDL( SDL_Window* window );
 /// @brief affiche le nombre d'images par seconde (fps).
 void renderFramerate();
-
-/// file des dialogues entre le joueur et les personnages du jeu.
-char* DialogsQueue[ 3 ];
+/// @brief Renvoie le temps écoulé depuis `start`, en microsecondes
+long elapsedUs( Uint64 start );
 
 /**
  * @brief Initialisation du jeu, interaction avec l'utilisateur et libération
  * des ressources avant la fin d'exécution du programme.\n
- * - Initialise les différents modules par appel aux fonctions @ref initSDL,
- * @ref initGraphics, @ref initGameplay et @ref initItems. Alloue 3 buffers de
- * 1024 caractères dont les pointeurs respectifs sont stockés dans @ref
- * DialogsQueue.\n
+ * - Initialise les différents modules par étapes : @ref initSDL, puis
+ * @ref bootStart lance le chargement en parallèle de tout le reste (police,
+ * catalogue des objets, partie, images) ; l'écran de début est affiché dès
+ * qu'il est prêt (@ref bootStartScreen), pendant que le reste se charge.
+ * Les clics sont ignorés jusqu'à la fin du chargement ; fermer la fenêtre
+ * l'abandonne (@ref bootCancel) et quitte. Le délai de la
+ * première image et la durée du démarrage sont écrits dans le journal et
+ * relevés dans les mesures.\n
  * - Une boucle d'interaction capture les événements utilisateurs (clavier et
- * souris) et modifie en conséquence les variables globales définissant l'état
- * courant du jeu (dont, en particulier, la structure @ref Gameplay).\n
- * - A la fin du jeu, détruit les ressources du programme, par libération des
- * pointeurs du tableau @ref DialogsQueue, et par appel aux fonctions @ref
- * closeItems, @ref destroyGraphics et @ref closeSDL.\n
+ * souris) et modifie en conséquence la partie en cours.\n
+ * - A la fin du jeu, détruit les ressources du programme par appel aux
+ * fonctions @ref destroyGameplay, @ref closeItems, @ref destroyGraphics et
+ * @ref closeSDL.\n
+ * - `4A --record fichier` enregistre les entrées du joueur dans un journal,
+ * `4A --replay fichier` rejoue un journal à la vitesse enregistrée, ou
+ * d'un coup avec `--fast`. Le joueur reprend la main à la fin du journal.\n
+ * - F3 affiche ou masque le relevé des mesures du jeu ; `4A --metrics
+ * fichier` y ajoute un relevé toutes les @ref METRICS_PERIOD_MS ms.\n
+ * - `4A --texture-budget Mo` change le budget des textures en vie (voir
+ * @ref trimTextures), @ref TEXTURE_BUDGET par défaut, gardé si la valeur
+ * n'est pas un nombre de Mo strictement positif ; le relevé des
+ * mesures détaille leur mémoire par sorte.\n
  * @return le code de l'erreur en cas d'échec, sinon 0.
  */
-int main()
+int main( int argc, char* argv[] )
 {
 	/* INIT ---------------------------------------- */
 
-	srand( time( NULL ) );
+	const char* record_path = NULL;
+	const char* replay_path = NULL;
+	const char* metrics_path = NULL;
+	int fast = 0;
+	int i;
 
+	logInit( stderr, LOG_INFO );
+	for( i = 1; i < argc; i++ )
+	{
+		if( strcmp( argv[ i ], "--fast" ) == 0 )
+			fast = 1;
+		else if( i + 1 < argc && strcmp( argv[ i ], "--record" ) == 0 )
+			record_path = argv[ ++i ];
+		else if( i + 1 < argc && strcmp( argv[ i ], "--replay" ) == 0 )
+			replay_path = argv[ ++i ];
+		else if( i + 1 < argc && strcmp( argv[ i ], "--metrics" ) == 0 )
+			metrics_path = argv[ ++i ];
+		else if( i + 1 < argc && strcmp( argv[ i ], "--texture-budget" ) == 0 )
+		{
+			char* end;
+			errno = 0;
+			long mb = strtol( argv[ ++i ], &end, 10 );
+			if( errno || end == argv[ i ] || *end || mb <= 0 || mb > LONG_MAX >> 20 )
+				logError( "--texture-budget %s : expected megabytes in 1..%ld, keeping the default", argv[ i ], LONG_MAX >> 20 );
+			else
+				Graphics.texture_budget = mb * ( 1l << 20 );
+		}
+	}
+
+	Uint64 boot_start = SDL_GetPerformanceCounter();
 	SDL_Window* window = initSDL();
-	initGraphics();
-	initGameplay();
-	initItems();
-	
-	int run = 1;	
+
+	/* première image : l'écran de début seul, dès que la police et son
+	   image sont chargées */
+	Boot boot;
+	bootStart( &boot, time( NULL ) );
+	bootStartScreen( &boot );
+	renderStartScreen();
+	presentFrame();
+	metricSet( METRIC_FIRST_FRAME, elapsedUs( boot_start ) );
+
+	/* le reste est chargé en arrière-plan, l'écran de début reste affiché */
+	int run = 1;
 	SDL_Event event;
+	Gameplay_s* game;
 
-	int i;
-	for( i = 0; i < 3; i++ )
+	while( !( game = bootPoll( &boot ) ) )
+	{
+		/* les clics sont ignorés jusqu'à la fin du chargement */
+		while( SDL_PollEvent( &event ) )
+		{
+			if( event.type == SDL_QUIT )
+				run = 0;
+		}
+		if( !run )
+			break;
+
+		SDL_RenderClear( Graphics.renderer );
+		renderStartScreen();
+		presentFrame();
+		SDL_Delay( 10 );
+	}
+
+	/* quitté pendant le chargement : rien d'autre n'a été ouvert */
+	if( !game )
 	{
-		DialogsQueue[ i ] = malloc( sizeof( char ) * 1024 );   /* pas de gestion des erreurs éventuelles */
-		memset( DialogsQueue[ i ], 0, 1024 );
+		bootCancel( &boot );
+		destroyGraphics();
+		closeItems();
+		closeSDL( window );
+		logShutdown();
+		return 0;
 	}
 
-	/* BOUCLE D'INTERACTION ---------------------------------------- */
-	while( run )
+	metricSet( METRIC_BOOT_TIME, elapsedUs( boot_start ) );
+	logInfo( "first frame after %ld ms, ready after %ld ms", metricValue( METRIC_FIRST_FRAME ) / 1000,
+		metricValue( METRIC_BOOT_TIME ) / 1000 );
+
+	Recorder recorder = { NULL, 0, 0 };
+	if( record_path && recorderOpen( &recorder, record_path, SDL_GetTicks() ) != 0 )
+		logError( "%s : cannot record", record_path );
+	recorderSeed( &recorder, game, SDL_GetTicks() );
+
+	Replay replay;
+	int replaying = 0;
+	memset( &replay, 0, sizeof( replay ) );
+	if( replay_path )
 	{
+		replaying = replayLoad( &replay, replay_path ) == 0;
+		if( !replaying )
+			logError( "%s : invalid replay", replay_path );
+	}
+	
+	FILE* metrics_file = NULL;
+	if( metrics_path && !( metrics_file = fopen( metrics_path, "a" ) ) )
+		logError( "%s : cannot write metrics", metrics_path );
 
+	int show_metrics = 0;
+	Input input;
+	Uint32 replay_start = SDL_GetTicks();
+	Uint32 last_metrics = SDL_GetTicks();
 
+	/* BOUCLE D'INTERACTION ---------------------------------------- */
+	while( run )
+	{
+		Uint64 frame_start = SDL_GetPerformanceCounter();
 
+		/* relecture d'un journal : les événements dont l'instant est passé */
+		if( replaying )
+		{
+			Uint32 elapsed = SDL_GetTicks() - replay_start;
+			while( replayPending( &replay ) && ( fast || replay.next.time <= elapsed ) )
+			{
+				if( replayStep( &replay, game ) < 0 )
+				{
+					logWarn( "%s : replay diverged", replay_path );
+					replayFree( &replay );
+				}
+			}
 
+			if( !replayPending( &replay ) )
+				replaying = 0;
+		}
 
 		while( SDL_PollEvent( &event ) )
 		{
 			/* sortie de boucle en fin de tour */
 			if( event.type == SDL_QUIT )
 				run = 0;
+			/* relevé des mesures, aussi pendant la relecture */
+			else if( event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3 )
+				show_metrics = !show_metrics;
+			/* textures de rendu perdues : le panneau des dialogues est à redessiner */
+			else if( event.type == SDL_RENDER_TARGETS_RESET )
+				Graphics.dialog_generation = -1;
+			/* sauvegarde et chargement rapides */
+			else if( event.type == SDL_KEYDOWN && !replaying )
+			{
+				if( event.key.keysym.sym == SDLK_F5 && saveGameplay( game, SAVE_PATH ) != 0 )
+					logError( "%s : cannot save", SAVE_PATH );
+				/* un chargement ne peut pas être rejoué : interdit pendant un enregistrement */
+				else if( event.key.keysym.sym == SDLK_F9 && !recorder.file && loadGameplay( game, SAVE_PATH ) != 0 )
+					logError( "%s : cannot load", SAVE_PATH );
+			}
+			/* survol : décodage d'avance de ce qu'un clic afficherait */
+			else if( event.type == SDL_MOUSEMOTION )
+				uiHover( game, event.motion.x, event.motion.y );
 			/* souris */
 			else if( event.type == SDL_MOUSEBUTTONDOWN ) 
 			{
-				/* clique gauche */
-				if( event.button.button == SDL_BUTTON_LEFT )   
+				/* clique gauche, ignoré pendant la relecture d'un journal */
+				if( event.button.button == SDL_BUTTON_LEFT && !replaying )
 				{
-					/* début */
-					if( Gameplay.state == STATE_START )          
-					{
-						Gameplay.state = STATE_EXPLORATION;  /* passage en mode exploration; */
-					}
-					/* accès à l'inventaire */
-					else if( Gameplay.state == STATE_INVENTORY )
-					{
-						SDL_Rect rects[ 10 ];
-						getItemRects( rects );
-
-						if( !itemTriggered( event.button.x, event.button.y, rects ) )
-						{
-							SDL_Rect buttonRects[ 4 ];
-							getButtonRects( buttonRects );
-
-							buttonTriggered( event.button.x, event.button.y, buttonRects );
-						}
-					}
-					/* mode exploration */
-					else if( Gameplay.state == STATE_EXPLORATION )
-					{
-						if( !elementTriggered( event.button.x, event.button.y ) )
-						{
-							SDL_Rect rects[ 4 ];
-							getButtonRects( rects );
-
-							buttonTriggered( event.button.x, event.button.y, rects );
-						}
-					}
-					/* mode interaction ou conversation */
-					else if( Gameplay.state == STATE_INTERACTION || Gameplay.state == STATE_TALK )
+					/* fin de partie */
+					if( game->state == STATE_WON || game->state == STATE_LOST )
 					{
-						SDL_Rect rects[ 4 ];
-						getButtonRects( rects );
-
-						buttonTriggered( event.button.x, event.button.y, rects );
+						seedGameplay( game, time( NULL ), 0 );
+						initGameplay( game );
+						recorderSeed( &recorder, game, SDL_GetTicks() );
 					}
-					/* fin de partie */
-					else if( Gameplay.state == STATE_WON || Gameplay.state == STATE_LOST )
+					/* début, exploration, inventaire, interaction ou conversation */
+					else if( uiInput( game, event.button.x, event.button.y, &input ) )
 					{
-						Gameplay.state = STATE_START;
-						initGameplay();
+						recorderInput( &recorder, game, input, SDL_GetTicks() );
+						applyInput( game, input );
 					}
 				}
 			}
@@ -140,19 +252,20 @@ int main()
 
 
 		SDL_RenderClear( Graphics.renderer );
+		syncZoneTextures( game );
 
-		if( Gameplay.state == STATE_START )
+		if( game->state == STATE_START )
 		{
 			renderStartScreen();
 		}
-		else if( Gameplay.state == STATE_INVENTORY )
+		else if( game->state == STATE_INVENTORY )
 		{
 			renderInventoryBg();
-			renderMenu( RENDER_INVENTORY, DialogsQueue );
+			renderMenu( RENDER_INVENTORY, game );
 
 			for( i = 0; i < MAX_ITEM; i++ )
 			{
-				SDL_Texture* tex = getItemTexture( i, 1 );
+				SDL_Texture* tex = getItemTexture( game, i, 1 );
 				if( tex )
 				{
 					renderItem( tex, i );
@@ -161,103 +274,102 @@ int main()
 
 			for( i = 0; i < MAX_STUFF; i++ )
 			{
-				SDL_Texture* tex = getItemTexture( i, 0 );
+				SDL_Texture* tex = getItemTexture( game, i, 0 );
 				if( tex )
 				{
 					renderStuff( tex, i );
 				}
 			}
 
-			renderGold( Gameplay.gold );
+			renderGold( game->inventory.gold );
 
 			char item_desc[ 300 ];
-			getCurrentItemDesc( item_desc );
+			getCurrentItemDesc( game, item_desc );
 			renderItemDesc( item_desc );
 
-			renderItemHighlighting( Gameplay.index_selected_item );
+			renderItemHighlighting( game->index_selected_item );
 		}
-		else if( Gameplay.state == STATE_EXPLORATION || Gameplay.state == STATE_INTERACTION || Gameplay.state == STATE_TALK )
+		else if( game->state == STATE_EXPLORATION || game->state == STATE_INTERACTION || game->state == STATE_TALK )
 		{
 			int render_state;
 
-			if( Gameplay.state == STATE_EXPLORATION )
+			if( game->state == STATE_EXPLORATION )
 			{
-				renderImage( Gameplay.bg_tex[ 0 ], Gameplay.bg_rect[ 0 ] );
+				SDL_Texture* background = lazyTexture( Graphics.zone_bg );
+				renderImage( background, Graphics.zone_bg->rect );
 
-				for( i = 0; i < Gameplay.nb_elements; i++ )
-				{
-					int render = 1;
-
-					if( Gameplay.elements[ i ].type == 0 )
-					{
-						int j;
-						for( j = 0; j < Gameplay.nb_npc; j++ )
-						{
-							if( Gameplay.npcs[ j ].type == Gameplay.elements[ i ].value && Gameplay.npcs[ j ].unique_id == Gameplay.elements[ i ].value2 )
-							{
-								if( encounterEnd( Gameplay.npcs[ j ] ) )
-								{
-									render = 0;
-									break;
-								}
-							}
-						}
-					}
+				Rect view = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
+				int nb_visible = cullElements( game, view );
 
-					if( render )
-						renderImage( Gameplay.elements[ i ].tex, Gameplay.elements[ i ].rect );
-				}
+				for( i = 0; i < nb_visible; i++ )
+					renderElement( game, game->elements.visible[ i ] );
 
 				render_state = RENDER_EXPLORATION;
 			}
-			else if( Gameplay.state == STATE_INTERACTION )
+			else if( game->state == STATE_INTERACTION )
 			{
-				renderImage( Gameplay.bg_tex[ 1 ], Gameplay.bg_rect[ 1 ] );
-
-				int index = Gameplay.interaction_index;
-				renderImage( Gameplay.elements[ index ].tex, Gameplay.elements[ index ].rect );
+				SDL_Texture* background = lazyTexture( Graphics.interaction_bg );
+				renderImage( background, Graphics.interaction_bg->rect );
+				renderElement( game, game->interaction_index );
 
 				render_state = RENDER_INTERACTION;
 			}
-			else if( Gameplay.state == STATE_TALK )
+			else if( game->state == STATE_TALK )
 			{
-				renderImage( Gameplay.bg_tex[ 1 ], Gameplay.bg_rect[ 1 ] );
-
-				int index = Gameplay.interaction_index;
-				renderImage( Gameplay.elements[ index ].tex, Gameplay.elements[ index ].rect );
+				SDL_Texture* background = lazyTexture( Graphics.interaction_bg );
+				renderImage( background, Graphics.interaction_bg->rect );
+				renderElement( game, game->interaction_index );
 
 				render_state = RENDER_TALK;
 			}
 
-			renderHp( Gameplay.player_current_life, Gameplay.player_max_life );
-			renderMenu( render_state, DialogsQueue );
+			renderHp( game->player_current_life, game->player_max_life );
+			renderMenu( render_state, game );
 		}
 		else
 		{
-			if( Gameplay.state == STATE_WON )
+			if( game->state == STATE_WON )
 				renderEnd( 1 );
 			else
 				renderEnd( 0 );
 		}
 
 		renderFramerate();
-		SDL_RenderPresent( Graphics.renderer );
+		if( show_metrics )
+			renderMetrics();
+		presentFrame();
+
+		metricsFrame( elapsedUs( frame_start ) );
+		if( metrics_file && SDL_GetTicks() - last_metrics >= METRICS_PERIOD_MS )
+		{
+			metricsWrite( metrics_file, SDL_GetTicks() / 1000.0 );
+			last_metrics = SDL_GetTicks();
+		}
 	}
 
 	/* LIBERATION DE LA MEMOIRE ---------------------------------------- */
 	
-	for( i = 0; i < 3; i++ )
-		free( DialogsQueue[ i ] );
-	
+	recorderClose( &recorder );
+	replayFree( &replay );
+
+	destroyGameplay( game );
+	destroyGraphics();
+
+	/* dernier relevé : les jauges doivent être revenues à zéro */
+	if( metrics_file )
+	{
+		metricsWrite( metrics_file, SDL_GetTicks() / 1000.0 );
+		fclose( metrics_file );
+	}
+
 	closeItems();
-	destroyGraphics( Graphics );
 	closeSDL( window );
+	logShutdown();
 	return 0;
 }
 
 /** 
- * Initialise la SDL, crée une fenêtre et affiche un avertissement sur l'entrée
- * standard en cas d'erreur. Puis, crée un premier rendu dans cette fenêtre.
+ * Initialise la SDL, crée une fenêtre et journalise l'erreur en cas d'échec. Puis, crée un premier rendu dans cette fenêtre.
  * @return la fenêtre SDL créée, ou `NULL` en cas d'erreur.
  **/
 SDL_Window* initSDL()
@@ -268,11 +380,11 @@ SDL_Window* initSDL()
 	SDL_Window* window = SDL_CreateWindow( "4A", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, 0 );
 	if( !window )
 	{
-		printf( "SDL_CreateWindow failed" );
+		logError( "SDL_CreateWindow failed : %s", SDL_GetError() );
 		return NULL;
 	}
 
-	Graphics.renderer = SDL_CreateRenderer( window, -1, SDL_RENDERER_ACCELERATED ); // SDL_RENDERER_PRESENTVSYNC
+	Graphics.renderer = SDL_CreateRenderer( window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE ); // SDL_RENDERER_PRESENTVSYNC
 
 	return window;
 }
@@ -293,13 +405,14 @@ void closeSDL( SDL_Window* window )
 
 /** 
  * Calcul le nombre d'images par seconde et réalise un rendu textuel qui met en
- * évidence ce nombre.
+ * évidence ce nombre. Le libellé vient du cache des textes et le nombre de
+ * l'atlas des compteurs : aucune image n'est rastérisée.
  **/
 void renderFramerate()
 {
 	static int fps = 0;
 	static int last_sec = 0;
-	static char text[ 20 ] = "";
+	static int shown = -1;
 
 	int time = SDL_GetTicks();
 
@@ -308,14 +421,28 @@ void renderFramerate()
 
 	if( delta >= 1000 )
 	{
-		sprintf( text, "fps : %d", fps );	
+		shown = fps;
 		fps = 0;
 		last_sec = SDL_GetTicks() - ( delta - 1000 );
 	}
 
-	if( text[ 0 ] != '\0' )
+	if( shown >= 0 )
 	{
 		SDL_Color color = { 0, 0, 0, 0 };
-		renderText( text, WINDOW_WIDTH - 100, 0, color );
+		int x = WINDOW_WIDTH - 100;
+
+		x += renderText( "fps", x, 0, color );
+		x += renderGlyphs( " : ", x, 0, color );
+		renderNumber( shown, x, 0, color );
 	}
 }
+
+/**
+ * Renvoie le temps écoulé depuis un instant du compteur de performance.
+ * @param start L'instant, lu avec `SDL_GetPerformanceCounter`.
+ * @return Le temps écoulé, en microsecondes.
+ **/
+long elapsedUs( Uint64 start )
+{
+	return ( SDL_GetPerformanceCounter() - start ) * 1000000 / SDL_GetPerformanceFrequency();
+}
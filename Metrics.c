@@ -0,0 +1,247 @@
+/**
+ * @file Metrics.c
+ * Registre des mesures. Les mesures sont fixées à la compilation (voir
+ * @ref METRIC_NB) et rangées dans un tableau statique : les mettre à jour ne
+ * fait ni recherche ni allocation, seulement des opérations atomiques
+ * relâchées, et elles peuvent l'être depuis les parties jouées en parallèle.
+ * Chaque mesure occupe sa propre ligne de cache.
+ */
+#include "Metrics.h"
+
+#include <stdatomic.h>
+
+/**
+ * @struct Metric
+ * @brief État d'une mesure
+ */
+typedef struct
+{
+	_Alignas( 64 ) atomic_long value; ///< Valeur, ou nombre d'observations d'un histogramme
+	atomic_long sum; ///< Somme des valeurs observées
+	atomic_long max; ///< Plus grande valeur observée
+	atomic_long buckets[ METRIC_BUCKETS ]; ///< Nombre d'observations par classe
+} Metric;
+
+/// Mesures du registre
+static Metric Metrics[ METRIC_NB ];
+
+/// Noms des mesures, tels qu'écrits par @ref metricsFormat
+static const char* const Names[ METRIC_NB ] = {
+	[ METRIC_FILE_OPENS ] = "file_opens",
+	[ METRIC_HEAP_ALLOCS ] = "heap_allocs",
+	[ METRIC_TEXTURES_CREATED ] = "textures_created",
+	[ METRIC_TEXT_RENDERS ] = "text_renders",
+	[ METRIC_TEXT_CACHE_HITS ] = "text_cache_hits",
+	[ METRIC_DIALOG_REBUILDS ] = "dialog_rebuilds",
+	[ METRIC_IMAGE_CACHE_HITS ] = "image_cache_hits",
+	[ METRIC_IMAGE_CACHE_STORES ] = "image_cache_stores",
+	[ METRIC_ZONE_LOADS ] = "zone_loads",
+	[ METRIC_LAZY_LOADS ] = "lazy_loads",
+	[ METRIC_WARMUPS ] = "warmups",
+	[ METRIC_EVICTIONS ] = "evictions",
+	[ METRIC_ENCOUNTERS ] = "encounters",
+	[ METRIC_LIVE_TEXTURES ] = "live_textures",
+	[ METRIC_LIVE_GAMES ] = "live_games",
+	[ METRIC_ARENA_BLOCKS ] = "arena_blocks",
+	[ METRIC_TEXTURE_BYTES ] = "texture_bytes",
+	[ METRIC_UI_BYTES ] = "ui_bytes",
+	[ METRIC_ZONE_BYTES ] = "zone_bytes",
+	[ METRIC_SPRITE_BYTES ] = "sprite_bytes",
+	[ METRIC_ITEM_BYTES ] = "item_bytes",
+	[ METRIC_TEXT_BYTES ] = "text_bytes",
+	[ METRIC_FIRST_FRAME ] = "first_frame_us",
+	[ METRIC_BOOT_TIME ] = "boot_us",
+	[ METRIC_FRAME_TIME ] = "frame_us",
+	[ METRIC_FRAME_ALLOCS ] = "frame_allocs",
+	[ METRIC_FRAME_OPENS ] = "frame_opens",
+	[ METRIC_ZONE_ENTRY ] = "zone_entry_us"
+};
+
+/**
+ * `bucketOf` renvoie la classe d'une valeur : 0 pour les valeurs nulles ou
+ * négatives, sinon le nombre de bits de la valeur.
+ */
+static int bucketOf( long value )
+{
+	if( value <= 0 )
+		return 0;
+
+	int bucket = 64 - __builtin_clzl( ( unsigned long )value );
+	return bucket < METRIC_BUCKETS ? bucket : METRIC_BUCKETS - 1;
+}
+
+/**
+ * `metricAdd` ajoute `n` (éventuellement négatif) à un compteur ou à une
+ * jauge.
+ * @param id La mesure (`METRIC_*`)
+ * @param n La quantité ajoutée
+ */
+void metricAdd( int id, long n )
+{
+	atomic_fetch_add_explicit( &Metrics[ id ].value, n, memory_order_relaxed );
+}
+
+/**
+ * `metricSet` donne sa valeur à une jauge.
+ * @param id La mesure (`METRIC_*`)
+ * @param value La nouvelle valeur
+ */
+void metricSet( int id, long value )
+{
+	atomic_store_explicit( &Metrics[ id ].value, value, memory_order_relaxed );
+}
+
+/**
+ * `metricObserve` ajoute une valeur observée à un histogramme.
+ * @param id L'histogramme (`METRIC_*`, à partir de @ref METRIC_FIRST_HISTOGRAM)
+ * @param value La valeur observée
+ */
+void metricObserve( int id, long value )
+{
+	Metric* metric = &Metrics[ id ];
+
+	atomic_fetch_add_explicit( &metric->buckets[ bucketOf( value ) ], 1, memory_order_relaxed );
+	atomic_fetch_add_explicit( &metric->sum, value, memory_order_relaxed );
+	atomic_fetch_add_explicit( &metric->value, 1, memory_order_relaxed );
+
+	long max = atomic_load_explicit( &metric->max, memory_order_relaxed );
+	while( value > max
+		&& !atomic_compare_exchange_weak_explicit( &metric->max, &max, value, memory_order_relaxed, memory_order_relaxed ) )
+		;
+}
+
+/**
+ * `metricValue` renvoie la valeur courante d'un compteur ou d'une jauge, ou
+ * le nombre de valeurs observées par un histogramme.
+ * @param id La mesure (`METRIC_*`)
+ * @return La valeur de la mesure
+ */
+long metricValue( int id )
+{
+	return atomic_load_explicit( &Metrics[ id ].value, memory_order_relaxed );
+}
+
+/**
+ * `metricQuantile` renvoie une borne supérieure du quantile `q` des valeurs
+ * observées par un histogramme : la borne de la classe qui le contient, sans
+ * dépasser la plus grande valeur observée.
+ * @param id L'histogramme (`METRIC_*`)
+ * @param q Le quantile, entre 0 et 1
+ * @return La borne, 0 si aucune valeur n'a été observée
+ */
+long metricQuantile( int id, double q )
+{
+	const Metric* metric = &Metrics[ id ];
+	long count = 0, target, seen = 0;
+	int b;
+
+	for( b = 0; b < METRIC_BUCKETS; b++ )
+		count += atomic_load_explicit( &metric->buckets[ b ], memory_order_relaxed );
+	if( count == 0 )
+		return 0;
+
+	target = ( long )( q * count );
+	if( target < 1 )
+		target = 1;
+
+	for( b = 0; b < METRIC_BUCKETS - 1; b++ )
+	{
+		seen += atomic_load_explicit( &metric->buckets[ b ], memory_order_relaxed );
+		if( seen >= target )
+			break;
+	}
+
+	long bound = b ? ( 1L << b ) - 1 : 0;
+	long max = atomic_load_explicit( &metric->max, memory_order_relaxed );
+	return bound < max ? bound : max;
+}
+
+/**
+ * `metricName` renvoie le nom d'une mesure.
+ * @param id La mesure (`METRIC_*`)
+ * @return Son nom, par exemple `"file_opens"`
+ */
+const char* metricName( int id )
+{
+	return Names[ id ];
+}
+
+/**
+ * `metricsFrame` est appelée par le client graphique à la fin de chaque
+ * image : elle observe la durée de l'image et le nombre d'allocations et
+ * d'ouvertures de fichiers faites depuis l'appel précédent.
+ * @param frame_us La durée de l'image, en microsecondes
+ */
+void metricsFrame( long frame_us )
+{
+	static long last_allocs = 0, last_opens = 0;
+
+	long allocs = metricValue( METRIC_HEAP_ALLOCS );
+	long opens = metricValue( METRIC_FILE_OPENS );
+
+	metricObserve( METRIC_FRAME_TIME, frame_us );
+	metricObserve( METRIC_FRAME_ALLOCS, allocs - last_allocs );
+	metricObserve( METRIC_FRAME_OPENS, opens - last_opens );
+
+	last_allocs = allocs;
+	last_opens = opens;
+}
+
+/**
+ * `metricsFormat` écrit toutes les mesures dans `buffer`, une par ligne :
+ * le nom puis la valeur d'un compteur ou d'une jauge ; le nombre
+ * d'observations, la moyenne, les quantiles 50 % et 99 % et le maximum d'un
+ * histogramme.
+ * @param buffer Le tampon où écrire
+ * @param size La taille du tampon
+ * @return La longueur du texte écrit, tronqué si le tampon est trop petit
+ */
+int metricsFormat( char* buffer, size_t size )
+{
+	size_t length = 0;
+	int id;
+
+	if( size == 0 )
+		return 0;
+	buffer[ 0 ] = '\0';
+
+	for( id = 0; id < METRIC_NB && length < size; id++ )
+	{
+		long value = metricValue( id );
+		int n;
+
+		if( id < METRIC_FIRST_HISTOGRAM )
+			n = snprintf( buffer + length, size - length, "%-16s %ld\n", Names[ id ], value );
+		else
+		{
+			const Metric* metric = &Metrics[ id ];
+			long sum = atomic_load_explicit( &metric->sum, memory_order_relaxed );
+			long max = atomic_load_explicit( &metric->max, memory_order_relaxed );
+
+			n = snprintf( buffer + length, size - length, "%-16s n %ld mean %ld p50 %ld p99 %ld max %ld\n",
+				Names[ id ], value, value ? sum / value : 0,
+				metricQuantile( id, 0.5 ), metricQuantile( id, 0.99 ), max );
+		}
+
+		if( n < 0 )
+			break;
+		length += n;
+	}
+
+	return length < size ? ( int )length : ( int )size - 1;
+}
+
+/**
+ * `metricsWrite` ajoute à `file` un relevé de toutes les mesures (voir
+ * @ref metricsFormat), précédé d'une ligne `# metrics <seconds> s`.
+ * @param file Le fichier où écrire
+ * @param seconds L'instant du relevé, en secondes
+ */
+void metricsWrite( FILE* file, double seconds )
+{
+	char buffer[ 2048 ];
+
+	metricsFormat( buffer, sizeof( buffer ) );
+	fprintf( file, "# metrics %.1f s\n%s", seconds, buffer );
+	fflush( file );
+}
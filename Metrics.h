@@ -0,0 +1,81 @@
+/**
+ * @file Metrics.h
+ * @brief Registre des mesures du jeu : compteurs, jauges et histogrammes,
+ * lisibles à tout moment sous forme de texte pour repérer une fuite ou une
+ * rafale d'accès aux fichiers.
+ */
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+/// Nombre de classes d'un histogramme : la classe `b` compte les valeurs de `2^(b-1)` à `2^b - 1`
+#define METRIC_BUCKETS 32
+
+/**
+ * Mesures du registre, rangées par sorte : les compteurs ne font que
+ * croître, les jauges montent et descendent, les histogrammes répartissent
+ * des valeurs observées en classes de puissances de deux.
+ */
+enum {
+	METRIC_FILE_OPENS, ///< Fichiers ouverts
+	METRIC_HEAP_ALLOCS, ///< Allocations sur le tas, surfaces et textures SDL comprises
+	METRIC_TEXTURES_CREATED, ///< Textures créées
+	METRIC_TEXT_RENDERS, ///< Textes rastérisés par `renderText`
+	METRIC_TEXT_CACHE_HITS, ///< Textes de `renderText` trouvés déjà rastérisés
+	METRIC_DIALOG_REBUILDS, ///< Panneaux de dialogue redessinés
+	METRIC_IMAGE_CACHE_HITS, ///< Images lues du cache des images décodées
+	METRIC_IMAGE_CACHE_STORES, ///< Images ajoutées au cache des images décodées
+	METRIC_ZONE_LOADS, ///< Zones chargées par @ref loadArea
+	METRIC_LAZY_LOADS, ///< Images chargées à leur première utilisation
+	METRIC_WARMUPS, ///< Images décodées d'avance en arrière-plan
+	METRIC_EVICTIONS, ///< Textures libérées pour tenir le budget des textures
+	METRIC_ENCOUNTERS, ///< Rencontres commencées par @ref encounterInit
+
+	METRIC_LIVE_TEXTURES, ///< Textures en vie
+	METRIC_LIVE_GAMES, ///< Parties en vie
+	METRIC_ARENA_BLOCKS, ///< Blocs d'arène en vie
+	METRIC_TEXTURE_BYTES, ///< Octets des textures en vie
+	METRIC_UI_BYTES, ///< Octets des textures de l'interface, dans l'ordre des sortes de textures du client graphique
+	METRIC_ZONE_BYTES, ///< Octets des fonds des zones
+	METRIC_SPRITE_BYTES, ///< Octets des sprites
+	METRIC_ITEM_BYTES, ///< Octets des images des objets
+	METRIC_TEXT_BYTES, ///< Octets des textes rastérisés
+	METRIC_FIRST_FRAME, ///< Délai de la première image du client graphique, en microsecondes
+	METRIC_BOOT_TIME, ///< Durée du démarrage du client graphique, en microsecondes
+
+	METRIC_FRAME_TIME, ///< Durée d'une image, en microsecondes
+	METRIC_FRAME_ALLOCS, ///< Allocations par image
+	METRIC_FRAME_OPENS, ///< Fichiers ouverts par image
+	METRIC_ZONE_ENTRY, ///< Durée du chargement des images d'une zone où entre le joueur, en microsecondes
+
+	METRIC_NB ///< Nombre de mesures
+};
+
+/// Première jauge du registre
+#define METRIC_FIRST_GAUGE METRIC_LIVE_TEXTURES
+/// Premier histogramme du registre
+#define METRIC_FIRST_HISTOGRAM METRIC_FRAME_TIME
+
+/// @brief Ajoute `n` à un compteur ou à une jauge
+void metricAdd( int id, long n );
+/// @brief Donne sa valeur à une jauge
+void metricSet( int id, long value );
+/// @brief Ajoute une valeur observée à un histogramme
+void metricObserve( int id, long value );
+/// @brief Renvoie la valeur d'un compteur ou d'une jauge, le nombre d'observations d'un histogramme
+long metricValue( int id );
+/// @brief Renvoie une borne supérieure du quantile `q` d'un histogramme
+long metricQuantile( int id, double q );
+/// @brief Renvoie le nom d'une mesure
+const char* metricName( int id );
+
+/// @brief Alimente les histogrammes par image à la fin d'une image
+void metricsFrame( long frame_us );
+/// @brief Écrit toutes les mesures sous forme de texte, une par ligne
+int metricsFormat( char* buffer, size_t size );
+/// @brief Écrit toutes les mesures dans un fichier, précédées de l'instant `seconds`
+void metricsWrite( FILE* file, double seconds );
+
+#endif
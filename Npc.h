@@ -7,15 +7,24 @@
 #ifndef __NPC_H__
 #define __NPC_H__
 
-extern char* DialogsQueue[ 3 ];
-extern int* PlayerLife;
-extern int* PlayerAta;
-extern int* PlayerDef;
+/// Nombre de lignes de la file des dialogues
+#define NB_DIALOGS 3
+/// Taille d'une ligne de la file des dialogues
+#define DIALOG_SIZE 1024
+/// Taille du tampon recevant le nom d'un NPC
+#define NPC_NAME_SIZE 30
+/// Nombre de NPC scriptés (types 1000 et suivants), chacun ayant un état par partie
+#define NB_CUSTOM_NPC 2
+/// Taille de l'état interne d'un NPC scripté, rangé dans la partie
+#define NPC_DATA_SIZE 16
+
+/* Partie en cours, définie dans Gameplay.h */
+struct Gameplay_s;
 
 /// \brief Ajoute un dialogue à la file d'attente
-void pushQueue( char* dialog );
+void pushQueue( struct Gameplay_s* game, char* dialog );
 /// \brief Ajoute un dialogue formatté à la file d'attente
-void addDialog( char* format, ... );
+void addDialog( struct Gameplay_s* game, char* format, ... );
 
 /// \enum action_type \brief Le type d'interaction possible avec un NPC
 typedef enum {
@@ -70,11 +79,21 @@ struct npc_stats {
 /* Typedefs */
 typedef struct npc_stats npc_stats;
 
+/// \brief Précharge les fiches de tous les NPC
+void npcPreload ();
+/// \brief Libère les fiches préchargées des NPC
+void npcUnload ();
+/// \brief Indique si un type de NPC existe
+int npcTypeKnown (uint npc_type);
 /// \brief Initialise les données de l'interaction avec un NPC
 int encounterInit (uint npc_type, npc_stats * npc, char * npc_name);
 /// \brief Effectue une action sur le NPC
-int npcResponse (npc_stats * npc, action_type action, uint action_value, char * npc_name);
+int npcResponse (struct Gameplay_s * game, npc_stats * npc, action_type action, uint action_value, char * npc_name);
+/// \brief Donne le seuil de corruption d'un NPC
+int npcCorruptValue (uint type);
 /// \brief Termine l'interaction avec un NPC
 int encounterEnd (npc_stats npc);
+/// \brief Effectue une attaque entre le joueur et un NPC
+void attaque (struct Gameplay_s * game, int p, npc_stats * npc);
 
 #endif
\ No newline at end of file
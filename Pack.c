@@ -0,0 +1,244 @@
+/**
+ * @file Pack.c
+ * Lecture et écriture des paquets d'images. Comme pour les zones compilées,
+ * le paquet est projeté en mémoire et l'index est utilisé en place ; seuls
+ * l'en-tête et les bornes de chaque image sont vérifiés à l'ouverture.
+ */
+#include "Pack.h"
+#include "Lz.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * `packOpen` projette en mémoire un paquet construit par `make pack`.
+ * @param pack Le paquet à remplir
+ * @param path Le chemin du paquet
+ * @return 0 en cas de succès, -1 si le fichier est absent, d'une autre
+ * version ou invalide
+ */
+int packOpen( Pack* pack, const char* path )
+{
+	memset( pack, 0, sizeof( *pack ) );
+
+	int fd = open( path, O_RDONLY );
+	if( fd < 0 )
+		return -1;
+
+	struct stat st;
+	if( fstat( fd, &st ) != 0 || ( size_t )st.st_size < sizeof( PackHeader ) )
+	{
+		close( fd );
+		return -1;
+	}
+
+	void* map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( map == MAP_FAILED )
+		return -1;
+
+	pack->map = map;
+	pack->map_size = st.st_size;
+
+	const PackHeader* header = map;
+	if( memcmp( header->magic, PACK_MAGIC, 4 ) != 0 || header->version != PACK_VERSION
+		|| header->index_offset > pack->map_size || header->index_offset % 8 != 0
+		|| ( pack->map_size - header->index_offset ) / sizeof( PackEntry ) != header->nb_entries
+		|| ( pack->map_size - header->index_offset ) % sizeof( PackEntry ) != 0 )
+		goto error;
+
+	pack->entries = ( const PackEntry* )( ( const char* )map + header->index_offset );
+	pack->nb_entries = header->nb_entries;
+
+	int i;
+	for( i = 0; i < pack->nb_entries; i++ )
+	{
+		const PackEntry* entry = &pack->entries[ i ];
+		if( entry->name[ PACK_NAME_SIZE - 1 ] != '\0' || entry->offset < sizeof( PackHeader )
+			|| entry->offset > header->index_offset || entry->size > header->index_offset - entry->offset
+			|| ( i > 0 && strcmp( pack->entries[ i - 1 ].name, entry->name ) >= 0 ) )
+			goto error;
+	}
+
+	return 0;
+
+error:
+	packClose( pack );
+	return -1;
+}
+
+/**
+ * `packFind` cherche une image par son nom, par dichotomie dans l'index.
+ * @param pack Le paquet, éventuellement fermé
+ * @param name Le nom de l'image, sans extension
+ * @return L'image, ou `NULL` si elle n'est pas dans le paquet
+ */
+const PackEntry* packFind( const Pack* pack, const char* name )
+{
+	int low = 0, high = pack->nb_entries;
+
+	while( low < high )
+	{
+		int middle = ( low + high ) / 2;
+		int order = strcmp( pack->entries[ middle ].name, name );
+		if( order == 0 )
+			return &pack->entries[ middle ];
+		if( order < 0 )
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return NULL;
+}
+
+/**
+ * `packRead` décompresse les pixels d'une image du paquet.
+ * @param pack Le paquet
+ * @param entry L'image, trouvée par @ref packFind
+ * @param pixels Les pixels, `4 * w * h` octets
+ * @return 0 en cas de succès, -1 si les pixels compressés sont invalides
+ */
+int packRead( const Pack* pack, const PackEntry* entry, void* pixels )
+{
+	const uint8_t* src = ( const uint8_t* )pack->map + entry->offset;
+	return lzDecompress( src, entry->size, pixels, ( size_t )entry->w * entry->h * 4 );
+}
+
+/**
+ * `packClose` libère la projection d'un paquet.
+ * @param pack Le paquet à fermer
+ */
+void packClose( Pack* pack )
+{
+	if( pack->map )
+		munmap( pack->map, pack->map_size );
+	memset( pack, 0, sizeof( *pack ) );
+}
+
+/**
+ * `packWriterOpen` crée un paquet vide ; les images y sont ajoutées par
+ * @ref packWriterAdd, dans n'importe quel ordre.
+ * @param writer Le paquet à remplir
+ * @param path Le chemin du paquet à créer
+ * @return 0 en cas de succès, -1 si le fichier n'a pas pu être créé
+ */
+int packWriterOpen( PackWriter* writer, const char* path )
+{
+	memset( writer, 0, sizeof( *writer ) );
+
+	writer->file = fopen( path, "wb" );
+	if( !writer->file )
+		return -1;
+
+	/* en-tête définitif écrit par packWriterClose */
+	PackHeader header;
+	memset( &header, 0, sizeof( header ) );
+	if( fwrite( &header, sizeof( header ), 1, writer->file ) != 1 )
+	{
+		fclose( writer->file );
+		return -1;
+	}
+
+	writer->offset = sizeof( header );
+	return 0;
+}
+
+/**
+ * `packWriterAdd` compresse les pixels d'une image et les ajoute au paquet.
+ * @param writer Le paquet
+ * @param name Le nom de l'image, sans extension
+ * @param w La largeur de l'image
+ * @param h La hauteur de l'image
+ * @param pixels Les pixels ARGB de l'image, sans remplissage
+ * @return 0 en cas de succès, -1 sinon
+ */
+int packWriterAdd( PackWriter* writer, const char* name, int w, int h, const void* pixels )
+{
+	size_t raw_size = ( size_t )w * h * 4;
+
+	if( strlen( name ) >= PACK_NAME_SIZE )
+		return -1;
+
+	if( writer->nb_entries == writer->cap_entries )
+	{
+		int cap = writer->cap_entries ? 2 * writer->cap_entries : 64;
+		PackEntry* entries = realloc( writer->entries, sizeof( PackEntry ) * cap );
+		if( !entries )
+			return -1;
+		writer->entries = entries;
+		writer->cap_entries = cap;
+	}
+
+	uint8_t* packed = malloc( lzBound( raw_size ) );
+	if( !packed )
+		return -1;
+
+	size_t size = lzCompress( pixels, raw_size, packed );
+	int ok = size > 0 && fwrite( packed, 1, size, writer->file ) == size;
+	free( packed );
+	if( !ok )
+		return -1;
+
+	PackEntry* entry = &writer->entries[ writer->nb_entries++ ];
+	memset( entry, 0, sizeof( *entry ) );
+	strcpy( entry->name, name );
+	entry->w = w;
+	entry->h = h;
+	entry->offset = writer->offset;
+	entry->size = size;
+
+	writer->offset += size;
+	writer->raw_size += raw_size;
+	return 0;
+}
+
+/// Ordre des images dans l'index
+static int compareEntries( const void* a, const void* b )
+{
+	return strcmp( ( ( const PackEntry* )a )->name, ( ( const PackEntry* )b )->name );
+}
+
+/**
+ * `packWriterClose` trie et écrit l'index, puis l'en-tête, et ferme le
+ * paquet. Deux images du même nom rendent le paquet invalide.
+ * @param writer Le paquet
+ * @return 0 en cas de succès, -1 sinon
+ */
+int packWriterClose( PackWriter* writer )
+{
+	int ok = 1, i;
+
+	qsort( writer->entries, writer->nb_entries, sizeof( PackEntry ), compareEntries );
+	for( i = 1; i < writer->nb_entries; i++ )
+	{
+		if( strcmp( writer->entries[ i - 1 ].name, writer->entries[ i ].name ) == 0 )
+			ok = 0;
+	}
+
+	/* l'index, utilisé en place, est aligné sur 8 octets */
+	static const char padding[ 8 ];
+	size_t pad = ( size_t )( -writer->offset & 7 );
+	ok = ok && fwrite( padding, 1, pad, writer->file ) == pad;
+
+	PackHeader header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, PACK_MAGIC, 4 );
+	header.version = PACK_VERSION;
+	header.nb_entries = writer->nb_entries;
+	header.index_offset = writer->offset + pad;
+
+	ok = ok && fwrite( writer->entries, sizeof( PackEntry ), writer->nb_entries, writer->file ) == ( size_t )writer->nb_entries
+		&& fseek( writer->file, 0, SEEK_SET ) == 0
+		&& fwrite( &header, sizeof( header ), 1, writer->file ) == 1;
+
+	if( fclose( writer->file ) != 0 )
+		ok = 0;
+	free( writer->entries );
+	writer->entries = NULL;
+
+	return ok ? 0 : -1;
+}
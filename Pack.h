@@ -0,0 +1,94 @@
+/**
+ * @file Pack.h
+ * @brief Paquet d'images décodées d'avance (`make pack`) : les pixels de
+ * chaque image du dossier Img, compressés avec @ref lzCompress, et un index
+ * trié par nom. Le paquet est projeté en mémoire et une image se lit d'une
+ * seule décompression, sans décoder de png.
+ */
+#ifndef __PACK_H__
+#define __PACK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// Signature des paquets d'images
+#define PACK_MAGIC "4APK"
+/// Version du format des paquets d'images
+#define PACK_VERSION 1
+/// Taille maximale du nom d'une image, caractère nul compris
+#define PACK_NAME_SIZE 56
+
+/**
+ * @struct PackHeader
+ * @brief En-tête d'un paquet. Le paquet contient ensuite les pixels
+ * compressés de chaque image, puis l'index. Les entiers et les pixels sont
+ * dans l'ordre des octets de la machine qui a construit le paquet.
+ */
+typedef struct
+{
+	char magic[ 4 ]; ///< @ref PACK_MAGIC
+	uint32_t version; ///< @ref PACK_VERSION
+	uint32_t nb_entries; ///< Nombre d'images
+	uint32_t reserved; ///< Zéro
+	uint64_t index_offset; ///< Position de l'index dans le paquet
+} PackHeader;
+
+/**
+ * @struct PackEntry
+ * @brief Image du paquet : ses pixels sont des entiers de 32 bits ARGB
+ * (`SDL_PIXELFORMAT_ARGB8888`), sans alpha prémultiplié, ligne après ligne
+ * sans remplissage.
+ */
+typedef struct
+{
+	char name[ PACK_NAME_SIZE ]; ///< Nom de l'image dans le dossier Img, sans extension
+	uint32_t w; ///< Largeur
+	uint32_t h; ///< Hauteur
+	uint64_t offset; ///< Position des pixels compressés dans le paquet
+	uint64_t size; ///< Taille des pixels compressés
+} PackEntry;
+
+/**
+ * @struct Pack
+ * @brief Paquet projeté en mémoire, lisible depuis plusieurs fils
+ */
+typedef struct
+{
+	void* map; ///< Projection du paquet, `NULL` si aucun paquet n'est ouvert
+	size_t map_size; ///< Taille de la projection
+	const PackEntry* entries; ///< Index, trié par nom
+	int nb_entries; ///< Nombre d'images
+} Pack;
+
+/**
+ * @struct PackWriter
+ * @brief Paquet en cours d'écriture
+ */
+typedef struct
+{
+	FILE* file; ///< Fichier du paquet
+	PackEntry* entries; ///< Index des images déjà écrites
+	int nb_entries; ///< Nombre d'images écrites
+	int cap_entries; ///< Capacité de `entries`
+	uint64_t offset; ///< Position de la prochaine image
+	uint64_t raw_size; ///< Taille totale des pixels avant compression
+} PackWriter;
+
+/// @brief Projette en mémoire un paquet
+int packOpen( Pack* pack, const char* path );
+/// @brief Cherche une image dans un paquet
+const PackEntry* packFind( const Pack* pack, const char* name );
+/// @brief Décompresse les pixels d'une image du paquet
+int packRead( const Pack* pack, const PackEntry* entry, void* pixels );
+/// @brief Ferme un paquet
+void packClose( Pack* pack );
+
+/// @brief Commence l'écriture d'un paquet
+int packWriterOpen( PackWriter* writer, const char* path );
+/// @brief Compresse et ajoute une image au paquet
+int packWriterAdd( PackWriter* writer, const char* name, int w, int h, const void* pixels );
+/// @brief Écrit l'index et ferme le paquet
+int packWriterClose( PackWriter* writer );
+
+#endif
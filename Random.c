@@ -0,0 +1,80 @@
+/**
+ * @file Random.c
+ * Générateur PCG32 (M. O'Neill, "PCG: A Family of Simple Fast
+ * Space-Efficient Statistically Good Algorithms for Random Number
+ * Generation"). Contrairement à `rand()`, son état est dans la partie : les
+ * parties jouées en parallèle ne partagent rien et chacune se rejoue à
+ * l'identique depuis sa graine.
+ */
+#include "Random.h"
+
+/// Multiplicateur de la suite congruentielle de PCG32
+#define PCG_MULT 6364136223846793005ULL
+
+/**
+ * `rngSeed` initialise le générateur. Deux flux différents donnent deux
+ * suites différentes pour une même graine, ce qui permet de donner à chaque
+ * partie d'une simulation son propre flux.
+ * @param rng Le générateur
+ * @param seed La graine
+ * @param stream Le numéro du flux
+ */
+void rngSeed( Rng* rng, uint64_t seed, uint64_t stream )
+{
+	rng->seed = seed;
+	rng->stream = stream;
+	rng->state = 0;
+	rng->inc = ( stream << 1 ) | 1;
+	rngNext( rng );
+	rng->state += seed;
+	rngNext( rng );
+}
+
+/**
+ * `rngNext` fait avancer le générateur et renvoie 32 bits pseudo-aléatoires.
+ * @param rng Le générateur
+ */
+uint32_t rngNext( Rng* rng )
+{
+	uint64_t old = rng->state;
+	rng->state = old * PCG_MULT + rng->inc;
+
+	uint32_t xorshifted = ( uint32_t )( ( ( old >> 18 ) ^ old ) >> 27 );
+	uint32_t rot = ( uint32_t )( old >> 59 );
+	return ( xorshifted >> rot ) | ( xorshifted << ( ( -rot ) & 31 ) );
+}
+
+/**
+ * `rngNext64` renvoie 64 bits pseudo-aléatoires, formés de deux tirages.
+ * @param rng Le générateur
+ */
+uint64_t rngNext64( Rng* rng )
+{
+	uint64_t high = rngNext( rng );
+	return ( high << 32 ) | rngNext( rng );
+}
+
+/**
+ * `rngBelow` renvoie un entier dans [0, `n`[ par multiplication plutôt que
+ * par modulo (D. Lemire) : un seul produit et pas de division. Le biais,
+ * inférieur à n / 2^32, est négligeable pour les tirages du jeu.
+ * @param rng Le générateur
+ * @param n La borne, strictement positive
+ */
+int rngBelow( Rng* rng, int n )
+{
+	return (int) ( ( (uint64_t) rngNext( rng ) * (uint32_t) n ) >> 32 );
+}
+
+/**
+ * `rngSplit` initialise `child` avec une graine et un flux tirés de `rng`.
+ * Les deux générateurs peuvent ensuite être utilisés indépendamment, par
+ * exemple l'un par la partie et l'autre par le joueur simulé.
+ * @param rng Le générateur parent, qui avance de quatre tirages
+ * @param child Le générateur à initialiser
+ */
+void rngSplit( Rng* rng, Rng* child )
+{
+	uint64_t seed = rngNext64( rng );
+	rngSeed( child, seed, rngNext64( rng ) );
+}
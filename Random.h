@@ -0,0 +1,35 @@
+/**
+ * @file Random.h
+ * @brief Générateur pseudo-aléatoire PCG32 propre à chaque partie : une
+ * même graine et une même suite d'entrées rejouent toujours la même partie.
+ */
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <stdint.h>
+
+/**
+ * @struct Rng
+ * @brief État d'un générateur PCG32 (XSH RR, 64 bits d'état). Chaque valeur
+ * de `stream` donne une suite indépendante pour une même graine.
+ */
+typedef struct
+{
+	uint64_t state; ///< État courant
+	uint64_t inc; ///< Incrément, impair, dérivé de `stream`
+	uint64_t seed; ///< Graine donnée à @ref rngSeed, conservée pour rejouer
+	uint64_t stream; ///< Flux donné à @ref rngSeed
+} Rng;
+
+/// @brief Initialise le générateur avec une graine et un numéro de flux
+void rngSeed( Rng* rng, uint64_t seed, uint64_t stream );
+/// @brief Renvoie 32 bits pseudo-aléatoires
+uint32_t rngNext( Rng* rng );
+/// @brief Renvoie 64 bits pseudo-aléatoires
+uint64_t rngNext64( Rng* rng );
+/// @brief Renvoie un entier dans [0, n[
+int rngBelow( Rng* rng, int n );
+/// @brief Dérive un générateur indépendant de `rng`
+void rngSplit( Rng* rng, Rng* child );
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file Replay.c
+ * Journal des entrées du joueur. Une partie ne dépend que de sa graine (voir
+ * @ref seedGameplay) et des entrées résolues par l'interface : les rejouer
+ * dans l'ordre reproduit exactement la partie, sans la SDL. Chaque entrée
+ * occupe 12 octets ; un début de partie occupe 12 octets suivis de la
+ * graine et du flux.
+ */
+#include "Replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * `recorderWrite` ajoute un événement au journal.
+ */
+static void recorderWrite( Recorder* rec, const ReplayEvent* event )
+{
+	fwrite( event, sizeof( *event ), 1, rec->file );
+	rec->count++;
+}
+
+/**
+ * `recorderOpen` crée le journal `path` et y écrit son en-tête.
+ * @param rec Le journal à ouvrir
+ * @param path Le chemin du fichier à créer
+ * @param now Instant courant en millisecondes, origine des instants du journal
+ * @return 0 en cas de succès, -1 sinon
+ */
+int recorderOpen( Recorder* rec, const char* path, uint32_t now )
+{
+	memset( rec, 0, sizeof( *rec ) );
+
+	rec->file = fopen( path, "wb" );
+	if( !rec->file )
+		return -1;
+
+	ReplayHeader header;
+	memcpy( header.magic, REPLAY_MAGIC, 4 );
+	header.version = REPLAY_VERSION;
+
+	if( fwrite( &header, sizeof( header ), 1, rec->file ) != 1 )
+	{
+		fclose( rec->file );
+		rec->file = NULL;
+		return -1;
+	}
+
+	rec->start = now;
+	return 0;
+}
+
+/**
+ * `recorderSeed` enregistre le début d'une partie : à la relecture, la
+ * partie est réinitialisée avec la même graine et le même flux. À appeler
+ * après chaque @ref seedGameplay.
+ * @param rec Le journal, ignoré s'il n'est pas ouvert
+ * @param game La partie qui commence
+ * @param now Instant courant en millisecondes
+ */
+void recorderSeed( Recorder* rec, const Gameplay_s* game, uint32_t now )
+{
+	if( !rec->file )
+		return;
+
+	ReplayEvent event = { now - rec->start, REPLAY_SEED, game->state, 0, 0 };
+	uint64_t payload[ 2 ] = { game->rng.seed, game->rng.stream };
+
+	recorderWrite( rec, &event );
+	fwrite( payload, sizeof( payload ), 1, rec->file );
+}
+
+/**
+ * `recorderInput` enregistre une entrée résolue par l'interface, avant
+ * qu'elle ne soit appliquée à la partie.
+ * @param rec Le journal, ignoré s'il n'est pas ouvert
+ * @param game La partie, dans son état avant l'entrée
+ * @param input L'entrée du joueur
+ * @param now Instant courant en millisecondes
+ */
+void recorderInput( Recorder* rec, const Gameplay_s* game, Input input, uint32_t now )
+{
+	if( !rec->file )
+		return;
+
+	ReplayEvent event;
+	event.time = now - rec->start;
+	event.kind = input.kind;
+	event.state = game->state;
+	event.item = input.kind == INPUT_SLOT ? game->inventory.items[ input.value ] : game->selected_item;
+	event.value = input.value;
+
+	recorderWrite( rec, &event );
+}
+
+/**
+ * `recorderClose` ferme le journal.
+ * @param rec Le journal
+ * @return 0 si tout le journal a été écrit, -1 sinon
+ */
+int recorderClose( Recorder* rec )
+{
+	int ok = 1;
+
+	if( rec->file )
+	{
+		ok = !ferror( rec->file );
+		if( fclose( rec->file ) != 0 )
+			ok = 0;
+	}
+
+	rec->file = NULL;
+	return ok ? 0 : -1;
+}
+
+/**
+ * `replayDecode` lit l'événement situé à `replay->pos` dans `replay->next`.
+ * Un événement tronqué en fin de fichier termine le journal.
+ */
+static void replayDecode( Replay* replay )
+{
+	if( replay->pos + sizeof( ReplayEvent ) > replay->size )
+	{
+		replay->pos = replay->size;
+		return;
+	}
+
+	memcpy( &replay->next, replay->data + replay->pos, sizeof( ReplayEvent ) );
+
+	if( replay->next.kind == REPLAY_SEED )
+	{
+		uint64_t payload[ 2 ];
+		if( replay->pos + sizeof( ReplayEvent ) + sizeof( payload ) > replay->size )
+		{
+			replay->pos = replay->size;
+			return;
+		}
+
+		memcpy( payload, replay->data + replay->pos + sizeof( ReplayEvent ), sizeof( payload ) );
+		replay->seed = payload[ 0 ];
+		replay->stream = payload[ 1 ];
+	}
+}
+
+/**
+ * `replayLoad` charge tout le journal `path` en mémoire.
+ * @param replay Le journal à charger
+ * @param path Le chemin du journal
+ * @return 0 en cas de succès, -1 si le fichier est absent ou invalide
+ */
+int replayLoad( Replay* replay, const char* path )
+{
+	memset( replay, 0, sizeof( *replay ) );
+
+	FILE* file = fopen( path, "rb" );
+	if( !file )
+		return -1;
+
+	fseek( file, 0, SEEK_END );
+	long size = ftell( file );
+	fseek( file, 0, SEEK_SET );
+
+	if( size < ( long )sizeof( ReplayHeader ) )
+	{
+		fclose( file );
+		return -1;
+	}
+
+	replay->data = malloc( size );
+	replay->size = size;
+
+	int ok = fread( replay->data, 1, size, file ) == ( size_t )size;
+	fclose( file );
+
+	const ReplayHeader* header = ( const ReplayHeader* )replay->data;
+	if( !ok || memcmp( header->magic, REPLAY_MAGIC, 4 ) != 0 || header->version != REPLAY_VERSION )
+	{
+		replayFree( replay );
+		return -1;
+	}
+
+	replayRewind( replay );
+	return 0;
+}
+
+/**
+ * `replayPending` indique s'il reste des événements à relire.
+ * @param replay Le journal
+ * @return Non nul s'il reste au moins un événement
+ */
+int replayPending( const Replay* replay )
+{
+	return replay->pos < replay->size;
+}
+
+/**
+ * `replayStep` applique le prochain événement à la partie : un début de
+ * partie la réinitialise avec sa graine, une entrée passe par
+ * @ref applyInput comme un clic. Le prochain événement est disponible dans
+ * `replay->next`, son instant permet de relire à la vitesse enregistrée.
+ * @param replay Le journal
+ * @param game La partie rejouée
+ * @return 1 si un événement a été appliqué, 0 à la fin du journal, -1 si la
+ * partie a divergé de l'enregistrement ou si l'entrée n'est pas possible
+ * (voir @ref inputAllowed) : l'événement n'est alors pas appliqué
+ */
+int replayStep( Replay* replay, Gameplay_s* game )
+{
+	if( !replayPending( replay ) )
+		return 0;
+
+	const ReplayEvent* event = &replay->next;
+
+	if( event->kind == REPLAY_SEED )
+	{
+		seedGameplay( game, replay->seed, replay->stream );
+		initGameplay( game );
+		replay->pos += sizeof( ReplayEvent ) + 2 * sizeof( uint64_t );
+	}
+	else
+	{
+		Input input = { event->kind, event->value };
+		if( event->state != game->state || !inputAllowed( game, input ) )
+			return -1;
+		if( event->kind == INPUT_SLOT && event->item != game->inventory.items[ event->value ] )
+			return -1;
+
+		applyInput( game, input );
+		replay->pos += sizeof( ReplayEvent );
+	}
+
+	replayDecode( replay );
+	return 1;
+}
+
+/**
+ * `replayRewind` revient au premier événement du journal.
+ * @param replay Le journal
+ */
+void replayRewind( Replay* replay )
+{
+	replay->pos = sizeof( ReplayHeader );
+	replayDecode( replay );
+}
+
+/**
+ * `replayFree` libère le journal chargé par @ref replayLoad.
+ * @param replay Le journal
+ */
+void replayFree( Replay* replay )
+{
+	free( replay->data );
+	memset( replay, 0, sizeof( *replay ) );
+}
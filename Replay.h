@@ -0,0 +1,93 @@
+/**
+ * @file Replay.h
+ * @brief Enregistrement des entrées du joueur dans un journal binaire
+ * compact et relecture de ce journal, à la vitesse enregistrée ou aussi vite
+ * que possible.
+ */
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "Gameplay.h"
+
+/// Signature des journaux d'entrées
+#define REPLAY_MAGIC "4ARP"
+/// Version du format des journaux d'entrées
+#define REPLAY_VERSION 1
+
+/// Événement de début de partie : suivi de la graine et du flux (2 × 64 bits)
+#define REPLAY_SEED 0xff
+
+/**
+ * @struct ReplayHeader
+ * @brief En-tête d'un journal d'entrées, suivi des événements jusqu'à la
+ * fin du fichier. Les entiers sont dans l'ordre des octets de la machine qui
+ * a enregistré le journal.
+ */
+typedef struct
+{
+	char magic[ 4 ]; ///< @ref REPLAY_MAGIC
+	uint32_t version; ///< @ref REPLAY_VERSION
+} ReplayHeader;
+
+/**
+ * @struct ReplayEvent
+ * @brief Entrée du joueur telle qu'elle est stockée dans le journal
+ */
+typedef struct
+{
+	uint32_t time; ///< Instant de l'entrée en millisecondes depuis le début de l'enregistrement
+	uint8_t kind; ///< Type de l'entrée (`INPUT_*`) ou @ref REPLAY_SEED
+	uint8_t state; ///< État du jeu au moment de l'entrée, vérifié à la relecture
+	uint16_t item; ///< Objet sélectionné, ou contenu de la case pour `INPUT_SLOT`
+	int32_t value; ///< Élément, action ou case de l'inventaire
+} ReplayEvent;
+
+/**
+ * @struct Recorder
+ * @brief Journal d'entrées en cours d'écriture
+ */
+typedef struct
+{
+	FILE* file; ///< Fichier du journal
+	uint32_t start; ///< Instant du début de l'enregistrement
+	long count; ///< Nombre d'événements écrits
+} Recorder;
+
+/**
+ * @struct Replay
+ * @brief Journal d'entrées chargé en mémoire pour être relu
+ */
+typedef struct
+{
+	unsigned char* data; ///< Contenu du fichier
+	size_t size; ///< Taille du fichier
+	size_t pos; ///< Position du prochain événement
+	ReplayEvent next; ///< Prochain événement, valide si `pos < size`
+	uint64_t seed, stream; ///< Graine et flux du prochain événement @ref REPLAY_SEED
+} Replay;
+
+/// @brief Ouvre un journal d'entrées en écriture
+int recorderOpen( Recorder* rec, const char* path, uint32_t now );
+/// @brief Enregistre le début d'une partie avec sa graine
+void recorderSeed( Recorder* rec, const Gameplay_s* game, uint32_t now );
+/// @brief Enregistre une entrée du joueur avant son application
+void recorderInput( Recorder* rec, const Gameplay_s* game, Input input, uint32_t now );
+/// @brief Ferme le journal
+int recorderClose( Recorder* rec );
+
+/// @brief Charge un journal d'entrées
+int replayLoad( Replay* replay, const char* path );
+/// @brief Indique si le journal contient encore des événements
+int replayPending( const Replay* replay );
+/// @brief Applique le prochain événement du journal à la partie
+int replayStep( Replay* replay, Gameplay_s* game );
+/// @brief Revient au début du journal
+void replayRewind( Replay* replay );
+/// @brief Libère le journal
+void replayFree( Replay* replay );
+
+#endif
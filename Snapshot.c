@@ -0,0 +1,322 @@
+/**
+ * @file Snapshot.c
+ * Instantanés d'une partie. Les seuls pointeurs de @ref Gameplay_s vont vers
+ * ses arènes : les NPC rencontrés sont copiés à plat et repérés par leur
+ * indice, les éléments de la zone sont rechargés depuis la zone courante
+ * (ils ne dépendent que d'elle), l'index spatial est reconstruit. Un
+ * instantané fait quelques kilo-octets, les dialogues n'étant copiés que
+ * sur leur longueur.
+ */
+#include "Snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * `dialogLength` renvoie la longueur de la ligne `i` de la file des
+ * dialogues.
+ */
+static size_t dialogLength( const Gameplay_s* game, int i )
+{
+	const char* end = memchr( game->dialogs[ i ], '\0', DIALOG_SIZE );
+	return end ? ( size_t )( end - game->dialogs[ i ] ) : DIALOG_SIZE - 1;
+}
+
+/**
+ * `snapshotSize` renvoie la taille de l'instantané de la partie `game`.
+ * @param game La partie
+ * @return La taille en octets
+ */
+size_t snapshotSize( const Gameplay_s* game )
+{
+	size_t size = sizeof( SnapshotHeader ) + sizeof( SnapshotState )
+		+ sizeof( npc_stats ) * game->nb_npc;
+
+	int i;
+	for( i = 0; i < NB_DIALOGS; i++ )
+		size += sizeof( uint16_t ) + dialogLength( game, i );
+
+	return size;
+}
+
+/**
+ * `snapshotGameplay` écrit l'instantané de la partie `game` dans `buffer`.
+ * @param game La partie
+ * @param buffer Le tampon recevant l'instantané
+ * @param capacity La taille du tampon
+ * @return La taille de l'instantané, ou 0 si le tampon est trop petit (voir
+ * @ref snapshotSize)
+ */
+size_t snapshotGameplay( const Gameplay_s* game, void* buffer, size_t capacity )
+{
+	size_t size = snapshotSize( game );
+	if( size > capacity )
+		return 0;
+
+	unsigned char* p = buffer;
+
+	SnapshotHeader header;
+	memcpy( header.magic, SNAPSHOT_MAGIC, 4 );
+	header.version = SNAPSHOT_VERSION;
+	header.size = size;
+	header.nb_npc = game->nb_npc;
+	memcpy( p, &header, sizeof( header ) );
+	p += sizeof( header );
+
+	SnapshotState s;
+	memset( &s, 0, sizeof( s ) );
+	s.state = game->state;
+	s.old_state = game->old_state;
+	s.end_cause = game->end_cause;
+	s.area = game->area;
+	s.no_leave = game->no_leave;
+	s.interaction_index = game->interaction_index;
+	s.max_life = game->player_max_life;
+	s.current_life = game->player_current_life;
+	s.atk = game->player_atk;
+	s.def = game->player_def;
+	memcpy( s.items, game->inventory.items, sizeof( s.items ) );
+	s.gold = game->inventory.gold;
+	s.equipment[ 0 ] = game->inventory.equipment[ 0 ];
+	s.equipment[ 1 ] = game->inventory.equipment[ 1 ];
+	s.stuff[ 0 ] = game->stuff[ 0 ];
+	s.stuff[ 1 ] = game->stuff[ 1 ];
+	s.selected_item = game->selected_item;
+	s.index_selected_item = game->index_selected_item;
+	s.index_current_npc = game->index_current_npc;
+	memcpy( s.name, game->name, sizeof( s.name ) );
+	memcpy( s.npc_data, game->npc_data, sizeof( s.npc_data ) );
+	s.rng_state = game->rng.state;
+	s.rng_inc = game->rng.inc;
+	s.rng_seed = game->rng.seed;
+	s.rng_stream = game->rng.stream;
+	memcpy( p, &s, sizeof( s ) );
+	p += sizeof( s );
+
+	if( game->nb_npc )
+		memcpy( p, game->npcs, sizeof( npc_stats ) * game->nb_npc );
+	p += sizeof( npc_stats ) * game->nb_npc;
+
+	int i;
+	for( i = 0; i < NB_DIALOGS; i++ )
+	{
+		uint16_t len = dialogLength( game, i );
+		memcpy( p, &len, sizeof( len ) );
+		memcpy( p + sizeof( len ), game->dialogs[ i ], len );
+		p += sizeof( len ) + len;
+	}
+
+	return size;
+}
+
+/**
+ * `restoreGameplay` remet la partie `game` dans l'état de l'instantané
+ * `buffer`. La zone n'est rechargée que si l'instantané a été pris dans une
+ * autre zone ; sinon la restauration ne fait que des copies. L'instantané
+ * est entièrement vérifié avant que la partie ne soit modifiée : longueurs,
+ * états et fin du jeu, existence de la zone, types des NPC, identifiants
+ * des objets (@ref itemKnown ; l'équipement peut aussi garder sa valeur de
+ * départ, qui n'est pas au catalogue), et, dans les états qui s'en servent,
+ * indices de l'élément et du NPC en cours.
+ * @param game La partie à restaurer
+ * @param buffer L'instantané
+ * @param size La taille de l'instantané
+ * @return 0 en cas de succès, -1 si l'instantané est invalide
+ */
+int restoreGameplay( Gameplay_s* game, const void* buffer, size_t size )
+{
+	const unsigned char* p = buffer;
+	SnapshotHeader header;
+	SnapshotState s;
+
+	if( size < sizeof( header ) + sizeof( s ) )
+		return -1;
+
+	memcpy( &header, p, sizeof( header ) );
+	if( memcmp( header.magic, SNAPSHOT_MAGIC, 4 ) != 0 || header.version != SNAPSHOT_VERSION
+		|| header.size != size
+		|| header.nb_npc > ( size - sizeof( header ) - sizeof( s ) ) / sizeof( npc_stats ) )
+		return -1;
+
+	const unsigned char* npcs = p + sizeof( header ) + sizeof( s );
+	const unsigned char* dialogs = npcs + sizeof( npc_stats ) * ( size_t )header.nb_npc;
+	const unsigned char* end = p + size;
+
+	/* vérification des longueurs des dialogues */
+	const unsigned char* q = dialogs;
+	int i;
+	for( i = 0; i < NB_DIALOGS; i++ )
+	{
+		uint16_t len;
+		if( q + sizeof( len ) > end )
+			return -1;
+		memcpy( &len, q, sizeof( len ) );
+		if( len >= DIALOG_SIZE || q + sizeof( len ) + len > end )
+			return -1;
+		q += sizeof( len ) + len;
+	}
+
+	memcpy( &s, p + sizeof( header ), sizeof( s ) );
+	if( s.state < 0 || s.state >= NB_STATES || s.old_state < 0 || s.old_state >= NB_STATES
+		|| s.end_cause < 0 || s.end_cause >= NB_END_CAUSES
+		|| s.index_selected_item < -1 || s.index_selected_item >= MAX_ITEM )
+		return -1;
+
+	/* objets : getItemFromID échoue sur un identifiant inconnu */
+	Inventory start;
+	inventoryInit( &start );
+	for( i = 0; i < MAX_ITEM; i++ )
+	{
+		if( !itemKnown( s.items[ i ] ) )
+			return -1;
+	}
+	for( i = 0; i < 2; i++ )
+	{
+		if( !itemKnown( s.stuff[ i ] )
+			|| ( !itemKnown( s.equipment[ i ] ) && s.equipment[ i ] != start.equipment[ i ] ) )
+			return -1;
+	}
+	if( !itemKnown( s.selected_item ) )
+		return -1;
+
+	/* NPC : leur type désigne une fiche ou un NPC scripté */
+	for( i = 0; i < ( int )header.nb_npc; i++ )
+	{
+		npc_stats npc;
+		memcpy( &npc, npcs + sizeof( npc_stats ) * i, sizeof( npc ) );
+		if( !npcTypeKnown( npc.type ) )
+			return -1;
+	}
+
+	/* la zone doit exister : loadArea ne sait pas échouer */
+	int reload = s.area != game->area || game->elements.count == 0;
+	int nb_elements = reload ? areaElementCount( s.area ) : game->elements.count;
+	if( nb_elements < 0 )
+		return -1;
+
+	/* l'élément et le NPC en cours ne sont lus que pendant une interaction,
+	   ou dans l'inventaire ouvert depuis une interaction */
+	int interacting = s.state == STATE_INTERACTION || s.state == STATE_TALK
+		|| ( s.state == STATE_INVENTORY && s.old_state == STATE_INTERACTION );
+	if( interacting && ( s.interaction_index < 0 || s.interaction_index >= nb_elements
+		|| s.index_current_npc < 0 || s.index_current_npc >= ( int64_t )header.nb_npc ) )
+		return -1;
+
+	if( reload )
+		loadArea( game, s.area );
+
+	game->state = s.state;
+	game->old_state = s.old_state;
+	game->end_cause = s.end_cause;
+	game->no_leave = s.no_leave;
+	game->interaction_index = s.interaction_index;
+	game->player_max_life = s.max_life;
+	game->player_current_life = s.current_life;
+	game->player_atk = s.atk;
+	game->player_def = s.def;
+	memcpy( game->inventory.items, s.items, sizeof( s.items ) );
+	game->inventory.gold = s.gold;
+	game->inventory.equipment[ 0 ] = s.equipment[ 0 ];
+	game->inventory.equipment[ 1 ] = s.equipment[ 1 ];
+	game->stuff[ 0 ] = s.stuff[ 0 ];
+	game->stuff[ 1 ] = s.stuff[ 1 ];
+	game->selected_item = s.selected_item;
+	game->index_selected_item = s.index_selected_item;
+	game->index_current_npc = s.index_current_npc;
+	memcpy( game->name, s.name, sizeof( s.name ) );
+	game->name[ NPC_NAME_SIZE - 1 ] = '\0';
+	memcpy( game->npc_data, s.npc_data, sizeof( s.npc_data ) );
+	game->rng.state = s.rng_state;
+	game->rng.inc = s.rng_inc;
+	game->rng.seed = s.rng_seed;
+	game->rng.stream = s.rng_stream;
+
+	/* les NPC tiennent dans le tableau actuel s'il est assez grand */
+	if( ( int )header.nb_npc > game->cap_npc )
+	{
+		arenaReset( &game->arena );
+		game->cap_npc = header.nb_npc;
+		game->npcs = arenaAlloc( &game->arena, sizeof( npc_stats ) * header.nb_npc );
+	}
+	if( header.nb_npc )
+		memcpy( game->npcs, npcs, sizeof( npc_stats ) * header.nb_npc );
+	game->nb_npc = header.nb_npc;
+
+	q = dialogs;
+	for( i = 0; i < NB_DIALOGS; i++ )
+	{
+		uint16_t len;
+		memcpy( &len, q, sizeof( len ) );
+		memcpy( game->dialogs[ i ], q + sizeof( len ), len );
+		memset( game->dialogs[ i ] + len, 0, DIALOG_SIZE - len );
+		q += sizeof( len ) + len;
+	}
+	game->dialog_generation++;
+
+	return 0;
+}
+
+/**
+ * `saveGameplay` écrit l'instantané de la partie `game` dans le fichier
+ * `path`.
+ * @param game La partie
+ * @param path Le chemin du fichier
+ * @return 0 en cas de succès, -1 sinon
+ */
+int saveGameplay( const Gameplay_s* game, const char* path )
+{
+	size_t size = snapshotSize( game );
+	void* buffer = malloc( size );
+	if( !buffer )
+		return -1;
+	snapshotGameplay( game, buffer, size );
+
+	FILE* file = fopen( path, "wb" );
+	int ok = file && fwrite( buffer, 1, size, file ) == size;
+	if( file && fclose( file ) != 0 )
+		ok = 0;
+
+	free( buffer );
+	return ok ? 0 : -1;
+}
+
+/**
+ * `loadGameplay` restaure la partie `game` depuis le fichier `path` écrit
+ * par @ref saveGameplay. La partie n'est pas modifiée si le fichier est
+ * absent ou invalide.
+ * @param game La partie à restaurer
+ * @param path Le chemin du fichier
+ * @return 0 en cas de succès, -1 sinon
+ */
+int loadGameplay( Gameplay_s* game, const char* path )
+{
+	FILE* file = fopen( path, "rb" );
+	if( !file )
+		return -1;
+
+	fseek( file, 0, SEEK_END );
+	long size = ftell( file );
+	fseek( file, 0, SEEK_SET );
+
+	if( size <= 0 )
+	{
+		fclose( file );
+		return -1;
+	}
+
+	void* buffer = malloc( size );
+	if( !buffer )
+	{
+		fclose( file );
+		return -1;
+	}
+	int ok = fread( buffer, 1, size, file ) == ( size_t )size;
+	fclose( file );
+
+	if( ok )
+		ok = restoreGameplay( game, buffer, size ) == 0;
+
+	free( buffer );
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file Snapshot.h
+ * @brief Instantanés binaires compacts d'une partie : sauvegarde et
+ * restauration de tout l'état de jeu, assez rapides pour être faites à
+ * chaque tour.
+ */
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Gameplay.h"
+
+/// Signature des instantanés
+#define SNAPSHOT_MAGIC "4ASV"
+/// Version du format des instantanés
+#define SNAPSHOT_VERSION 1
+
+/**
+ * @struct SnapshotHeader
+ * @brief En-tête d'un instantané. Il est suivi de @ref SnapshotState, des
+ * `nb_npc` NPC rencontrés puis des lignes de la file des dialogues, chacune
+ * précédée de sa longueur sur 16 bits. Les entiers sont dans l'ordre des
+ * octets de la machine qui a pris l'instantané.
+ */
+typedef struct
+{
+	char magic[ 4 ]; ///< @ref SNAPSHOT_MAGIC
+	uint32_t version; ///< @ref SNAPSHOT_VERSION
+	uint32_t size; ///< Taille totale de l'instantané
+	uint32_t nb_npc; ///< Nombre de NPC rencontrés
+} SnapshotHeader;
+
+/**
+ * @struct SnapshotState
+ * @brief Champs de taille fixe de la partie. Les éléments de la zone ne
+ * sont pas copiés : ils sont rechargés depuis la zone `area`.
+ */
+typedef struct
+{
+	int32_t state, old_state, end_cause; ///< États du jeu
+	int32_t area, no_leave, interaction_index; ///< Zone et élément en cours
+	int32_t max_life, current_life, atk, def; ///< Statistiques du joueur
+	int32_t items[ MAX_ITEM ]; ///< Cases de l'inventaire
+	int32_t gold; ///< Pièces d'or
+	int32_t equipment[ 2 ], stuff[ 2 ]; ///< Équipement et objets portés
+	int32_t selected_item, index_selected_item; ///< Objet sélectionné
+	int32_t index_current_npc; ///< NPC actif, indice dans les NPC rencontrés
+	char name[ NPC_NAME_SIZE ]; ///< Nom du NPC actif
+	unsigned char npc_data[ NB_CUSTOM_NPC ][ NPC_DATA_SIZE ]; ///< État des NPC scriptés
+	uint64_t rng_state, rng_inc, rng_seed, rng_stream; ///< Générateur pseudo-aléatoire
+} SnapshotState;
+
+/// @brief Renvoie la taille de l'instantané d'une partie
+size_t snapshotSize( const Gameplay_s* game );
+/// @brief Écrit l'instantané d'une partie dans un tampon
+size_t snapshotGameplay( const Gameplay_s* game, void* buffer, size_t capacity );
+/// @brief Restaure une partie depuis un instantané
+int restoreGameplay( Gameplay_s* game, const void* buffer, size_t size );
+/// @brief Sauvegarde une partie dans un fichier
+int saveGameplay( const Gameplay_s* game, const char* path );
+/// @brief Recharge une partie sauvegardée par @ref saveGameplay
+int loadGameplay( Gameplay_s* game, const char* path );
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ * @file Spatial.c
+ * Grille uniforme servant à tester quels éléments d'une zone se trouvent sous
+ * la souris sans parcourir tous les éléments de la zone.
+ */
+#include "Spatial.h"
+#include "Metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * `cellOf` renvoie la colonne (ou la ligne) de la grille contenant la
+ * coordonnée `v`, ramenée dans les bornes de la grille.
+ */
+static int cellOf( int v, int origin, int size, int count )
+{
+	int c = ( v - origin ) / size;
+	if( v < origin || c < 0 )
+		return 0;
+	if( c >= count )
+		return count - 1;
+	return c;
+}
+
+/**
+ * `gridBuild` reconstruit la grille à partir des rectangles des `n`
+ * éléments de la zone. Les dimensions de la grille sont choisies pour qu'une
+ * cellule contienne en moyenne quelques éléments. Les éléments affichés en
+ * dernier étant au-dessus des autres, chaque cellule les range par indice
+ * décroissant : le premier candidat qui contient le point est le plus haut.
+ * Un rectangle est inscrit dans toutes les cellules qu'il chevauche, bords
+ * droit et bas compris, comme le fait @ref intersects.
+ * @param grid La grille à reconstruire
+ * @param rects Les rectangles des éléments, contigus
+ * @param n Le nombre d'éléments
+ */
+void gridBuild( Grid* grid, const Rect* rects, int n )
+{
+	int i;
+
+	grid->dirty = 0;
+	grid->nb_indices = 0;
+
+	if( n <= 0 )
+	{
+		grid->cols = grid->rows = 0;
+		return;
+	}
+
+	/* boîte englobante */
+	int x0 = rects->x, y0 = rects->y;
+	int x1 = rects->x + rects->w, y1 = rects->y + rects->h;
+
+	for( i = 1; i < n; i++ )
+	{
+		const Rect* r = &rects[ i ];
+		if( r->x < x0 ) x0 = r->x;
+		if( r->y < y0 ) y0 = r->y;
+		if( r->x + r->w > x1 ) x1 = r->x + r->w;
+		if( r->y + r->h > y1 ) y1 = r->y + r->h;
+	}
+
+	/* environ un élément par cellule */
+	int side = 1;
+	while( side * side < n && side < GRID_MAX_CELLS )
+		side++;
+
+	grid->x = x0;
+	grid->y = y0;
+	grid->cols = grid->rows = side;
+	grid->cell_w = ( x1 - x0 ) / side + 1;
+	grid->cell_h = ( y1 - y0 ) / side + 1;
+
+	int nb_cells = grid->cols * grid->rows;
+	if( grid->cap_cells < nb_cells + 1 )
+	{
+		grid->cap_cells = nb_cells + 1;
+		grid->cell_start = realloc( grid->cell_start, sizeof( int ) * grid->cap_cells );
+		grid->fill = realloc( grid->fill, sizeof( int ) * grid->cap_cells );
+		metricAdd( METRIC_HEAP_ALLOCS, 2 );
+	}
+	memset( grid->cell_start, 0, sizeof( int ) * ( nb_cells + 1 ) );
+
+	/* comptage des entrées de chaque cellule */
+	int total = 0;
+	for( i = 0; i < n; i++ )
+	{
+		const Rect* r = &rects[ i ];
+		int cx0 = cellOf( r->x, grid->x, grid->cell_w, grid->cols );
+		int cx1 = cellOf( r->x + r->w, grid->x, grid->cell_w, grid->cols );
+		int cy0 = cellOf( r->y, grid->y, grid->cell_h, grid->rows );
+		int cy1 = cellOf( r->y + r->h, grid->y, grid->cell_h, grid->rows );
+
+		int cx, cy;
+		for( cy = cy0; cy <= cy1; cy++ )
+			for( cx = cx0; cx <= cx1; cx++ )
+				grid->cell_start[ cy * grid->cols + cx + 1 ]++;
+
+		total += ( cx1 - cx0 + 1 ) * ( cy1 - cy0 + 1 );
+	}
+
+	for( i = 0; i < nb_cells; i++ )
+		grid->cell_start[ i + 1 ] += grid->cell_start[ i ];
+
+	if( grid->cap_indices < total )
+	{
+		grid->cap_indices = total;
+		grid->indices = realloc( grid->indices, sizeof( int ) * grid->cap_indices );
+		metricAdd( METRIC_HEAP_ALLOCS, 1 );
+	}
+
+	/* remplissage du dernier au premier élément : ordre d'affichage inversé */
+	int* fill = grid->fill;
+	memcpy( fill, grid->cell_start, sizeof( int ) * nb_cells );
+
+	for( i = n - 1; i >= 0; i-- )
+	{
+		const Rect* r = &rects[ i ];
+		int cx0 = cellOf( r->x, grid->x, grid->cell_w, grid->cols );
+		int cx1 = cellOf( r->x + r->w, grid->x, grid->cell_w, grid->cols );
+		int cy0 = cellOf( r->y, grid->y, grid->cell_h, grid->rows );
+		int cy1 = cellOf( r->y + r->h, grid->y, grid->cell_h, grid->rows );
+
+		int cx, cy;
+		for( cy = cy0; cy <= cy1; cy++ )
+			for( cx = cx0; cx <= cx1; cx++ )
+				grid->indices[ fill[ cy * grid->cols + cx ]++ ] = i;
+	}
+
+	grid->nb_indices = total;
+}
+
+/**
+ * `gridInvalidate` marque la grille comme obsolète, elle sera reconstruite
+ * lors de la prochaine recherche.
+ * @param grid La grille à invalider
+ */
+void gridInvalidate( Grid* grid )
+{
+	grid->dirty = 1;
+}
+
+/**
+ * `gridCell` donne les éléments pouvant contenir le point (`x`, `y`), du
+ * plus haut au plus bas dans l'ordre d'affichage. Les candidats doivent
+ * encore être testés avec @ref intersects.
+ * @param grid La grille à interroger
+ * @param x Position horizontale du point
+ * @param y Position verticale du point
+ * @param[out] candidates Pointe vers les indices des candidats
+ * @return Le nombre de candidats
+ */
+int gridCell( const Grid* grid, int x, int y, const int** candidates )
+{
+	*candidates = NULL;
+
+	if( grid->cols == 0 || grid->nb_indices == 0 )
+		return 0;
+
+	if( x < grid->x || y < grid->y
+		|| x >= grid->x + grid->cell_w * grid->cols
+		|| y >= grid->y + grid->cell_h * grid->rows )
+		return 0;
+
+	int cell = ( ( y - grid->y ) / grid->cell_h ) * grid->cols + ( x - grid->x ) / grid->cell_w;
+
+	*candidates = grid->indices + grid->cell_start[ cell ];
+	return grid->cell_start[ cell + 1 ] - grid->cell_start[ cell ];
+}
+
+/**
+ * `gridFree` libère la mémoire de la grille et la remet à zéro.
+ * @param grid La grille à libérer
+ */
+void gridFree( Grid* grid )
+{
+	free( grid->cell_start );
+	free( grid->indices );
+	free( grid->fill );
+	memset( grid, 0, sizeof( *grid ) );
+}
@@ -0,0 +1,54 @@
+/**
+ * @file Spatial.h
+ * @brief Index spatial (grille uniforme) des éléments d'une zone, utilisé
+ * pour retrouver rapidement l'élément situé sous la souris.
+ */
+#ifndef __SPATIAL_H__
+#define __SPATIAL_H__
+
+/**
+ * @struct Rect
+ * @brief Rectangle à coordonnées entières, de même disposition qu'un
+ * `SDL_Rect` mais utilisable sans la SDL
+ */
+typedef struct
+{
+	int x, y; ///< Coin supérieur gauche
+	int w, h; ///< Largeur et hauteur
+} Rect;
+
+/// Nombre maximal de cellules par ligne ou par colonne de la grille
+#define GRID_MAX_CELLS 64
+
+/**
+ * @struct Grid
+ * @brief Grille uniforme recouvrant la boîte englobante des éléments d'une
+ * zone. Chaque cellule référence les éléments qui la chevauchent, rangés du
+ * plus haut au plus bas dans l'ordre d'affichage.
+ */
+typedef struct
+{
+	int x, y; ///< Origine de la grille
+	int cell_w, cell_h; ///< Dimensions d'une cellule
+	int cols, rows; ///< Nombre de cellules en largeur et en hauteur
+
+	int* cell_start; ///< Début de chaque cellule dans `indices` (cols * rows + 1 entrées)
+	int* indices; ///< Indices des éléments, regroupés par cellule
+	int nb_indices; ///< Nombre d'entrées utilisées dans `indices`
+	int* fill; ///< Tampon de travail de @ref gridBuild (cols * rows entrées)
+
+	int cap_cells; ///< Taille allouée de `cell_start`
+	int cap_indices; ///< Taille allouée de `indices`
+	int dirty; ///< Non nul si la grille doit être reconstruite
+} Grid;
+
+/// @brief Reconstruit la grille à partir des rectangles de `n` éléments
+void gridBuild( Grid* grid, const Rect* rects, int n );
+/// @brief Marque la grille comme devant être reconstruite
+void gridInvalidate( Grid* grid );
+/// @brief Renvoie les candidats de la cellule contenant un point
+int gridCell( const Grid* grid, int x, int y, const int** candidates );
+/// @brief Libère la mémoire de la grille
+void gridFree( Grid* grid );
+
+#endif
@@ -0,0 +1,296 @@
+/**
+ * @file TaskGraph.c
+ * Graphe de tâches. Une tâche est ajoutée avec les tâches dont elle dépend,
+ * éventuellement par une tâche en cours : c'est ainsi qu'une tâche qui lit
+ * un catalogue ajoute une tâche par image qu'il nomme. Une tâche dont les
+ * dépendances ont fini entre dans la file des tâches prêtes, vidée par les
+ * fils du graphe dans l'ordre d'arrivée, et aussi par les fils qui attendent
+ * une tâche (@ref taskWait) : un graphe sans fil reste donc utilisable.
+ *
+ * Les tâches sont peu nombreuses et longues (lecture d'un fichier, décodage
+ * d'une image) : un seul verrou protège tout le graphe, et la fin d'une
+ * tâche parcourt toutes les tâches pour trouver celles qui l'attendaient.
+ */
+#include "TaskGraph.h"
+
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * `pushReady` met une tâche dans la file des tâches prêtes, et réveille un
+ * fil du graphe et les fils qui attendent une tâche pour l'exécuter. Le
+ * verrou doit être pris.
+ */
+static void pushReady( TaskGraph* graph, TaskId task )
+{
+	graph->ready[ graph->ready_tail++ ] = task;
+	pthread_cond_signal( &graph->ready_cond );
+	pthread_cond_broadcast( &graph->done_cond );
+}
+
+/// Prend la plus ancienne tâche prête, -1 s'il n'y en a pas ; le verrou doit être pris
+static TaskId popReady( TaskGraph* graph )
+{
+	if( graph->ready_head == graph->ready_tail )
+		return -1;
+	return graph->ready[ graph->ready_head++ ];
+}
+
+/**
+ * `runTask` exécute une tâche sans le verrou, puis la marque finie et rend
+ * prêtes les tâches qui n'attendaient plus qu'elle. Le verrou doit être
+ * pris, il l'est encore au retour.
+ */
+static void runTask( TaskGraph* graph, TaskId task )
+{
+	Task* t = &graph->tasks[ task ];
+	int i, d;
+
+	pthread_mutex_unlock( &graph->lock );
+	t->run( t->arg );
+	pthread_mutex_lock( &graph->lock );
+
+	t->done = 1;
+	graph->nb_done++;
+	for( i = 0; i < graph->nb_tasks; i++ )
+	{
+		Task* next = &graph->tasks[ i ];
+		for( d = 0; d < next->nb_deps && next->pending; d++ )
+		{
+			if( next->deps[ d ] == task && --next->pending == 0 )
+				pushReady( graph, i );
+		}
+	}
+	pthread_cond_broadcast( &graph->done_cond );
+}
+
+/// Fil du graphe : exécute les tâches prêtes jusqu'à l'arrêt
+static void* workerMain( void* arg )
+{
+	TaskGraph* graph = arg;
+
+	pthread_mutex_lock( &graph->lock );
+	for( ;; )
+	{
+		TaskId task = popReady( graph );
+		if( task >= 0 )
+			runTask( graph, task );
+		else if( graph->stopping )
+			break;
+		else
+			pthread_cond_wait( &graph->ready_cond, &graph->lock );
+	}
+	pthread_mutex_unlock( &graph->lock );
+	return NULL;
+}
+
+/**
+ * `taskGraphInit` prépare un graphe vide et lance ses fils, qui attendent
+ * des tâches.
+ * @param graph Le graphe à initialiser
+ * @param nb_threads Le nombre de fils, 0 pour un fil par cœur ; le graphe
+ * peut en avoir moins si un fil n'a pas pu être créé
+ */
+void taskGraphInit( TaskGraph* graph, int nb_threads )
+{
+	memset( graph, 0, sizeof( *graph ) );
+	pthread_mutex_init( &graph->lock, NULL );
+	pthread_cond_init( &graph->ready_cond, NULL );
+	pthread_cond_init( &graph->done_cond, NULL );
+
+	if( nb_threads <= 0 )
+		nb_threads = ( int )sysconf( _SC_NPROCESSORS_ONLN );
+	if( nb_threads <= 0 )
+		nb_threads = 1;
+	if( nb_threads > TASK_GRAPH_MAX_THREADS )
+		nb_threads = TASK_GRAPH_MAX_THREADS;
+
+	while( graph->nb_threads < nb_threads
+		&& pthread_create( &graph->threads[ graph->nb_threads ], NULL, workerMain, graph ) == 0 )
+		graph->nb_threads++;
+}
+
+/**
+ * `taskAdd` ajoute une tâche au graphe. Elle est lancée dès que les tâches
+ * `deps` ont fini, aussitôt si elles ont déjà fini. Elle peut être appelée
+ * par une tâche du graphe.
+ * @param graph Le graphe
+ * @param run Le travail de la tâche
+ * @param arg Le paramètre de `run`
+ * @param nb_deps Le nombre de dépendances, au plus @ref TASK_MAX_DEPS
+ * @param deps Les tâches à finir avant celle-ci ; les identifiants négatifs
+ * sont ignorés
+ * @return L'identifiant de la tâche, -1 si le graphe est plein : la tâche
+ * n'est alors pas exécutée
+ */
+TaskId taskAdd( TaskGraph* graph, void ( *run )( void* ), void* arg, int nb_deps, const TaskId* deps )
+{
+	int d;
+
+	if( nb_deps > TASK_MAX_DEPS )
+		return -1;
+
+	pthread_mutex_lock( &graph->lock );
+	if( graph->nb_tasks == TASK_GRAPH_MAX_TASKS )
+	{
+		pthread_mutex_unlock( &graph->lock );
+		return -1;
+	}
+
+	TaskId id = graph->nb_tasks++;
+	Task* task = &graph->tasks[ id ];
+	memset( task, 0, sizeof( *task ) );
+	task->run = run;
+	task->arg = arg;
+	for( d = 0; d < nb_deps; d++ )
+	{
+		if( deps[ d ] < 0 || deps[ d ] >= id || graph->tasks[ deps[ d ] ].done )
+			continue;
+		task->deps[ task->nb_deps++ ] = deps[ d ];
+		task->pending++;
+	}
+	if( !task->pending )
+		pushReady( graph, id );
+
+	pthread_mutex_unlock( &graph->lock );
+	return id;
+}
+
+/**
+ * `taskDone` indique si une tâche a fini.
+ * @param graph Le graphe
+ * @param task La tâche, un identifiant négatif désigne une tâche finie
+ * @return Non nul si la tâche a fini
+ */
+int taskDone( TaskGraph* graph, TaskId task )
+{
+	if( task < 0 )
+		return 1;
+
+	pthread_mutex_lock( &graph->lock );
+	int done = graph->tasks[ task ].done;
+	pthread_mutex_unlock( &graph->lock );
+	return done;
+}
+
+/**
+ * `taskGraphDone` indique si toutes les tâches ajoutées ont fini. Une tâche
+ * en cours pouvant en ajouter d'autres, le graphe n'a plus rien à faire
+ * quand elle renvoie une valeur non nulle.
+ * @param graph Le graphe
+ * @return Non nul si toutes les tâches ont fini
+ */
+int taskGraphDone( TaskGraph* graph )
+{
+	pthread_mutex_lock( &graph->lock );
+	int done = graph->nb_done == graph->nb_tasks;
+	pthread_mutex_unlock( &graph->lock );
+	return done;
+}
+
+/**
+ * `taskWait` attend la fin d'une tâche. Le fil qui attend exécute les
+ * tâches prêtes en attendant.
+ * @param graph Le graphe
+ * @param task La tâche à attendre, un identifiant négatif n'attend rien
+ */
+void taskWait( TaskGraph* graph, TaskId task )
+{
+	if( task < 0 )
+		return;
+
+	pthread_mutex_lock( &graph->lock );
+	while( !graph->tasks[ task ].done )
+	{
+		TaskId ready = popReady( graph );
+		if( ready >= 0 )
+			runTask( graph, ready );
+		else
+			pthread_cond_wait( &graph->done_cond, &graph->lock );
+	}
+	pthread_mutex_unlock( &graph->lock );
+}
+
+/**
+ * `taskJoin` attend la fin d'une tâche, sans exécuter les tâches prêtes :
+ * pour un fil qui ne doit attendre que celle-là, déjà lancée par un fil du
+ * graphe.
+ * @param graph Le graphe
+ * @param task La tâche à attendre, un identifiant négatif n'attend rien
+ */
+void taskJoin( TaskGraph* graph, TaskId task )
+{
+	if( task < 0 )
+		return;
+
+	pthread_mutex_lock( &graph->lock );
+	while( !graph->tasks[ task ].done )
+		pthread_cond_wait( &graph->done_cond, &graph->lock );
+	pthread_mutex_unlock( &graph->lock );
+}
+
+/**
+ * `taskGraphWait` attend la fin de toutes les tâches, y compris celles
+ * ajoutées en attendant. Le fil qui attend exécute les tâches prêtes en
+ * attendant.
+ * @param graph Le graphe
+ */
+void taskGraphWait( TaskGraph* graph )
+{
+	pthread_mutex_lock( &graph->lock );
+	while( graph->nb_done < graph->nb_tasks )
+	{
+		TaskId ready = popReady( graph );
+		if( ready >= 0 )
+			runTask( graph, ready );
+		else
+			pthread_cond_wait( &graph->done_cond, &graph->lock );
+	}
+	pthread_mutex_unlock( &graph->lock );
+}
+
+/**
+ * `taskGraphReset` vide un graphe dont toutes les tâches ont fini, pour
+ * qu'un graphe de longue durée puisse en recevoir sans fin. Les identifiants
+ * des tâches vidées ne doivent plus être utilisés.
+ * @param graph Le graphe
+ * @return 0 si le graphe a été vidé, -1 si des tâches ne sont pas finies
+ */
+int taskGraphReset( TaskGraph* graph )
+{
+	pthread_mutex_lock( &graph->lock );
+	int done = graph->nb_done == graph->nb_tasks;
+	if( done )
+	{
+		graph->nb_tasks = 0;
+		graph->nb_done = 0;
+		graph->ready_head = 0;
+		graph->ready_tail = 0;
+	}
+	pthread_mutex_unlock( &graph->lock );
+	return done ? 0 : -1;
+}
+
+/**
+ * `taskGraphDestroy` attend la fin de toutes les tâches, arrête les fils du
+ * graphe et libère ses ressources.
+ * @param graph Le graphe
+ */
+void taskGraphDestroy( TaskGraph* graph )
+{
+	int i;
+
+	taskGraphWait( graph );
+
+	pthread_mutex_lock( &graph->lock );
+	graph->stopping = 1;
+	pthread_cond_broadcast( &graph->ready_cond );
+	pthread_mutex_unlock( &graph->lock );
+
+	for( i = 0; i < graph->nb_threads; i++ )
+		pthread_join( graph->threads[ i ], NULL );
+
+	pthread_cond_destroy( &graph->ready_cond );
+	pthread_cond_destroy( &graph->done_cond );
+	pthread_mutex_destroy( &graph->lock );
+}
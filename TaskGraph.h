@@ -0,0 +1,74 @@
+/**
+ * @file TaskGraph.h
+ * @brief Graphe de tâches exécuté par un groupe de fils : une tâche est
+ * lancée dès que les tâches dont elle dépend ont fini.
+ */
+#ifndef __TASK_GRAPH_H__
+#define __TASK_GRAPH_H__
+
+#include <pthread.h>
+
+/// Nombre maximal de tâches d'un graphe
+#define TASK_GRAPH_MAX_TASKS 256
+/// Nombre maximal de fils d'un graphe
+#define TASK_GRAPH_MAX_THREADS 32
+/// Nombre maximal de dépendances d'une tâche
+#define TASK_MAX_DEPS 4
+
+/// Identifiant d'une tâche dans son graphe, -1 si la tâche n'a pas pu être ajoutée
+typedef int TaskId;
+
+/**
+ * @struct Task
+ * @brief Tâche d'un graphe et tâches dont elle dépend
+ */
+typedef struct
+{
+	void ( *run )( void* arg ); ///< Travail de la tâche
+	void* arg; ///< Paramètre de `run`
+	TaskId deps[TASK_MAX_DEPS]; ///< Tâches à finir avant celle-ci
+	int nb_deps; ///< Nombre de dépendances
+	int pending; ///< Nombre de dépendances pas encore finies
+	int done; ///< Non nul quand la tâche a fini
+} Task;
+
+/**
+ * @struct TaskGraph
+ * @brief Tâches, file des tâches prêtes et fils qui les exécutent
+ */
+typedef struct
+{
+	pthread_mutex_t lock; ///< Protège tous les champs suivants
+	pthread_cond_t ready_cond; ///< Signalé quand une tâche devient prête ou à l'arrêt
+	pthread_cond_t done_cond; ///< Signalé quand une tâche finit ou devient prête
+	Task tasks[TASK_GRAPH_MAX_TASKS]; ///< Tâches ajoutées
+	int nb_tasks; ///< Nombre de tâches ajoutées
+	int nb_done; ///< Nombre de tâches finies
+	TaskId ready[TASK_GRAPH_MAX_TASKS]; ///< Tâches prêtes, dans l'ordre où elles le sont devenues
+	int ready_head; ///< Position de la prochaine tâche prête à lancer
+	int ready_tail; ///< Position de la prochaine tâche prête à ajouter
+	int stopping; ///< Non nul quand les fils doivent s'arrêter
+	pthread_t threads[TASK_GRAPH_MAX_THREADS]; ///< Fils du graphe
+	int nb_threads; ///< Nombre de fils lancés
+} TaskGraph;
+
+/// @brief Prépare un graphe vide et lance ses fils
+void taskGraphInit( TaskGraph* graph, int nb_threads );
+/// @brief Ajoute une tâche, lancée quand ses dépendances ont fini
+TaskId taskAdd( TaskGraph* graph, void ( *run )( void* ), void* arg, int nb_deps, const TaskId* deps );
+/// @brief Indique si une tâche a fini
+int taskDone( TaskGraph* graph, TaskId task );
+/// @brief Indique si toutes les tâches ajoutées ont fini
+int taskGraphDone( TaskGraph* graph );
+/// @brief Attend la fin d'une tâche, en exécutant des tâches prêtes en attendant
+void taskWait( TaskGraph* graph, TaskId task );
+/// @brief Attend la fin d'une tâche déjà lancée, sans exécuter d'autre tâche
+void taskJoin( TaskGraph* graph, TaskId task );
+/// @brief Attend la fin de toutes les tâches, en exécutant des tâches prêtes en attendant
+void taskGraphWait( TaskGraph* graph );
+/// @brief Vide un graphe dont toutes les tâches ont fini
+int taskGraphReset( TaskGraph* graph );
+/// @brief Attend la fin des tâches, arrête les fils et libère le graphe
+void taskGraphDestroy( TaskGraph* graph );
+
+#endif
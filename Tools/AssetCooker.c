@@ -0,0 +1,121 @@
+/**
+ * @file AssetCooker.c
+ * Cuisson des images `cooker` : décode une fois pour toutes les images png
+ * d'un dossier et les range dans un paquet (voir @ref Pack.h) lu par
+ * `loadImage` à la place des png.\n
+ * Usage : `cooker Img Data/assets.pack`
+ */
+
+#include <dirent.h>
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Pack.h"
+
+/// Nombre maximal d'images cuites
+#define MAX_IMAGES 1024
+
+/**
+ * Format png des pixels du paquet : des entiers ARGB dans l'ordre des
+ * octets de la machine, soit B, G, R, A en mémoire sur une machine petit-boutiste.
+ */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PACK_PNG_FORMAT PNG_FORMAT_BGRA
+#else
+#define PACK_PNG_FORMAT PNG_FORMAT_ARGB
+#endif
+
+/// Ordre alphabétique des noms de fichiers
+static int compareNames( const void* a, const void* b )
+{
+	return strcmp( *( char* const* )a, *( char* const* )b );
+}
+
+/**
+ * `cookImage` décode un png et ajoute ses pixels au paquet.
+ * @return 0 en cas de succès, -1 sinon
+ */
+static int cookImage( PackWriter* writer, const char* dir, const char* file )
+{
+	char path[ 512 ], name[ PACK_NAME_SIZE ];
+	png_image image;
+
+	snprintf( path, sizeof( path ), "%s/%s", dir, file );
+	snprintf( name, sizeof( name ), "%.*s", ( int )( strlen( file ) - 4 ), file );
+
+	memset( &image, 0, sizeof( image ) );
+	image.version = PNG_IMAGE_VERSION;
+	if( !png_image_begin_read_from_file( &image, path ) )
+	{
+		fprintf( stderr, "%s : %s\n", path, image.message );
+		return -1;
+	}
+
+	image.format = PACK_PNG_FORMAT;
+	void* pixels = malloc( PNG_IMAGE_SIZE( image ) );
+	int ok = pixels && png_image_finish_read( &image, NULL, pixels, 0, NULL )
+		&& packWriterAdd( writer, name, image.width, image.height, pixels ) == 0;
+	if( !ok )
+		fprintf( stderr, "%s : %s\n", path, image.message[ 0 ] ? image.message : "cannot cook" );
+
+	png_image_free( &image );
+	free( pixels );
+	return ok ? 0 : -1;
+}
+
+int main( int argc, char* argv[] )
+{
+	if( argc != 3 )
+	{
+		fprintf( stderr, "usage : %s Img assets.pack\n", argv[ 0 ] );
+		return 2;
+	}
+
+	DIR* dir = opendir( argv[ 1 ] );
+	if( !dir )
+	{
+		fprintf( stderr, "%s : cannot open\n", argv[ 1 ] );
+		return 1;
+	}
+
+	/* les png du dossier, triés pour que le paquet soit reproductible */
+	char* files[ MAX_IMAGES ];
+	int nb_files = 0, i;
+	struct dirent* entry;
+	while( ( entry = readdir( dir ) ) && nb_files < MAX_IMAGES )
+	{
+		size_t length = strlen( entry->d_name );
+		if( length > 4 && length - 4 < PACK_NAME_SIZE && strcmp( entry->d_name + length - 4, ".png" ) == 0 )
+			files[ nb_files++ ] = strdup( entry->d_name );
+	}
+	closedir( dir );
+	qsort( files, nb_files, sizeof( *files ), compareNames );
+
+	PackWriter writer;
+	if( packWriterOpen( &writer, argv[ 2 ] ) != 0 )
+	{
+		fprintf( stderr, "%s : cannot create\n", argv[ 2 ] );
+		return 1;
+	}
+
+	int failed = 0;
+	for( i = 0; i < nb_files; i++ )
+	{
+		failed |= cookImage( &writer, argv[ 1 ], files[ i ] ) != 0;
+		free( files[ i ] );
+	}
+
+	uint64_t raw_size = writer.raw_size, packed_size = writer.offset;
+	if( packWriterClose( &writer ) != 0 || failed )
+	{
+		fprintf( stderr, "%s : write failed\n", argv[ 2 ] );
+		remove( argv[ 2 ] );
+		return 1;
+	}
+
+	printf( "%s : %d images, %.1f MB of pixels packed into %.1f MB\n", argv[ 2 ], nb_files,
+		raw_size / 1e6, packed_size / 1e6 );
+	return 0;
+}
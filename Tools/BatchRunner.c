@@ -0,0 +1,424 @@
+/**
+ * @file BatchRunner.c
+ * Simulateur `batch` : joue un grand nombre de parties sans interface sur
+ * tous les cœurs de la machine et affiche leurs statistiques (victoires,
+ * défaites, causes de fin, or, nombre de tours).\n
+ * La partie numéro `i` est jouée avec la graine `-s` et le flux `i` : un
+ * même lancement donne le même bilan, quel que soit le nombre de fils.\n
+ * Chaque fil joue ses parties dans sa propre @ref Gameplay_s ; les données
+ * partagées (objets, zones, fiches des NPC) sont préchargées une fois par
+ * @ref preloadGameData puis lues sans verrou. Les parties sont réparties par
+ * vol de travail : chaque fil tire ses parties au début de sa plage et un fil
+ * inoccupé vole la moitié haute de la plage d'un autre.\n
+ * Usage : `batch [-n parties] [-t fils] [-s graine] [-m tours]
+ * [-p random|aggressive|script:fichier] [-v]`\n
+ * Les messages que le cœur du jeu affiche sur la sortie standard sont
+ * supprimés, sauf avec `-v` ; le bilan est toujours affiché, suivi avec
+ * `-v` du relevé des mesures du jeu (voir @ref metricsWrite).\n
+ * Un script contient une entrée par ligne (`start`, `element N`, `action N`
+ * ou `slot N`) ; une entrée impossible dans l'état courant est remplacée par
+ * une entrée au hasard.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Gameplay.h"
+#include "Log.h"
+#include "Metrics.h"
+
+/// Nombre maximal de fils
+#define MAX_THREADS 256
+/// Nombre maximal d'entrées possibles examinées à chaque tour
+#define MAX_INPUTS 1024
+
+/// Politique de jeu
+enum
+{
+	POLICY_RANDOM, ///< Une entrée possible au hasard
+	POLICY_AGGRESSIVE, ///< Attaque dès que possible, sinon au hasard
+	POLICY_SCRIPT ///< Suit un script, au hasard quand il est impossible
+};
+
+/**
+ * @struct Stats
+ * @brief Statistiques cumulées d'un ensemble de parties
+ */
+typedef struct
+{
+	long sessions; ///< Nombre de parties jouées
+	long won, lost, timeout; ///< Issue des parties
+	long causes[ NB_END_CAUSES ]; ///< Nombre de parties par cause de fin
+	long killers[ 1024 ]; ///< Morts du joueur par type de NPC
+	long killers_other; ///< Morts du joueur par un NPC de type >= 1024
+	long long gold; ///< Somme de l'or en fin de partie
+	long long turns; ///< Somme des tours joués
+} Stats;
+
+/**
+ * @struct Worker
+ * @brief Fil de simulation et sa plage de parties restant à jouer
+ */
+typedef struct
+{
+	pthread_t thread;
+	int id;
+
+	pthread_mutex_t lock; ///< Protège `begin` et `end`
+	long begin, end; ///< Parties restantes : [begin, end)
+	long stolen; ///< Nombre de vols réussis
+
+	Stats stats;
+	char pad[ 64 ]; ///< Sépare les plages de fils voisins
+} Worker;
+
+/// Paramètres de la simulation, partagés en lecture seule
+static struct
+{
+	long sessions;
+	int threads;
+	uint64_t seed;
+	int max_turns;
+	int policy;
+	Input* script;
+	int script_size;
+} Config = { 10000, 0, 42, 1000, POLICY_RANDOM, NULL, 0 };
+
+static Worker Workers[ MAX_THREADS ];
+
+/**
+ * `nextSession` donne au fil `self` la prochaine partie à jouer : la première
+ * de sa plage, ou sinon la première d'une moitié de plage volée à un autre
+ * fil.
+ * @return L'identifiant de la partie, ou -1 s'il n'en reste plus
+ */
+static long nextSession( Worker* self )
+{
+	long session = -1;
+
+	pthread_mutex_lock( &self->lock );
+	if( self->begin < self->end )
+		session = self->begin++;
+	pthread_mutex_unlock( &self->lock );
+
+	if( session != -1 )
+		return session;
+
+	int k;
+	for( k = 1; k < Config.threads; k++ )
+	{
+		Worker* victim = &Workers[ ( self->id + k ) % Config.threads ];
+		long begin = 0, end = 0;
+
+		pthread_mutex_lock( &victim->lock );
+		if( victim->end - victim->begin >= 2 )
+		{
+			begin = victim->begin + ( victim->end - victim->begin ) / 2;
+			end = victim->end;
+			victim->end = begin;
+		}
+		else if( victim->end - victim->begin == 1 )
+		{
+			begin = victim->begin++;
+			end = begin + 1;
+		}
+		pthread_mutex_unlock( &victim->lock );
+
+		if( begin < end )
+		{
+			pthread_mutex_lock( &self->lock );
+			self->begin = begin + 1;
+			self->end = end;
+			self->stolen++;
+			pthread_mutex_unlock( &self->lock );
+			return begin;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * `chooseInput` choisit l'entrée à jouer parmi les `n` entrées possibles
+ * selon la politique de la simulation.
+ */
+static Input chooseInput( const Input* inputs, int n, int turn, Rng* rng )
+{
+	int i;
+
+	if( Config.policy == POLICY_AGGRESSIVE )
+	{
+		for( i = 0; i < n; i++ )
+			if( inputs[ i ].kind == INPUT_ACTION && inputs[ i ].value == ACTION_ATTACK )
+				return inputs[ i ];
+	}
+	else if( Config.policy == POLICY_SCRIPT && turn < Config.script_size )
+	{
+		Input wanted = Config.script[ turn ];
+		for( i = 0; i < n; i++ )
+			if( inputs[ i ].kind == wanted.kind && inputs[ i ].value == wanted.value )
+				return wanted;
+	}
+
+	return inputs[ rngBelow( rng, n ) ];
+}
+
+/**
+ * `playSession` joue la partie `session` dans `game` jusqu'à sa fin ou
+ * jusqu'à `Config.max_turns` tours, puis ajoute son issue à `stats`.
+ */
+static void playSession( Gameplay_s* game, long session, Stats* stats )
+{
+	Input inputs[ MAX_INPUTS ];
+	Rng policy;
+	int turn;
+
+	/* la partie et le joueur simulé tirent dans deux flux séparés */
+	seedGameplay( game, Config.seed, session );
+	rngSplit( &game->rng, &policy );
+	initGameplay( game );
+
+	for( turn = 0; turn < Config.max_turns; turn++ )
+	{
+		int n = listInputs( game, inputs, MAX_INPUTS );
+		if( n == 0 )
+			break;
+
+		applyInput( game, chooseInput( inputs, n, turn, &policy ) );
+	}
+
+	stats->sessions++;
+	stats->turns += turn;
+	stats->gold += game->inventory.gold;
+
+	if( game->state == STATE_WON )
+		stats->won++;
+	else if( game->state == STATE_LOST )
+		stats->lost++;
+	else
+		stats->timeout++;
+
+	stats->causes[ game->end_cause ]++;
+
+	if( game->end_cause == END_KILLED )
+	{
+		unsigned type = game->npcs[ game->index_current_npc ].type;
+		if( type < 1024 )
+			stats->killers[ type ]++;
+		else
+			stats->killers_other++;
+	}
+}
+
+/// Corps d'un fil de simulation
+static void* workerMain( void* arg )
+{
+	Worker* self = arg;
+	Gameplay_s* game = createGameplay();
+	long session;
+
+	while( ( session = nextSession( self ) ) != -1 )
+		playSession( game, session, &self->stats );
+
+	destroyGameplay( game );
+	return NULL;
+}
+
+/// Ajoute les statistiques `src` à `dst`
+static void mergeStats( Stats* dst, const Stats* src )
+{
+	int i;
+
+	dst->sessions += src->sessions;
+	dst->won += src->won;
+	dst->lost += src->lost;
+	dst->timeout += src->timeout;
+	for( i = 0; i < NB_END_CAUSES; i++ )
+		dst->causes[ i ] += src->causes[ i ];
+	for( i = 0; i < 1024; i++ )
+		dst->killers[ i ] += src->killers[ i ];
+	dst->killers_other += src->killers_other;
+	dst->gold += src->gold;
+	dst->turns += src->turns;
+}
+
+/**
+ * `loadScript` lit le script de la politique `script:fichier`.
+ * @return 0 si le script a été lu, -1 sinon
+ */
+static int loadScript( const char* path )
+{
+	FILE* file = fopen( path, "r" );
+	char kind[ 16 ];
+	int value, cap = 0;
+
+	if( !file )
+		return -1;
+
+	while( fscanf( file, "%15s", kind ) == 1 )
+	{
+		Input input = { INPUT_START, 0 };
+
+		if( strcmp( kind, "start" ) != 0 )
+		{
+			if( fscanf( file, "%d", &value ) != 1 )
+				break;
+
+			if( strcmp( kind, "element" ) == 0 )
+				input.kind = INPUT_ELEMENT;
+			else if( strcmp( kind, "action" ) == 0 )
+				input.kind = INPUT_ACTION;
+			else if( strcmp( kind, "slot" ) == 0 )
+				input.kind = INPUT_SLOT;
+			else
+				break;
+			input.value = value;
+		}
+
+		if( Config.script_size == cap )
+		{
+			cap = cap ? cap * 2 : 64;
+			Config.script = realloc( Config.script, sizeof( Input ) * cap );
+		}
+		Config.script[ Config.script_size++ ] = input;
+	}
+
+	fclose( file );
+	return 0;
+}
+
+static const char* CauseNames[ NB_END_CAUSES ] = {
+	[ END_NONE ] = "none",
+	[ END_KILLED ] = "killed",
+	[ END_PRINCE_KILLED ] = "prince killed",
+	[ END_APPLE ] = "apple",
+	[ END_DUKE_KILLED ] = "duke killed",
+	[ END_DUKE_POISONED ] = "duke poisoned"
+};
+
+int main( int argc, char* argv[] )
+{
+	int opt, i, verbose = 0;
+
+	while( ( opt = getopt( argc, argv, "n:t:s:m:p:v" ) ) != -1 )
+	{
+		switch( opt )
+		{
+		case 'n': Config.sessions = atol( optarg ); break;
+		case 't': Config.threads = atoi( optarg ); break;
+		case 's': Config.seed = strtoull( optarg, NULL, 10 ); break;
+		case 'm': Config.max_turns = atoi( optarg ); break;
+		case 'v': verbose = 1; break;
+		case 'p':
+			if( strcmp( optarg, "random" ) == 0 )
+				Config.policy = POLICY_RANDOM;
+			else if( strcmp( optarg, "aggressive" ) == 0 )
+				Config.policy = POLICY_AGGRESSIVE;
+			else if( strncmp( optarg, "script:", 7 ) == 0 && loadScript( optarg + 7 ) == 0 )
+				Config.policy = POLICY_SCRIPT;
+			else
+			{
+				fprintf( stderr, "%s : invalid policy\n", optarg );
+				return 2;
+			}
+			break;
+		default:
+			fprintf( stderr, "usage : %s [-n sessions] [-t threads] [-s seed] [-m max_turns]"
+				" [-p random|aggressive|script:file] [-v]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	if( Config.threads <= 0 )
+		Config.threads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+	if( Config.threads <= 0 )
+		Config.threads = 1;
+	if( Config.threads > MAX_THREADS )
+		Config.threads = MAX_THREADS;
+
+	/* le bilan garde la sortie standard, les messages des parties sont perdus */
+	FILE* report = stdout;
+	if( !verbose )
+	{
+		fflush( stdout );
+		report = fdopen( dup( fileno( stdout ) ), "w" );
+		if( !report || !freopen( "/dev/null", "w", stdout ) )
+		{
+			perror( "stdout" );
+			return 1;
+		}
+	}
+
+	/* seules les erreurs du jeu sont journalisées, sauf avec -v */
+	logInit( stderr, verbose ? LOG_INFO : LOG_ERROR );
+	preloadGameData();
+
+	/* plages initiales égales, le vol de travail corrige les écarts */
+	for( i = 0; i < Config.threads; i++ )
+	{
+		Workers[ i ].id = i;
+		Workers[ i ].begin = Config.sessions * i / Config.threads;
+		Workers[ i ].end = Config.sessions * ( i + 1 ) / Config.threads;
+		pthread_mutex_init( &Workers[ i ].lock, NULL );
+	}
+
+	struct timespec start, stop;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for( i = 0; i < Config.threads; i++ )
+		pthread_create( &Workers[ i ].thread, NULL, workerMain, &Workers[ i ] );
+
+	Stats total;
+	long stolen = 0;
+	memset( &total, 0, sizeof( total ) );
+
+	for( i = 0; i < Config.threads; i++ )
+	{
+		pthread_join( Workers[ i ].thread, NULL );
+		mergeStats( &total, &Workers[ i ].stats );
+		stolen += Workers[ i ].stolen;
+	}
+
+	/* un fil peut encore voler un fil déjà rejoint : verrous détruits à la fin */
+	for( i = 0; i < Config.threads; i++ )
+		pthread_mutex_destroy( &Workers[ i ].lock );
+
+	clock_gettime( CLOCK_MONOTONIC, &stop );
+	double seconds = ( stop.tv_sec - start.tv_sec ) + ( stop.tv_nsec - start.tv_nsec ) * 1e-9;
+
+	long n = total.sessions ? total.sessions : 1;
+
+	fprintf( report, "sessions   %ld on %d threads in %.3f s (%.0f sessions/s, %ld steals)\n",
+		total.sessions, Config.threads, seconds, total.sessions / seconds, stolen );
+	fprintf( report, "won        %ld (%.1f%%)\n", total.won, 100.0 * total.won / n );
+	fprintf( report, "lost       %ld (%.1f%%)\n", total.lost, 100.0 * total.lost / n );
+	fprintf( report, "timeout    %ld (%.1f%%)\n", total.timeout, 100.0 * total.timeout / n );
+	fprintf( report, "mean gold  %.1f\n", (double) total.gold / n );
+	fprintf( report, "mean turns %.1f\n", (double) total.turns / n );
+
+	fprintf( report, "end causes\n" );
+	for( i = 0; i < NB_END_CAUSES; i++ )
+		if( total.causes[ i ] )
+			fprintf( report, "  %-14s %ld\n", CauseNames[ i ], total.causes[ i ] );
+
+	fprintf( report, "killed by npc type\n" );
+	for( i = 0; i < 1024; i++ )
+		if( total.killers[ i ] )
+			fprintf( report, "  %-14d %ld\n", i, total.killers[ i ] );
+	if( total.killers_other )
+		fprintf( report, "  %-14s %ld\n", ">= 1024", total.killers_other );
+
+	if( verbose )
+		metricsWrite( report, seconds );
+
+	closeGameData();
+	logShutdown();
+	free( Config.script );
+	fclose( report );
+	return 0;
+}
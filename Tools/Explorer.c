@@ -0,0 +1,641 @@
+/**
+ * @file Explorer.c
+ * Explorateur `explore` : parcourt en largeur tous les états atteignables
+ * d'une partie en essayant toutes les entrées possibles (@ref listInputs)
+ * et affiche les fins de partie atteignables, la victoire la plus courte et
+ * les impasses (états d'où aucune fin de partie n'est atteignable). Quand
+ * le parcours est tronqué (`-n`) ou limité en profondeur (`-d`), l'absence
+ * de victoire et le nombre d'impasses sont signalés comme partiels.\n
+ * Les états sont identifiés par une empreinte de Zobrist : chaque champ de
+ * l'état de jeu, et chaque NPC rencontré, contribue une clé pseudo-aléatoire
+ * combinée par ou exclusif. L'ordre de rencontre des NPC ne compte donc pas.
+ * Les dialogues affichés et l'état du générateur pseudo-aléatoire ne font
+ * pas partie de l'empreinte : un état rencontré par deux chemins n'est
+ * développé qu'une fois, avec les tirages du premier chemin qui l'atteint.\n
+ * Chaque niveau du parcours est réparti entre les fils ; les états déjà vus
+ * sont écartés par une table de transposition sans verrou partagée par tous
+ * les fils. Les états eux-mêmes sont conservés sous forme d'instantanés
+ * (@ref snapshotGameplay).\n
+ * Usage : `explore [-t fils] [-s graine] [-n états] [-d profondeur]
+ * [-l sauvegarde]`
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Gameplay.h"
+#include "Log.h"
+#include "Snapshot.h"
+
+/// Nombre maximal de fils
+#define MAX_THREADS 256
+/// Nombre maximal d'entrées possibles dans un état
+#define MAX_INPUTS 1024
+
+/**
+ * @struct Node
+ * @brief État atteint par le parcours
+ */
+typedef struct
+{
+	uint32_t parent; ///< État précédent sur le plus court chemin
+	Input input; ///< Entrée menant de `parent` à cet état
+	int depth; ///< Longueur du plus court chemin
+	int state; ///< État de jeu (`STATE_*`)
+	int end_cause; ///< Fin de la partie (`END_*`)
+	int expanded; ///< Non nul si les successeurs ont été calculés
+	unsigned char* snap; ///< Instantané de la partie
+	size_t snap_size; ///< Taille de l'instantané
+} Node;
+
+/**
+ * @struct Edge
+ * @brief Transition entre deux états, conservée pour la recherche des
+ * impasses
+ */
+typedef struct
+{
+	uint32_t from; ///< État de départ
+	uint64_t to; ///< Empreinte de l'état d'arrivée
+} Edge;
+
+/**
+ * @struct Worker
+ * @brief Fil d'exploration et transitions qu'il a trouvées
+ */
+typedef struct
+{
+	pthread_t thread;
+	Gameplay_s* game; ///< Partie de travail
+	Edge* edges; ///< Transitions trouvées
+	long nb_edges, cap_edges;
+	long expanded; ///< Nombre d'états développés
+} Worker;
+
+/// Paramètres de l'exploration
+static struct
+{
+	int threads;
+	uint64_t seed;
+	long max_nodes;
+	int max_depth;
+	const char* load;
+} Config = { 0, 42, 500000, 200, NULL };
+
+/// États atteints, dans l'ordre du parcours
+static Node* Nodes;
+/// Nombre d'états atteints
+static atomic_long NbNodes;
+/// Non nul si `Config.max_nodes` a été atteint
+static atomic_int Truncated;
+
+/// Table de transposition : empreintes (0 pour une case vide) et états
+static _Atomic uint64_t* TableKeys;
+static uint32_t* TableNodes;
+static uint64_t TableMask;
+
+/// Niveau en cours de développement : états [LevelBegin, LevelEnd[
+static long LevelBegin, LevelEnd;
+/// Prochain état du niveau à développer
+static atomic_long LevelNext;
+
+static Worker Workers[ MAX_THREADS ];
+
+/**
+ * `mix64` brasse un entier 64 bits (finaliseur de splitmix64). Les clés de
+ * Zobrist sont calculées à la demande plutôt que tirées dans une table, les
+ * champs pouvant prendre de nombreuses valeurs.
+ */
+static uint64_t mix64( uint64_t z )
+{
+	z += 0x9e3779b97f4a7c15ULL;
+	z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+	z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+	return z ^ ( z >> 31 );
+}
+
+/// Clé de Zobrist du champ `field` valant `value`
+static uint64_t zobrist( uint64_t field, int64_t value )
+{
+	return mix64( ( field << 40 ) ^ ( uint64_t )value );
+}
+
+/**
+ * `hashGame` calcule l'empreinte canonique de la partie `game`.
+ */
+static uint64_t hashGame( const Gameplay_s* game )
+{
+	uint64_t h = 0;
+	uint64_t f = 0;
+	int i;
+
+	h ^= zobrist( f++, game->state );
+	h ^= zobrist( f++, game->old_state );
+	h ^= zobrist( f++, game->end_cause );
+	h ^= zobrist( f++, game->area );
+	h ^= zobrist( f++, game->no_leave );
+	h ^= zobrist( f++, game->interaction_index );
+	h ^= zobrist( f++, game->player_max_life );
+	h ^= zobrist( f++, game->player_current_life );
+	h ^= zobrist( f++, game->player_atk );
+	h ^= zobrist( f++, game->player_def );
+	h ^= zobrist( f++, game->inventory.gold );
+	h ^= zobrist( f++, game->inventory.equipment[ 0 ] );
+	h ^= zobrist( f++, game->inventory.equipment[ 1 ] );
+	h ^= zobrist( f++, game->stuff[ 0 ] );
+	h ^= zobrist( f++, game->stuff[ 1 ] );
+	h ^= zobrist( f++, game->selected_item );
+	h ^= zobrist( f++, game->index_selected_item );
+
+	for( i = 0; i < MAX_ITEM; i++ )
+		h ^= zobrist( f++, game->inventory.items[ i ] );
+
+	const unsigned char* data = &game->npc_data[ 0 ][ 0 ];
+	for( i = 0; i < ( int )sizeof( game->npc_data ); i++ )
+		h ^= zobrist( f++, data[ i ] );
+
+	/* NPC actif repéré par son identifiant, pas par son rang de rencontre */
+	if( game->index_current_npc >= 0 && game->index_current_npc < game->nb_npc )
+		h ^= zobrist( f, game->npcs[ game->index_current_npc ].unique_id );
+	f++;
+
+	/* NPC rencontrés : ensemble, indépendant de l'ordre */
+	for( i = 0; i < game->nb_npc; i++ )
+	{
+		const npc_stats* npc = &game->npcs[ i ];
+		uint64_t k = mix64( ( ( uint64_t )( uint32_t )npc->unique_id << 32 ) | npc->type );
+		k = mix64( k ^ ( ( uint64_t )( uint32_t )npc->life << 32 ) ^ ( uint32_t )npc->status );
+		h ^= mix64( k ^ f );
+	}
+
+	return h ? h : 1;
+}
+
+/**
+ * `tableInsert` ajoute l'empreinte `key` à la table de transposition.
+ * @param key L'empreinte, non nulle
+ * @param node L'état associé si l'empreinte est nouvelle
+ * @return 1 si l'empreinte est nouvelle, 0 si elle était déjà présente
+ */
+static int tableInsert( uint64_t key, uint32_t node )
+{
+	uint64_t i = key & TableMask;
+
+	for( ;; )
+	{
+		uint64_t current = atomic_load_explicit( &TableKeys[ i ], memory_order_acquire );
+		if( current == key )
+			return 0;
+		if( current == 0 )
+		{
+			uint64_t expected = 0;
+			if( atomic_compare_exchange_strong( &TableKeys[ i ], &expected, key ) )
+			{
+				TableNodes[ i ] = node;
+				return 1;
+			}
+			if( expected == key )
+				return 0;
+		}
+		i = ( i + 1 ) & TableMask;
+	}
+}
+
+/**
+ * `tableFind` renvoie l'état associé à l'empreinte `key`, une fois le
+ * parcours terminé.
+ * @return L'état, ou -1 si l'empreinte est absente
+ */
+static long tableFind( uint64_t key )
+{
+	uint64_t i = key & TableMask;
+
+	for( ;; )
+	{
+		uint64_t current = atomic_load_explicit( &TableKeys[ i ], memory_order_relaxed );
+		if( current == key )
+			return TableNodes[ i ];
+		if( current == 0 )
+			return -1;
+		i = ( i + 1 ) & TableMask;
+	}
+}
+
+/**
+ * `addNode` enregistre un nouvel état atteint depuis `parent` par `input`.
+ * @return 0 en cas de succès, -1 si le nombre maximal d'états est atteint
+ */
+static int addNode( const Gameplay_s* game, uint64_t key, uint32_t parent, Input input, int depth )
+{
+	long id = atomic_fetch_add( &NbNodes, 1 );
+	if( id >= Config.max_nodes )
+	{
+		atomic_store( &Truncated, 1 );
+		return -1;
+	}
+
+	Node* node = &Nodes[ id ];
+	node->parent = parent;
+	node->input = input;
+	node->depth = depth;
+	node->state = game->state;
+	node->end_cause = game->end_cause;
+	node->expanded = 0;
+	node->snap_size = snapshotSize( game );
+	node->snap = malloc( node->snap_size );
+	snapshotGameplay( game, node->snap, node->snap_size );
+
+	if( !tableInsert( key, id ) )
+	{
+		/* un autre fil a ajouté le même état entre-temps : emplacement perdu */
+		node->state = -1;
+	}
+	return 0;
+}
+
+/// Ajoute une transition aux transitions du fil `self`
+static void addEdge( Worker* self, uint32_t from, uint64_t to )
+{
+	if( self->nb_edges == self->cap_edges )
+	{
+		self->cap_edges = self->cap_edges ? self->cap_edges * 2 : 4096;
+		self->edges = realloc( self->edges, sizeof( Edge ) * self->cap_edges );
+	}
+	self->edges[ self->nb_edges ].from = from;
+	self->edges[ self->nb_edges ].to = to;
+	self->nb_edges++;
+}
+
+/// Indique si l'empreinte `key` est déjà dans la table, pendant le parcours
+static int tableContains( uint64_t key )
+{
+	uint64_t i = key & TableMask;
+
+	for( ;; )
+	{
+		uint64_t current = atomic_load_explicit( &TableKeys[ i ], memory_order_acquire );
+		if( current == key )
+			return 1;
+		if( current == 0 )
+			return 0;
+		i = ( i + 1 ) & TableMask;
+	}
+}
+
+/**
+ * `expand` calcule les successeurs de l'état `id`. Un état dont
+ * l'instantané ne peut pas être restauré n'est pas développé : le bilan le
+ * compte parmi les états dont on ne sait rien.
+ */
+static void expand( Worker* self, long id )
+{
+	Input inputs[ MAX_INPUTS ];
+	Gameplay_s* game = self->game;
+	const Node* node = &Nodes[ id ];
+
+	if( restoreGameplay( game, node->snap, node->snap_size ) != 0 )
+	{
+		logError( "state %ld: invalid snapshot, not expanded", id );
+		return;
+	}
+	int n = listInputs( game, inputs, MAX_INPUTS );
+	int i;
+
+	for( i = 0; i < n; i++ )
+	{
+		/* l'instantané a déjà été restauré une fois : il est valide */
+		if( i > 0 )
+			restoreGameplay( game, node->snap, node->snap_size );
+		applyInput( game, inputs[ i ] );
+
+		uint64_t key = hashGame( game );
+		addEdge( self, id, key );
+
+		if( !tableContains( key ) && !atomic_load( &Truncated ) )
+			addNode( game, key, id, inputs[ i ], node->depth + 1 );
+	}
+
+	Nodes[ id ].expanded = 1;
+	self->expanded++;
+}
+
+/// Corps d'un fil : développe les états du niveau courant
+static void* workerMain( void* arg )
+{
+	Worker* self = arg;
+	long id;
+
+	while( ( id = atomic_fetch_add( &LevelNext, 1 ) ) < LevelEnd )
+	{
+		if( Nodes[ id ].state < 0 || Nodes[ id ].state == STATE_WON || Nodes[ id ].state == STATE_LOST )
+			continue;
+		expand( self, id );
+	}
+	return NULL;
+}
+
+/// Affiche dans `out` le chemin d'entrées menant à l'état `id`
+static void printPath( FILE* out, long id )
+{
+	static const char* Kinds[] = { "start", "element", "action", "slot" };
+	long path[ 4096 ];
+	int n = 0;
+
+	while( id != 0 && n < 4096 )
+	{
+		path[ n++ ] = id;
+		id = Nodes[ id ].parent;
+	}
+
+	fprintf( out, "   " );
+	while( n-- > 0 )
+	{
+		const Input* in = &Nodes[ path[ n ] ].input;
+		if( in->kind == INPUT_START )
+			fprintf( out, " start" );
+		else
+			fprintf( out, " %s %d", Kinds[ in->kind ], in->value );
+	}
+	fprintf( out, "\n" );
+}
+
+/// @brief Renvoie le temps écoulé en secondes depuis une origine arbitraire
+static double now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main( int argc, char* argv[] )
+{
+	int opt, i;
+
+	while( ( opt = getopt( argc, argv, "t:s:n:d:l:" ) ) != -1 )
+	{
+		switch( opt )
+		{
+		case 't': Config.threads = atoi( optarg ); break;
+		case 's': Config.seed = strtoull( optarg, NULL, 10 ); break;
+		case 'n': Config.max_nodes = atol( optarg ); break;
+		case 'd': Config.max_depth = atoi( optarg ); break;
+		case 'l': Config.load = optarg; break;
+		default:
+			fprintf( stderr, "usage : %s [-t threads] [-s seed] [-n max_states] [-d max_depth] [-l save]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	if( Config.threads <= 0 )
+		Config.threads = ( int )sysconf( _SC_NPROCESSORS_ONLN );
+	if( Config.threads <= 0 )
+		Config.threads = 1;
+	if( Config.threads > MAX_THREADS )
+		Config.threads = MAX_THREADS;
+
+	/* les messages des parties vont sur la sortie d'erreur, le bilan reste lisible */
+	fflush( stdout );
+	FILE* report = fdopen( dup( fileno( stdout ) ), "w" );
+	if( !report || !freopen( "/dev/null", "w", stdout ) )
+	{
+		perror( "stdout" );
+		return 1;
+	}
+
+	logInit( stderr, LOG_ERROR );
+	preloadGameData();
+
+	uint64_t table_size = 1;
+	while( table_size < ( uint64_t )Config.max_nodes * 2 )
+		table_size <<= 1;
+	TableMask = table_size - 1;
+	TableKeys = calloc( table_size, sizeof( *TableKeys ) );
+	TableNodes = calloc( table_size, sizeof( *TableNodes ) );
+	Nodes = calloc( Config.max_nodes, sizeof( Node ) );
+
+	for( i = 0; i < Config.threads; i++ )
+		Workers[ i ].game = createGameplay();
+
+	/* état de départ */
+	Gameplay_s* root = Workers[ 0 ].game;
+	seedGameplay( root, Config.seed, 0 );
+	initGameplay( root );
+	if( Config.load && loadGameplay( root, Config.load ) != 0 )
+	{
+		fprintf( stderr, "%s : invalid save\n", Config.load );
+		return 1;
+	}
+
+	Input none = { INPUT_START, 0 };
+	addNode( root, hashGame( root ), 0, none, 0 );
+
+	double start = now();
+	int depth = 0;
+	LevelBegin = 0;
+
+	for( ;; )
+	{
+		LevelEnd = atomic_load( &NbNodes );
+		if( LevelEnd > Config.max_nodes )
+			LevelEnd = Config.max_nodes;
+		if( LevelBegin >= LevelEnd || depth >= Config.max_depth )
+			break;
+
+		atomic_store( &LevelNext, LevelBegin );
+
+		for( i = 0; i < Config.threads; i++ )
+			pthread_create( &Workers[ i ].thread, NULL, workerMain, &Workers[ i ] );
+		for( i = 0; i < Config.threads; i++ )
+			pthread_join( Workers[ i ].thread, NULL );
+
+		LevelBegin = LevelEnd;
+		depth++;
+	}
+
+	double seconds = now() - start;
+	long nb_nodes = atomic_load( &NbNodes );
+	if( nb_nodes > Config.max_nodes )
+		nb_nodes = Config.max_nodes;
+
+	/* bilan des états atteints */
+	long expanded = 0, nb_edges = 0, unique = 0, unexplored = 0;
+	long causes[ NB_END_CAUSES ] = { 0 };
+	long shortest_win = -1;
+
+	for( i = 0; i < Config.threads; i++ )
+	{
+		expanded += Workers[ i ].expanded;
+		nb_edges += Workers[ i ].nb_edges;
+	}
+
+	long id;
+	for( id = 0; id < nb_nodes; id++ )
+	{
+		const Node* node = &Nodes[ id ];
+		if( node->state < 0 )
+			continue;
+		unique++;
+		if( node->state == STATE_WON || node->state == STATE_LOST )
+			causes[ node->end_cause ]++;
+		else if( !node->expanded )
+			unexplored++;
+		if( node->state == STATE_WON && ( shortest_win < 0 || node->depth < Nodes[ shortest_win ].depth ) )
+			shortest_win = id;
+	}
+
+	/*
+	 * impasses : états d'où aucune fin de partie n'est atteignable. Parcours
+	 * arrière depuis les fins de partie et les états non développés (dont on
+	 * ne sait rien) le long des transitions inversées.
+	 */
+	long* rev_start = calloc( nb_nodes + 1, sizeof( long ) );
+	char* alive = calloc( nb_nodes + 1, 1 );
+	uint32_t* rev = malloc( sizeof( uint32_t ) * ( nb_edges + 1 ) );
+	long* targets = malloc( sizeof( long ) * ( nb_edges + 1 ) );
+	long e = 0;
+
+	for( i = 0; i < Config.threads; i++ )
+	{
+		long k;
+		for( k = 0; k < Workers[ i ].nb_edges; k++, e++ )
+		{
+			targets[ e ] = tableFind( Workers[ i ].edges[ k ].to );
+			if( targets[ e ] >= 0 )
+				rev_start[ targets[ e ] + 1 ]++;
+			else /* successeur écarté faute de place : on ne sait rien */
+				alive[ Workers[ i ].edges[ k ].from ] = 1;
+		}
+	}
+	for( id = 0; id < nb_nodes; id++ )
+		rev_start[ id + 1 ] += rev_start[ id ];
+
+	long* fill = malloc( sizeof( long ) * ( nb_nodes + 1 ) );
+	memcpy( fill, rev_start, sizeof( long ) * ( nb_nodes + 1 ) );
+	e = 0;
+	for( i = 0; i < Config.threads; i++ )
+	{
+		long k;
+		for( k = 0; k < Workers[ i ].nb_edges; k++, e++ )
+			if( targets[ e ] >= 0 )
+				rev[ fill[ targets[ e ] ]++ ] = Workers[ i ].edges[ k ].from;
+	}
+
+	long* queue = malloc( sizeof( long ) * ( nb_nodes + 1 ) );
+	long head = 0, tail = 0;
+
+	for( id = 0; id < nb_nodes; id++ )
+	{
+		const Node* node = &Nodes[ id ];
+		if( node->state < 0 )
+			continue;
+		if( node->state == STATE_WON || node->state == STATE_LOST || !node->expanded || alive[ id ] )
+		{
+			alive[ id ] = 1;
+			queue[ tail++ ] = id;
+		}
+	}
+	while( head < tail )
+	{
+		long v = queue[ head++ ];
+		long k;
+		for( k = rev_start[ v ]; k < rev_start[ v + 1 ]; k++ )
+		{
+			if( !alive[ rev[ k ] ] )
+			{
+				alive[ rev[ k ] ] = 1;
+				queue[ tail++ ] = rev[ k ];
+			}
+		}
+	}
+
+	long dead = 0, shortest_dead = -1;
+	long dead_areas[ 64 ] = { 0 };
+	for( id = 0; id < nb_nodes; id++ )
+	{
+		if( Nodes[ id ].state < 0 || alive[ id ] )
+			continue;
+		dead++;
+		if( shortest_dead < 0 )
+			shortest_dead = id;
+
+		if( restoreGameplay( root, Nodes[ id ].snap, Nodes[ id ].snap_size ) == 0 && root->area >= 0 && root->area < 64 )
+			dead_areas[ root->area ]++;
+	}
+
+	/* parcours incomplet : les résultats négatifs ne sont pas définitifs */
+	int partial = atomic_load( &Truncated ) || unexplored > 0;
+
+	fprintf( report, "states     %ld unique, %ld expanded, %ld transitions, depth %d%s\n",
+		unique, expanded, nb_edges, depth, atomic_load( &Truncated ) ? " (truncated: raise -n)" : "" );
+	if( partial )
+		fprintf( report, "partial    %s, %ld states not expanded: results below are partial\n",
+			atomic_load( &Truncated ) ? "states dropped (raise -n)" : "depth limit reached (raise -d)", unexplored );
+	fprintf( report, "time       %.3f s on %d threads (%.0f states/s, %.0f transitions/s)\n",
+		seconds, Config.threads, expanded / seconds, nb_edges / seconds );
+
+	static const char* CauseNames[ NB_END_CAUSES ] = {
+		[ END_NONE ] = "none",
+		[ END_KILLED ] = "killed",
+		[ END_PRINCE_KILLED ] = "prince killed",
+		[ END_APPLE ] = "apple",
+		[ END_DUKE_KILLED ] = "duke killed",
+		[ END_DUKE_POISONED ] = "duke poisoned"
+	};
+
+	fprintf( report, "terminal states\n" );
+	for( i = 0; i < NB_END_CAUSES; i++ )
+		if( causes[ i ] )
+			fprintf( report, "  %-14s %ld\n", CauseNames[ i ], causes[ i ] );
+
+	if( shortest_win >= 0 )
+	{
+		fprintf( report, "shortest win: %d inputs (%s)\n", Nodes[ shortest_win ].depth,
+			CauseNames[ Nodes[ shortest_win ].end_cause ] );
+		printPath( report, shortest_win );
+	}
+	else if( partial )
+		fprintf( report, "win        unknown: none reached in the explored states\n" );
+	else
+		fprintf( report, "no win reached\n" );
+
+	if( partial )
+		fprintf( report, "dead ends  at least %ld states from which no end of game is reachable (unknown beyond)\n",
+			dead );
+	else
+		fprintf( report, "dead ends  %ld states from which no end of game is reachable\n", dead );
+	for( i = 0; i < 64; i++ )
+		if( dead_areas[ i ] )
+			fprintf( report, "  area %-9d %ld\n", i, dead_areas[ i ] );
+	if( shortest_dead >= 0 )
+	{
+		fprintf( report, "shortest dead end: %d inputs\n", Nodes[ shortest_dead ].depth );
+		printPath( report, shortest_dead );
+	}
+
+	for( id = 0; id < nb_nodes; id++ )
+		free( Nodes[ id ].snap );
+	for( i = 0; i < Config.threads; i++ )
+	{
+		destroyGameplay( Workers[ i ].game );
+		free( Workers[ i ].edges );
+	}
+	free( Nodes );
+	free( ( void* )TableKeys );
+	free( TableNodes );
+	free( rev_start );
+	free( rev );
+	free( targets );
+	free( fill );
+	free( alive );
+	free( queue );
+	closeGameData();
+	logShutdown();
+	fclose( report );
+	return 0;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file ZoneCompiler.c
+ * Compilateur de zones `zonec` : convertit une zone du format texte
+ * `Data/ZoneN.txt` vers le format compilé `Data/ZoneN.bin` lu par
+ * @ref loadArea.\n
+ * Usage : `zonec Data/Zone1.txt Data/Zone1.bin`
+ */
+
+#include <stdio.h>
+
+#include "Zone.h"
+
+int main( int argc, char* argv[] )
+{
+	if( argc != 3 )
+	{
+		fprintf( stderr, "usage : %s zone.txt zone.bin\n", argv[ 0 ] );
+		return 2;
+	}
+
+	Zone zone;
+	if( zoneLoadText( &zone, argv[ 1 ] ) != 0 )
+	{
+		fprintf( stderr, "%s : invalid zone\n", argv[ 1 ] );
+		return 1;
+	}
+
+	if( zoneWriteBinary( &zone, argv[ 2 ] ) != 0 )
+	{
+		fprintf( stderr, "%s : write failed\n", argv[ 2 ] );
+		zoneClose( &zone );
+		return 1;
+	}
+
+	zoneClose( &zone );
+	return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file Ui.c
+ * Disposition de l'interface utilisateur. Chaque fois que l'état du jeu
+ * change, les boutons et les cases de l'inventaire de cet état sont
+ * rastérisés dans une carte de 800x600 identifiants ; un clic se résout
+ * ensuite en lisant la case de la carte sous la souris.
+ */
+#include "Ui.h"
+#include "Graphics.h"
+
+#include <string.h>
+
+/// Disposition courante de l'interface
+static UiLayout Layout;
+
+/**
+ * `fillRect` écrit l'identifiant `id` dans la carte sur le rectangle `rect`,
+ * bords droit et bas compris comme pour @ref intersects.
+ */
+static void fillRect( SDL_Rect rect, int id )
+{
+	int x0 = rect.x < 0 ? 0 : rect.x;
+	int y0 = rect.y < 0 ? 0 : rect.y;
+	int x1 = rect.x + rect.w >= UI_WIDTH ? UI_WIDTH - 1 : rect.x + rect.w;
+	int y1 = rect.y + rect.h >= UI_HEIGHT ? UI_HEIGHT - 1 : rect.y + rect.h;
+
+	int y;
+	for( y = y0; y <= y1 && x0 <= x1; y++ )
+		memset( &Layout.ids[ y ][ x0 ], id, x1 - x0 + 1 );
+}
+
+/**
+ * `uiLayout` rastérise les widgets actifs dans l'état `state` : les boutons
+ * du menu puis, dans l'inventaire, les cases des objets qui passent devant.
+ * Ne fait rien si la disposition de cet état est déjà construite.
+ * @param state L'état de jeu dont construire la disposition
+ */
+void uiLayout( int state )
+{
+	if( Layout.built && state == Layout.state )
+		return;
+
+	memset( Layout.ids, WIDGET_NONE, sizeof( Layout.ids ) );
+	Layout.built = 1;
+	Layout.state = state;
+
+	if( state < STATE_START || state > STATE_LOST )
+		return;
+
+	const SDL_Rect* rects = getButtonRects();
+	int i;
+
+	for( i = 0; i < 4; i++ )
+	{
+		if( StateActions[ state ][ i ] != -1 )
+			fillRect( rects[ i ], WIDGET_ACTION + StateActions[ state ][ i ] );
+	}
+
+	if( state == STATE_INVENTORY )
+	{
+		rects = getItemRects();
+		for( i = 0; i < MAX_ITEM; i++ )
+			fillRect( rects[ i ], WIDGET_SLOT + i );
+	}
+}
+
+/**
+ * `uiPick` renvoie l'identifiant du widget sous la souris dans la
+ * disposition courante.
+ * @param x Position horizontale de la souris
+ * @param y Position verticale de la souris
+ * @return L'identifiant du widget, @ref WIDGET_NONE si aucun
+ */
+int uiPick( int x, int y )
+{
+	if( x < 0 || y < 0 || x >= UI_WIDTH || y >= UI_HEIGHT )
+		return WIDGET_NONE;
+
+	return Layout.ids[ y ][ x ];
+}
+
+/**
+ * `uiInput` résout un clic en entrée du joueur pour l'état de jeu courant :
+ * le début de la partie, l'élément de la zone sous la souris en
+ * exploration (il passe avant le menu), un bouton ou une case de
+ * l'inventaire. L'entrée n'est pas appliquée, ce qui permet de
+ * l'enregistrer avant (voir @ref recorderInput).
+ * @param game La partie en cours
+ * @param x Position horizontale de la souris
+ * @param y Position verticale de la souris
+ * @param[out] input L'entrée résolue
+ * @return 1 si le clic donne une entrée, 0 sinon
+ */
+int uiInput( Gameplay_s* game, int x, int y, Input* input )
+{
+	if( game->state == STATE_START )
+	{
+		input->kind = INPUT_START;
+		input->value = 0;
+		return 1;
+	}
+
+	if( game->state == STATE_EXPLORATION )
+	{
+		int element = elementAt( game, x, y );
+		if( element >= 0 )
+		{
+			input->kind = INPUT_ELEMENT;
+			input->value = element;
+			return 1;
+		}
+	}
+
+	uiLayout( game->state );
+
+	int id = uiPick( x, y );
+
+	if( id >= WIDGET_SLOT )
+	{
+		input->kind = INPUT_SLOT;
+		input->value = id - WIDGET_SLOT;
+	}
+	else if( id >= WIDGET_ACTION )
+	{
+		input->kind = INPUT_ACTION;
+		input->value = id - WIDGET_ACTION;
+	}
+	else
+		return 0;
+
+	return 1;
+}
+
+/**
+ * `uiHover` lance en arrière-plan le décodage des images qu'un clic sous la
+ * souris afficherait : le fond des interactions au-dessus d'un élément de
+ * la zone, les images des objets du joueur au-dessus du bouton de
+ * l'inventaire (voir @ref warmImage). Rien n'est appliqué à la partie.
+ * @param game La partie en cours
+ * @param x Position horizontale de la souris
+ * @param y Position verticale de la souris
+ */
+void uiHover( Gameplay_s* game, int x, int y )
+{
+	if( game->state == STATE_EXPLORATION && elementAt( game, x, y ) >= 0 )
+	{
+		warmImage( Graphics.interaction_bg );
+		return;
+	}
+
+	if( game->state != STATE_EXPLORATION && game->state != STATE_INTERACTION )
+		return;
+
+	uiLayout( game->state );
+	if( uiPick( x, y ) == WIDGET_ACTION + ACTION_INVENTORY )
+		warmItems( game );
+}
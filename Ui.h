@@ -0,0 +1,47 @@
+/**
+ * @file Ui.h
+ * @brief Disposition de l'interface : carte des identifiants de widgets
+ * utilisée pour résoudre un clic en une seule lecture.
+ */
+#ifndef __UI_H__
+#define __UI_H__
+
+#include "Gameplay.h"
+
+/// Largeur de la carte des widgets (celle de la fenêtre)
+#define UI_WIDTH 800
+/// Hauteur de la carte des widgets (celle de la fenêtre)
+#define UI_HEIGHT 600
+
+/**
+ * Identifiants des widgets écrits dans la carte de l'interface
+ */
+enum {
+	WIDGET_NONE, ///< Aucun widget
+	WIDGET_ACTION, ///< `WIDGET_ACTION + action` : bouton déclenchant l'action du joueur `action`
+	WIDGET_SLOT = WIDGET_ACTION + ACTION_TALK_QUIT + 1, ///< `WIDGET_SLOT + i` : case `i` de l'inventaire
+	NB_WIDGETS = WIDGET_SLOT + MAX_ITEM ///< Nombre d'identifiants de widgets
+};
+
+/**
+ * @struct UiLayout
+ * @brief Disposition de l'interface pour un état de jeu, rastérisée pixel
+ * par pixel en identifiants de widgets.
+ */
+typedef struct
+{
+	int built; ///< Non nul si une disposition a été construite
+	int state; ///< État de jeu de la disposition courante
+	unsigned char ids[ UI_HEIGHT ][ UI_WIDTH ]; ///< Identifiant du widget de chaque pixel
+} UiLayout;
+
+/// @brief Construit la disposition de l'interface d'un état de jeu
+void uiLayout( int state );
+/// @brief Renvoie l'identifiant du widget sous la souris
+int uiPick( int x, int y );
+/// @brief Résout un clic en entrée du joueur
+int uiInput( Gameplay_s* game, int x, int y, Input* input );
+/// @brief Décode d'avance les images qu'un clic sous la souris afficherait
+void uiHover( Gameplay_s* game, int x, int y );
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file Zone.c
+ * Lecture et écriture des zones de jeu. Le format texte `Data/ZoneN.txt`
+ * contient une ligne par élément : `type sprite x y value value2`. Le format
+ * compilé `Data/ZoneN.bin`, produit par `zonec`, est projeté en mémoire et
+ * utilisé tel quel.
+ */
+#include "Zone.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * `zoneLoadText` lit une zone au format texte. Les noms de sprites sont
+ * dédupliqués dans une table des chaînes ; les tables sont regroupées dans
+ * un seul tampon, libéré par @ref zoneClose. Une ligne dont il manque
+ * l'identifiant unique reçoit la valeur 0. Une ligne mal formée ou un nom de
+ * sprite trop long fait échouer la lecture.
+ * @param zone La zone à remplir
+ * @param path Le chemin du fichier texte
+ * @return 0 en cas de succès, -1 sinon
+ */
+int zoneLoadText( Zone* zone, const char* path )
+{
+	memset( zone, 0, sizeof( *zone ) );
+
+	FILE* file = fopen( path, "r" );
+	if( !file )
+		return -1;
+
+	int cap = 16, n = 0, nb_sprites = 0, i;
+	ZoneElement* elems = malloc( sizeof( *elems ) * cap );
+	char ( *names )[ ZONE_NAME_MAX ] = malloc( sizeof( *names ) * ZONE_MAX_SPRITES );
+	int strings_size = 0;
+
+	char line[ 256 ];
+	while( fgets( line, sizeof( line ), file ) )
+	{
+		ZoneElement e;
+		char name[ ZONE_NAME_MAX ];
+
+		e.value2 = 0;
+		int r = sscanf( line, "%d %29s %d %d %d %d", &e.type, name, &e.x, &e.y, &e.value, &e.value2 );
+		if( r <= 0 )
+			continue;
+		if( r < 5 )
+			goto error;
+
+		for( e.sprite = 0; e.sprite < nb_sprites; e.sprite++ )
+		{
+			if( strcmp( names[ e.sprite ], name ) == 0 )
+				break;
+		}
+		if( e.sprite == nb_sprites )
+		{
+			if( nb_sprites == ZONE_MAX_SPRITES )
+				goto error;
+			strcpy( names[ nb_sprites++ ], name );
+			strings_size += strlen( name ) + 1;
+		}
+
+		if( n == cap )
+		{
+			cap *= 2;
+			elems = realloc( elems, sizeof( *elems ) * cap );
+		}
+		elems[ n++ ] = e;
+	}
+	fclose( file );
+
+	/* regroupement des tables dans un seul tampon */
+	size_t elems_size = sizeof( ZoneElement ) * n;
+	size_t sprites_size = sizeof( uint32_t ) * nb_sprites;
+	char* buffer = malloc( elems_size + sprites_size + strings_size + 1 );
+
+	ZoneElement* out_elems = ( ZoneElement* )buffer;
+	uint32_t* out_sprites = ( uint32_t* )( buffer + elems_size );
+	char* out_strings = buffer + elems_size + sprites_size;
+
+	memcpy( out_elems, elems, elems_size );
+
+	int offset = 0;
+	for( i = 0; i < nb_sprites; i++ )
+	{
+		out_sprites[ i ] = offset;
+		strcpy( out_strings + offset, names[ i ] );
+		offset += strlen( names[ i ] ) + 1;
+	}
+
+	free( elems );
+	free( names );
+
+	zone->nb_elements = n;
+	zone->elements = out_elems;
+	zone->nb_sprites = nb_sprites;
+	zone->sprites = out_sprites;
+	zone->strings = out_strings;
+	zone->owned = buffer;
+	return 0;
+
+error:
+	fclose( file );
+	free( elems );
+	free( names );
+	return -1;
+}
+
+/**
+ * `zoneStringsSize` renvoie la taille de la table des chaînes d'une zone,
+ * c'est à dire la fin du dernier nom de sprite.
+ */
+static uint32_t zoneStringsSize( const Zone* zone )
+{
+	uint32_t size = 0;
+	int i;
+	for( i = 0; i < zone->nb_sprites; i++ )
+	{
+		uint32_t end = zone->sprites[ i ] + strlen( zone->strings + zone->sprites[ i ] ) + 1;
+		if( end > size )
+			size = end;
+	}
+	return size;
+}
+
+/**
+ * `zoneLoadBinary` projette en mémoire une zone compilée. Seuls l'en-tête
+ * et les indices sont vérifiés : les tables sont utilisées directement dans
+ * la projection, sans copie ni allocation.
+ * @param zone La zone à remplir
+ * @param path Le chemin du fichier compilé
+ * @return 0 en cas de succès, -1 si le fichier est absent, d'une autre
+ * version ou invalide
+ */
+int zoneLoadBinary( Zone* zone, const char* path )
+{
+	memset( zone, 0, sizeof( *zone ) );
+
+	int fd = open( path, O_RDONLY );
+	if( fd < 0 )
+		return -1;
+
+	struct stat st;
+	if( fstat( fd, &st ) != 0 || ( size_t )st.st_size < sizeof( ZoneHeader ) )
+	{
+		close( fd );
+		return -1;
+	}
+
+	void* map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( map == MAP_FAILED )
+		return -1;
+
+	zone->map = map;
+	zone->map_size = st.st_size;
+
+	const ZoneHeader* header = map;
+	if( memcmp( header->magic, ZONE_MAGIC, 4 ) != 0 || header->version != ZONE_VERSION
+		|| header->nb_sprites > ZONE_MAX_SPRITES || header->strings_size == 0 )
+		goto error;
+
+	size_t elems_size = sizeof( ZoneElement ) * ( size_t )header->nb_elements;
+	size_t sprites_size = sizeof( uint32_t ) * ( size_t )header->nb_sprites;
+	if( sizeof( ZoneHeader ) + elems_size + sprites_size + header->strings_size != zone->map_size )
+		goto error;
+
+	const char* base = ( const char* )map + sizeof( ZoneHeader );
+	zone->nb_elements = header->nb_elements;
+	zone->elements = ( const ZoneElement* )base;
+	zone->nb_sprites = header->nb_sprites;
+	zone->sprites = ( const uint32_t* )( base + elems_size );
+	zone->strings = base + elems_size + sprites_size;
+
+	if( zone->strings[ header->strings_size - 1 ] != '\0' )
+		goto error;
+
+	int i;
+	for( i = 0; i < zone->nb_sprites; i++ )
+	{
+		if( zone->sprites[ i ] >= header->strings_size )
+			goto error;
+	}
+	for( i = 0; i < zone->nb_elements; i++ )
+	{
+		if( zone->elements[ i ].sprite < 0 || zone->elements[ i ].sprite >= zone->nb_sprites )
+			goto error;
+	}
+
+	return 0;
+
+error:
+	zoneClose( zone );
+	return -1;
+}
+
+/**
+ * `zoneWriteBinary` écrit une zone au format compilé.
+ * @param zone La zone à écrire
+ * @param path Le chemin du fichier à créer
+ * @return 0 en cas de succès, -1 sinon
+ */
+int zoneWriteBinary( const Zone* zone, const char* path )
+{
+	FILE* file = fopen( path, "wb" );
+	if( !file )
+		return -1;
+
+	ZoneHeader header;
+	memcpy( header.magic, ZONE_MAGIC, 4 );
+	header.version = ZONE_VERSION;
+	header.nb_elements = zone->nb_elements;
+	header.nb_sprites = zone->nb_sprites;
+	header.strings_size = zoneStringsSize( zone );
+
+	int ok = fwrite( &header, sizeof( header ), 1, file ) == 1
+		&& fwrite( zone->elements, sizeof( ZoneElement ), zone->nb_elements, file ) == ( size_t )zone->nb_elements
+		&& fwrite( zone->sprites, sizeof( uint32_t ), zone->nb_sprites, file ) == ( size_t )zone->nb_sprites
+		&& fwrite( zone->strings, 1, header.strings_size, file ) == header.strings_size;
+
+	if( fclose( file ) != 0 )
+		ok = 0;
+
+	return ok ? 0 : -1;
+}
+
+/**
+ * `zoneSprite` renvoie le nom d'un sprite de la zone, qui est aussi le nom
+ * de son image dans le dossier Img.
+ * @param zone La zone
+ * @param sprite L'indice du sprite
+ * @return Le nom du sprite
+ */
+const char* zoneSprite( const Zone* zone, int sprite )
+{
+	return zone->strings + zone->sprites[ sprite ];
+}
+
+/**
+ * `zoneClose` libère la projection ou le tampon d'une zone.
+ * @param zone La zone à libérer
+ */
+void zoneClose( Zone* zone )
+{
+	if( zone->map )
+		munmap( zone->map, zone->map_size );
+	free( zone->owned );
+	memset( zone, 0, sizeof( *zone ) );
+}
@@ -0,0 +1,80 @@
+/**
+ * @file Zone.h
+ * @brief Description d'une zone de jeu, lue depuis le format texte
+ * `Data/ZoneN.txt` ou depuis sa version compilée `Data/ZoneN.bin`.
+ */
+#ifndef __ZONE_H__
+#define __ZONE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Signature des fichiers de zone compilés
+#define ZONE_MAGIC "4AZN"
+/// Version du format de zone compilé
+#define ZONE_VERSION 1
+/// Taille maximale du nom d'un sprite, caractère nul compris
+#define ZONE_NAME_MAX 30
+/// Nombre maximal de sprites différents dans une zone
+#define ZONE_MAX_SPRITES 1024
+
+/**
+ * @struct ZoneHeader
+ * @brief En-tête d'un fichier de zone compilé. Le fichier contient ensuite
+ * la table des éléments, la table des sprites (décalages dans la table des
+ * chaînes) puis la table des chaînes. Les entiers sont dans l'ordre des
+ * octets de la machine qui a compilé la zone.
+ */
+typedef struct
+{
+	char magic[ 4 ]; ///< @ref ZONE_MAGIC
+	uint32_t version; ///< @ref ZONE_VERSION
+	uint32_t nb_elements; ///< Nombre d'éléments
+	uint32_t nb_sprites; ///< Nombre de sprites différents
+	uint32_t strings_size; ///< Taille de la table des chaînes
+} ZoneHeader;
+
+/**
+ * @struct ZoneElement
+ * @brief Élément d'une zone tel qu'il est stocké dans un fichier compilé
+ */
+typedef struct
+{
+	int32_t type; ///< 0 pour un NPC, 1 pour un passage vers une autre zone
+	int32_t sprite; ///< Indice du sprite dans la table des sprites
+	int32_t x, y; ///< Position de l'élément
+	int32_t value; ///< Type du NPC ou zone de destination
+	int32_t value2; ///< Identifiant unique du NPC
+} ZoneElement;
+
+/**
+ * @struct Zone
+ * @brief Zone chargée en mémoire. Les tables pointent soit dans le fichier
+ * compilé projeté en mémoire, soit dans des tampons alloués lors de la
+ * lecture du format texte.
+ */
+typedef struct
+{
+	int nb_elements; ///< Nombre d'éléments
+	const ZoneElement* elements; ///< Table des éléments
+	int nb_sprites; ///< Nombre de sprites
+	const uint32_t* sprites; ///< Décalage du nom de chaque sprite dans `strings`
+	const char* strings; ///< Table des chaînes
+
+	void* map; ///< Projection du fichier compilé, NULL pour le format texte
+	size_t map_size; ///< Taille de la projection
+	void* owned; ///< Tampon alloué par la lecture du format texte
+} Zone;
+
+/// @brief Lit une zone au format texte
+int zoneLoadText( Zone* zone, const char* path );
+/// @brief Projette en mémoire une zone compilée
+int zoneLoadBinary( Zone* zone, const char* path );
+/// @brief Écrit une zone au format compilé
+int zoneWriteBinary( const Zone* zone, const char* path );
+/// @brief Renvoie le nom d'un sprite de la zone
+const char* zoneSprite( const Zone* zone, int sprite );
+/// @brief Libère les ressources d'une zone
+void zoneClose( Zone* zone );
+
+#endif